@@ -1,4 +1,5 @@
 #include <uppaal/uppaal.h>
+#include <algorithm>
 #include <vector>
 
 // Initialize density matrix with binary state string
@@ -15,23 +16,47 @@ extern "C" void InitBinState(double* rho, int rho_size, const char* state) {
 // Apply single-qubit gate to target qubit
 extern "C" void ApplyGate(double* rho, int rho_size, int gate, int target) {
     size_t mat_row = 1 << rho_size;
-    size_t mat_size = mat_row * mat_row * 2;
     cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
                            mat_row, mat_row, false, true);
-    cx_mat res = dmqs::ApplyGate(in_mat, static_cast<u_gate>(gate), target);
-    memcpy(rho, res.memptr(), mat_size * sizeof(double));
+    dmqs::ApplyGateInPlace(in_mat, static_cast<u_gate>(gate), target);
 }
 
 // Apply controlled gate (control -> target)
 extern "C" void ApplyCGate(double* rho, int rho_size, int gate, int control,
                             int target) {
     size_t mat_row = 1 << rho_size;
-    size_t mat_size = mat_row * mat_row * 2;
     cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
                            mat_row, mat_row, false, true);
-    cx_mat res = dmqs::ApplyCGate(in_mat, static_cast<u_gate>(gate), control,
-                                  target);
-    memcpy(rho, res.memptr(), mat_size * sizeof(double));
+    dmqs::ApplyCGateInPlace(in_mat, static_cast<u_gate>(gate), control,
+                            target);
+}
+
+// Rotate target qubit theta degrees around axis (RX, RY or RZ)
+extern "C" void ApplyRotation(double* rho, int rho_size, int axis,
+                               double theta, int target) {
+    size_t mat_row = 1 << rho_size;
+    cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
+                           mat_row, mat_row, false, true);
+    dmqs::ApplyRotationInPlace(in_mat, static_cast<u_gate>(axis), theta,
+                               target);
+}
+
+// Rotate target qubit theta degrees around axis when control is |1⟩
+extern "C" void ApplyCRotation(double* rho, int rho_size, int axis,
+                                double theta, int control, int target) {
+    size_t mat_row = 1 << rho_size;
+    cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
+                           mat_row, mat_row, false, true);
+    dmqs::ApplyCRotationInPlace(in_mat, static_cast<u_gate>(axis), theta,
+                                control, target);
+}
+
+// Swap two qubits (basis permutation, no arithmetic)
+extern "C" void ApplySwap(double* rho, int rho_size, int q1, int q2) {
+    size_t mat_row = 1 << rho_size;
+    cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
+                           mat_row, mat_row, false, true);
+    dmqs::ApplySwapInPlace(in_mat, q1, q2);
 }
 
 // Apply custom unitary matrix U (u_size must equal rho_size)
@@ -87,16 +112,15 @@ extern "C" void BasisProjection(double* rho, int rho_size, int target,
 extern "C" void BasisProjections(double* rho, int rho_size, int* targets,
                                   int targets_size, int state) {
     size_t mat_row = 1 << rho_size;
-    size_t mat_size = mat_row * mat_row * 2;
     cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
                            mat_row, mat_row, false, true);
     vector<int> t = vector<int>(targets, targets + targets_size);
-    cx_mat res = dmqs::BasisProjections(in_mat, t, state);
-    memcpy(rho, res.memptr(), mat_size * sizeof(double));
+    dmqs::CollapseInPlace(in_mat, t, state);
 }
 
 // Measure target qubits and return result (does not collapse state)
-// Use UBasisProjections to collapse after measurement
+// Use BasisProjections to collapse after measurement, or MeasureAndCollapse
+// to do both in one call
 extern "C" int PartialMeasure(double* rho, int rho_size, int* targets,
                                int targets_size, double r) {
     size_t mat_row = 1 << rho_size;
@@ -106,6 +130,16 @@ extern "C" int PartialMeasure(double* rho, int rho_size, int* targets,
     return dmqs::PartialSample(in_mat, t, r);
 }
 
+// Measure target qubits, collapse rho onto the outcome and return it
+extern "C" int MeasureAndCollapse(double* rho, int rho_size, int* targets,
+                                   int targets_size, double r) {
+    size_t mat_row = 1 << rho_size;
+    cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
+                           mat_row, mat_row, false, true);
+    vector<int> t = vector<int>(targets, targets + targets_size);
+    return dmqs::MeasureAndCollapse(in_mat, t, r);
+}
+
 // Measure all qubits and return result (does not collapse state)
 extern "C" int MeasureAll(double* rho, int rho_size, double r) {
     size_t mat_row = 1 << rho_size;
@@ -114,6 +148,42 @@ extern "C" int MeasureAll(double* rho, int rho_size, double r) {
     return dmqs::Sample(in_mat, r);
 }
 
+// Measure all qubits shots times and store the count of every outcome in
+// counts (does not collapse state), counts_size = 1 << N
+extern "C" void MeasureAllShots(double* rho, int rho_size, int* counts,
+                                 int counts_size, int shots, int seed) {
+    if (counts_size != 1 << rho_size) {
+        throw invalid_argument(
+            "counts_size should be " + to_string(1 << rho_size) + ". Got " +
+            to_string(counts_size));
+    }
+    size_t mat_row = 1 << rho_size;
+    cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
+                           mat_row, mat_row, false, true);
+    vector<int> hist = dmqs::Histogram(
+        dmqs::SampleShots(in_mat, shots, seed), counts_size);
+    std::copy(hist.begin(), hist.end(), counts);
+}
+
+// Measure target qubits shots times and store the count of every outcome in
+// counts (does not collapse state), counts_size = 1 << targets_size
+extern "C" void PartialMeasureShots(double* rho, int rho_size, int* targets,
+                                     int targets_size, int* counts,
+                                     int counts_size, int shots, int seed) {
+    if (counts_size != 1 << targets_size) {
+        throw invalid_argument(
+            "counts_size should be " + to_string(1 << targets_size) +
+            ". Got " + to_string(counts_size));
+    }
+    size_t mat_row = 1 << rho_size;
+    cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
+                           mat_row, mat_row, false, true);
+    vector<int> t = vector<int>(targets, targets + targets_size);
+    vector<int> hist = dmqs::Histogram(
+        dmqs::PartialSampleShots(in_mat, t, shots, seed), counts_size);
+    std::copy(hist.begin(), hist.end(), counts);
+}
+
 // Measure all qubits and return result (does not collapse state)
 extern "C" void ResetQubit(double* rho, int rho_size, int qubit) {
     size_t mat_row = 1 << rho_size;
@@ -130,11 +200,37 @@ extern "C" void AmplitudeDampeningAndDephasing(double* rho, int rho_size,
                                                 const double* T1,
                                                 const double* T2, double t) {
     size_t mat_row = 1 << rho_size;
-    size_t mat_size = mat_row * mat_row * 2;
     cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
                            mat_row, mat_row, false, true);
-    cx_mat res = dmqs::ApplyAmplitudeDampeningAndDephasing(in_mat, T1, T2, t);
-    memcpy(rho, res.memptr(), mat_size * sizeof(double));
+    for (int q = 0; q < rho_size; q++) {
+        dmqs::ApplyAmplitudeDampeningAndDephasingInPlace(in_mat, q, T1[q],
+                                                         T2[q], t);
+    }
+}
+
+// Apply the amplitude damping and dephasing noise accumulated in pending
+// (idle time per qubit, kept by the model) to the target qubits as a single
+// channel per qubit and reset their pending time.
+extern "C" void FlushIdleNoise(double* rho, int rho_size, const double* T1,
+                                const double* T2, double* pending,
+                                int* targets, int targets_size) {
+    size_t mat_row = 1 << rho_size;
+    cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
+                           mat_row, mat_row, false, true);
+    for (int i = 0; i < targets_size; i++) {
+        int q = targets[i];
+        if (q < 0 || q >= rho_size) {
+            throw invalid_argument(
+                "Target " + to_string(q) + " is outside of a " +
+                to_string(rho_size) + " qubit system");
+        }
+        if (pending[q] == 0) {
+            continue;
+        }
+        dmqs::ApplyAmplitudeDampeningAndDephasingInPlace(in_mat, q, T1[q],
+                                                         T2[q], pending[q]);
+        pending[q] = 0;
+    }
 }
 
 // Apply a noise channel to the density matrix.
@@ -183,3 +279,253 @@ extern "C" void ApplyGAD(double* rho, int rho_size, double p, double g) {
     cx_mat res = apply_channel(in_mat, generalized_amplitude_damping_ops(p, g));
     memcpy(rho, res.memptr(), mat_size * sizeof(double));
 }
+
+// Purity tr(rho^2) of rho
+extern "C" double Purity(double* rho, int rho_size) {
+    size_t mat_row = 1 << rho_size;
+    cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
+                           mat_row, mat_row, false, true);
+    return dmqs::Purity(in_mat);
+}
+
+// Linear entropy 1 - tr(rho^2) of rho
+extern "C" double LinearEntropy(double* rho, int rho_size) {
+    size_t mat_row = 1 << rho_size;
+    cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
+                           mat_row, mat_row, false, true);
+    return dmqs::LinearEntropy(in_mat);
+}
+
+// Von Neumann entropy of rho in bits
+extern "C" double VonNeumannEntropy(double* rho, int rho_size) {
+    size_t mat_row = 1 << rho_size;
+    cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
+                           mat_row, mat_row, false, true);
+    return dmqs::VonNeumannEntropy(in_mat);
+}
+
+// Fidelity <psi|rho|psi> of rho with the pure state psi
+// psi holds 1 << psi_size interleaved complex amplitudes
+extern "C" double PureFidelity(double* rho, int rho_size, double* psi,
+                                int psi_size) {
+    size_t mat_row = 1 << rho_size;
+    cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
+                           mat_row, mat_row, false, true);
+    cx_vec in_vec = cx_vec(reinterpret_cast<cx_double*>(psi),
+                           size_t(1) << psi_size, false, true);
+    return dmqs::Fidelity(in_mat, in_vec);
+}
+
+// Uhlmann fidelity of rho and sigma (sigma_size must equal rho_size)
+extern "C" double Fidelity(double* rho, int rho_size, double* sigma,
+                            int sigma_size) {
+    size_t mat_row = 1 << rho_size;
+    size_t sigma_row = 1 << sigma_size;
+    cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
+                           mat_row, mat_row, false, true);
+    cx_mat in_sigma = cx_mat(reinterpret_cast<cx_double*>(sigma),
+                             sigma_row, sigma_row, false, true);
+    return dmqs::Fidelity(in_mat, in_sigma);
+}
+
+// Trace distance of rho and sigma (sigma_size must equal rho_size)
+extern "C" double TraceDistance(double* rho, int rho_size, double* sigma,
+                                 int sigma_size) {
+    size_t mat_row = 1 << rho_size;
+    size_t sigma_row = 1 << sigma_size;
+    cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
+                           mat_row, mat_row, false, true);
+    cx_mat in_sigma = cx_mat(reinterpret_cast<cx_double*>(sigma),
+                             sigma_row, sigma_row, false, true);
+    return dmqs::TraceDistance(in_mat, in_sigma);
+}
+
+// Run a whole OpenQASM 2 program on rho, see dmqs::ParseQasm for the
+// supported subset. Measurements draw from a random stream seeded with seed.
+// Returns the classical register with c[0] as the most significant bit, so
+// circuits with more than 31 classical bits are rejected.
+extern "C" int RunCircuit(double* rho, int rho_size, const char* source,
+                          int seed) {
+    size_t mat_row = 1 << rho_size;
+    cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
+                           mat_row, mat_row, false, true);
+    std::shared_ptr<const dmqs::Circuit> circuit =
+        dmqs::CompileQasm(string(source));
+    if (circuit->clbits > 31) {
+        throw invalid_argument(
+            "The classical register has " + to_string(circuit->clbits) +
+            " bits, at most 31 fit in the result");
+    }
+    dmqs::RandomStream rng(seed);
+    vector<int> clbits = dmqs::RunCircuit(in_mat, *circuit, rng);
+    int result = 0;
+    for (int bit : clbits) {
+        result = (result << 1) | bit;
+    }
+    return result;
+}
+
+// Checkpoint rho to a memory-mappable state file, see dmqs::SaveState
+extern "C" void SaveState(double* rho, int rho_size, const char* path) {
+    size_t mat_row = 1 << rho_size;
+    cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
+                           mat_row, mat_row, false, true);
+    dmqs::SaveState(string(path), in_mat);
+}
+
+// Restore rho from a state file of any layout and precision. The file must
+// hold rho_size qubits.
+extern "C" void LoadState(double* rho, int rho_size, const char* path) {
+    size_t mat_row = 1 << rho_size;
+    cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
+                           mat_row, mat_row, false, true);
+    dmqs::MappedState mapped(path);
+    if (mapped.Info().qubits != rho_size) {
+        throw invalid_argument(string(path) + " holds " +
+                               to_string(mapped.Info().qubits) +
+                               " qubits, expected " + to_string(rho_size));
+    }
+    in_mat = mapped.Load();
+}
+
+// State handles: the library owns the state and the model keeps one int.
+// The state stays a 2^n state vector until a non unitary operation needs
+// the density matrix, see dmqs::State. Handles are never 0.
+
+static dmqs::State& PoolState(int state) {
+    return dmqs::StatePool::Global().Get(state);
+}
+
+// Create an N qubit state from a binary state string of length N
+// (e.g., "01" or "+-"), an empty string starts in |0...0⟩
+extern "C" int CreateState(int n, const char* init) {
+    string bin = init == nullptr ? "" : init;
+    if (bin.empty()) {
+        bin = string(std::max(n, 0), '0');
+    }
+    if (n < 1 || size_t(n) != bin.length()) {
+        throw invalid_argument("Initial state " + bin + " does not have " +
+                               to_string(n) + " qubits");
+    }
+    return dmqs::StatePool::Global().Create(bin);
+}
+
+// Copy a state into a new handle
+extern "C" int CloneState(int state) {
+    return dmqs::StatePool::Global().Clone(state);
+}
+
+// Free a state, the handle must not be used afterwards
+extern "C" void DestroyState(int state) {
+    dmqs::StatePool::Global().Destroy(state);
+}
+
+extern "C" int StateQubits(int state) {
+    return PoolState(state).Qubits();
+}
+
+extern "C" void StateApplyGate(int state, int gate, int target) {
+    PoolState(state).ApplyGate(static_cast<u_gate>(gate), target);
+}
+
+extern "C" void StateApplyCGate(int state, int gate, int control,
+                                int target) {
+    PoolState(state).ApplyCGate(static_cast<u_gate>(gate), control, target);
+}
+
+extern "C" void StateApplyRotation(int state, int axis, double theta,
+                                   int target) {
+    PoolState(state).ApplyRotation(static_cast<u_gate>(axis), theta, target);
+}
+
+extern "C" void StateApplyCRotation(int state, int axis, double theta,
+                                    int control, int target) {
+    PoolState(state).ApplyCRotation(static_cast<u_gate>(axis), theta,
+                                    control, target);
+}
+
+extern "C" void StateApplySwap(int state, int q1, int q2) {
+    PoolState(state).ApplySwap(q1, q2);
+}
+
+// Apply a noise channel with probability prob to a single qubit
+extern "C" void StateApplyChannel(int state, int channel, double prob,
+                                  int qubit) {
+    channel_t chan_f = u_channel_to_ops_f(static_cast<u_channel>(channel));
+    PoolState(state).ApplyChannel(chan_f(prob), qubit);
+}
+
+extern "C" void StateResetQubit(int state, int qubit) {
+    PoolState(state).ApplyChannel(reset_ops(), qubit);
+}
+
+// Amplitude damping and dephasing of every qubit for time t
+extern "C" void StateAmplitudeDampeningAndDephasing(int state,
+                                                    const double* T1,
+                                                    const double* T2,
+                                                    double t) {
+    dmqs::State& s = PoolState(state);
+    for (int q = 0; q < s.Qubits(); q++) {
+        s.ApplyAmplitudeDampeningAndDephasing(q, T1[q], T2[q], t);
+    }
+}
+
+// Measure all qubits and return result (does not collapse state)
+extern "C" int StateMeasureAll(int state, double r) {
+    return dmqs::SampleOutcome(PoolState(state).Probabilities(), r);
+}
+
+// Measure target qubits and return result (does not collapse state)
+extern "C" int StatePartialMeasure(int state, int* targets, int targets_size,
+                                   double r) {
+    vector<int> t = vector<int>(targets, targets + targets_size);
+    return PoolState(state).PartialSample(t, r);
+}
+
+// Measure target qubits, collapse the state onto the outcome and return it
+extern "C" int StateMeasureAndCollapse(int state, int* targets,
+                                       int targets_size, double r) {
+    vector<int> t = vector<int>(targets, targets + targets_size);
+    return PoolState(state).MeasureAndCollapse(t, r);
+}
+
+// Copy the density matrix of a state into rho for the rho based functions
+extern "C" void StateReadDensityMatrix(int state, double* rho,
+                                       int rho_size) {
+    dmqs::State& s = PoolState(state);
+    if (s.Qubits() != rho_size) {
+        throw invalid_argument("State has " + to_string(s.Qubits()) +
+                               " qubits, rho has " + to_string(rho_size));
+    }
+    size_t mat_row = 1 << rho_size;
+    cx_mat in_mat = cx_mat(reinterpret_cast<cx_double*>(rho),
+                           mat_row, mat_row, false, true);
+    in_mat = s.DensityMatrix();
+}
+
+// Checkpoint a state to a state file, see dmqs::SaveState
+extern "C" void StateSave(int state, const char* path) {
+    dmqs::SaveState(string(path), PoolState(state).DensityMatrix());
+}
+
+// Load a state file into a new handle
+extern "C" int StateLoad(const char* path) {
+    return dmqs::StatePool::Global().Create(
+        dmqs::State(dmqs::LoadState(string(path))));
+}
+
+// Execution context of the calling thread. threads sets the library loops
+// and blas_threads the OpenBLAS products (0 keeps the current count), loops
+// over fewer than serial_threshold entries stay serial and the thread is
+// pinned to cpus when cpus_size > 0. Workers of an outer parallel loop
+// should pass 1, 1 so the inner kernels do not oversubscribe the machine.
+extern "C" void SetExecutionContext(int threads, int blas_threads,
+                                    int serial_threshold, int* cpus,
+                                    int cpus_size) {
+    dmqs::ExecutionContext context;
+    context.threads = threads;
+    context.blas_threads = blas_threads;
+    context.serial_threshold = serial_threshold;
+    context.cpus = vector<int>(cpus, cpus + std::max(cpus_size, 0));
+    dmqs::SetExecutionContext(context);
+}
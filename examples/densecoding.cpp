@@ -12,6 +12,7 @@ int main() {
     double p2 = exp(-t/T2);
     size_t size = 1 << (2*qc+1);
     double* test = reinterpret_cast<double*>(calloc(size, sizeof(double)));
+    dmqs::RandomStream rng(42);
     for (int i = 0; i < 1000000; i++) {
         InitBinState(test, qc, "100");
         ApplyGate(test, qc, GH, 0);
@@ -32,6 +33,6 @@ int main() {
         ApplyGate(test, qc, GH, 0);
         ApplyChannel(test, qc, AMPLITUDE_DAMPING, p1);
         ApplyChannel(test, qc, PHASE_DAMPING, p2);
-        MeasureAll(test, qc, rand() / RAND_MAX);
+        MeasureAll(test, qc, rng.Uniform());
     }
 }
@@ -0,0 +1,25 @@
+// Dense coding from examples/densecoding.cpp, with the amplitude and phase
+// damping of T1 = 20, T2 = 18 and t = 5 after every gate. Run with e.g.
+//   dmqs_run examples/densecoding.qasm 100 --repetitions 1000 --shots 1000
+OPENQASM 2.0;
+include "qelib1.inc";
+qreg q[3];
+
+h q[0];
+#pragma dmqs amplitude_damping(exp(-5/20)) q;
+#pragma dmqs phase_damping(exp(-5/18)) q;
+cx q[0], q[1];
+#pragma dmqs amplitude_damping(exp(-5/20)) q;
+#pragma dmqs phase_damping(exp(-5/18)) q;
+x q[0];
+#pragma dmqs amplitude_damping(exp(-5/20)) q;
+#pragma dmqs phase_damping(exp(-5/18)) q;
+z q[0];
+#pragma dmqs amplitude_damping(exp(-5/20)) q;
+#pragma dmqs phase_damping(exp(-5/18)) q;
+cx q[0], q[1];
+#pragma dmqs amplitude_damping(exp(-5/20)) q;
+#pragma dmqs phase_damping(exp(-5/18)) q;
+h q[0];
+#pragma dmqs amplitude_damping(exp(-5/20)) q;
+#pragma dmqs phase_damping(exp(-5/18)) q;
@@ -1,7 +1,12 @@
+#include <cstdlib>
 #include <iostream>
 #include <dmqs/dmqs.hpp>
 using dmqs::BinaryStringToDensityMatrix, dmqs::ApplyGate;
-int main() {
+int main(int argc, char** argv) {
+    // Pass a repair interval to let the kernels undo the drift as they go
+    if (argc > 1) {
+        dmqs::SetRepairPolicy({int64_t(std::atoll(argv[1])), 0});
+    }
     cx_mat result = BinaryStringToDensityMatrix("0");
     int loop_count = 1 << 10;
     std::cout << "Result: " << result << std::endl;
@@ -25,4 +30,9 @@ int main() {
             return 1;
         }
     }
+    const dmqs::RepairCounters& repairs = dmqs::Repairs();
+    std::cout << "Repairs: " << repairs.repairs << " of " << repairs.passes
+              << " passes, trace correction " << repairs.trace_correction
+              << ", hermiticity correction "
+              << repairs.hermiticity_correction << std::endl;
 }
@@ -0,0 +1,105 @@
+#pragma once
+#include <armadillo>
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dmqs/circuit.hpp>
+#include <dmqs/random.hpp>
+
+using std::vector, std::string;
+using arma::cx_mat;
+
+namespace dmqs {
+/// @brief Outcome of a queued measurement. Get blocks like a future, and
+///        the object can be awaited from a C++20 coroutine:
+///        int outcome = co_await queue.Measure({0});
+///        An awaiting coroutine is resumed on the executor thread of the
+///        queue, so it may enqueue further commands but must not block on
+///        the queue with Flush, Snapshot or Get.
+class Measurement {
+ public:
+    bool Ready() const;
+    int Get() const;
+    bool await_ready() const;
+    bool await_suspend(std::coroutine_handle<> continuation);
+    int await_resume() const;
+
+ private:
+    friend class CommandQueue;
+    struct Shared {
+        mutable std::mutex mutex;
+        std::condition_variable ready_cv;
+        bool ready = false;
+        int outcome = 0;
+        std::exception_ptr error;
+        std::coroutine_handle<> continuation;
+    };
+
+    explicit Measurement(std::shared_ptr<Shared> shared);
+    static void Resolve(Shared& shared, int outcome, std::exception_ptr error);
+
+    std::shared_ptr<Shared> shared_;
+};
+
+/// @brief Asynchronous front end of a density matrix. Gates and channels
+///        are enqueued without blocking and run in order on an executor
+///        thread. The executor takes everything queued since its last
+///        batch at once and runs the gates between two measurements
+///        through OptimizeCircuit, so the more the host queues ahead the
+///        more gets fused. Measurements draw from the queue's random
+///        stream and resolve their Measurement once the state collapsed.
+class CommandQueue {
+ public:
+    explicit CommandQueue(const cx_mat& rho, uint64_t seed = 0);
+    explicit CommandQueue(const string& bin, uint64_t seed = 0);
+    ~CommandQueue();
+    CommandQueue(const CommandQueue&) = delete;
+    CommandQueue& operator=(const CommandQueue&) = delete;
+    int Qubits() const;
+    void Enqueue(const Operation& op);
+    void ApplyGate(u_gate gate, int target);
+    void ApplyCGate(u_gate gate, int control, int target);
+    void ApplyRotation(u_gate axis, double theta, int target);
+    void ApplyCRotation(u_gate axis, double theta, int control, int target);
+    void ApplySwap(int q1, int q2);
+    void ApplyChannel(u_channel channel, double p, int qubit);
+    void Reset(int qubit);
+    Measurement Measure(const vector<int>& targets);
+    void Flush();
+    cx_mat Snapshot();
+    int64_t Batches() const;
+    OptimizationStats Stats() const;
+
+ private:
+    struct Command {
+        Operation op;
+        // Set for measurements, null for gates and channels
+        std::shared_ptr<Measurement::Shared> measurement;
+    };
+
+    void Push(Command command);
+    void Run();
+    void Execute(vector<Command>& batch);
+
+    int n_;
+    cx_mat rho_;
+    RandomStream rng_;
+    vector<Command> pending_;
+    bool busy_;
+    bool stopping_;
+    std::exception_ptr error_;
+    int64_t batches_;
+    OptimizationStats stats_;
+    mutable std::mutex mutex_;
+    std::condition_variable work_;
+    std::condition_variable idle_;
+    std::thread executor_;
+};
+} // namespace dmqs
@@ -0,0 +1,71 @@
+#pragma once
+#include <armadillo>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <dmqs/gates.hpp>
+#include <dmqs/channels.hpp>
+#include <dmqs/random.hpp>
+
+using std::vector, std::string;
+using arma::cx_mat, arma::vec, arma::uword;
+
+namespace dmqs {
+/// @brief Density matrix that is block diagonal in its classical qubits.
+///        A qubit is classical when every coherence between its |0⟩ and
+///        |1⟩ is exactly zero, as after a non selective measurement or
+///        phase_damping_ops(1). With m classical qubits only the 2^m
+///        diagonal blocks of 4^(n-m) entries are stored, one per classical
+///        configuration, and gates and channels run per block. Diagonal
+///        gates on a classical qubit are no-ops and bit flips relabel
+///        blocks; any other gate promotes the qubit back, merging its
+///        blocks, so with no classical qubits left this is the full
+///        density matrix.
+class BlockDiagonalState {
+ public:
+    explicit BlockDiagonalState(const string& bin);
+    explicit BlockDiagonalState(const char* bin);
+    explicit BlockDiagonalState(const cx_mat& rho);
+    int Qubits() const;
+    bool IsClassical(int qubit) const;
+    int ClassicalQubits() const;
+    uword StoredEntries() const;
+    int64_t Promotions() const;
+    int64_t Demotions() const;
+    cx_mat DensityMatrix() const;
+    vec Probabilities() const;
+    void ApplyGate(const cx_mat& U1, int target);
+    void ApplyGate(u_gate gate, int target);
+    void ApplyRotation(u_gate axis, double theta, int target);
+    void ApplyCGate(const cx_mat& U1, int control, int target);
+    void ApplyCGate(u_gate gate, int control, int target);
+    void ApplyCRotation(u_gate axis, double theta, int control, int target);
+    void ApplySwap(int q1, int q2);
+    void ApplyChannel(const vector<kraus_t>& ops, int qubit);
+    void Dephase(int qubit);
+    int MeasureAndCollapse(const vector<int>& targets, double random);
+    int MeasureAndCollapse(const vector<int>& targets, RandomStream& rng);
+    void Promote(int qubit);
+    bool TryDemote(int qubit);
+
+ private:
+    int ClassicalPosition(int qubit) const;
+    int QuantumPosition(int qubit) const;
+    uword BlockBit(uword block, int qubit) const;
+    arma::uvec FullIndices(uword block) const;
+    void CheckQubit(int qubit) const;
+    void Demote(int qubit);
+    void DemoteAll();
+    bool ApplyClassical(const cx_mat& U1, int target, int control);
+
+    int n_;
+    // Qubit indices in ascending order; block index bits follow classical_
+    // and local index bits follow quantum_, first qubit most significant
+    vector<int> classical_;
+    vector<int> quantum_;
+    vector<cx_mat> blocks_;
+    int64_t promotions_;
+    int64_t demotions_;
+};
+} // namespace dmqs
@@ -0,0 +1,49 @@
+#pragma once
+#include <armadillo>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <vector>
+
+using std::vector;
+using arma::cx_mat;
+
+namespace dmqs {
+/// @brief Cache of reduced density matrices keyed by their (sorted) target
+///        set. Every qubit carries a version counter that is bumped when an
+///        operation touches it, and an entry is only valid while the
+///        versions of its targets are unchanged. Gates and channels on other
+///        qubits leave a reduced state alone, even when they act on qubits
+///        entangled with it. A projective collapse does not: it bumps every
+///        qubit that has interacted with the measured ones, tracked by
+///        merging qubits into groups whenever an operation spans several.
+class ReducedStateCache {
+ public:
+    explicit ReducedStateCache(int n);
+    void Touch(const vector<int>& qubits);
+    void Collapse(const vector<int>& qubits);
+    void MergeAll();
+    void Invalidate();
+    const cx_mat& Get(const vector<int>& targets,
+                      const std::function<cx_mat(const vector<int>&)>& trace);
+    uint64_t Version(int qubit) const;
+    int64_t Hits() const;
+    int64_t Misses() const;
+
+ private:
+    struct Entry {
+        vector<uint64_t> versions;
+        cx_mat reduced;
+    };
+
+    int Group(int qubit) const;
+    void CheckQubit(int qubit) const;
+
+    vector<uint64_t> versions_;
+    vector<int> parent_;
+    std::map<vector<int>, Entry> entries_;
+    int64_t hits_;
+    int64_t misses_;
+};
+} // namespace dmqs
@@ -7,6 +7,7 @@
 #include <cassert>
 #include <vector>
 #include <dmqs/gates.hpp>
+#include <dmqs/kernels.hpp>
 
 using std::vector, std::begin, std::end;
 using arma::cx_mat, arma::cx_double, arma::fill::zeros, arma::fill::ones;
@@ -34,5 +35,11 @@ vector<kraus_t> reset_ops();
 cx_mat reset_qubit(const cx_mat& rho, int qubit);
 channel_t u_channel_to_ops_f(u_channel channel);
 cx_mat apply_channel(const cx_mat &rho, const vector<kraus_t> &kraus_ops);
+cx_mat apply_channel(const cx_mat &rho, const vector<kraus_t> &kraus_ops,
+                     int qubit);
+void apply_channel_in_place(cx_mat &rho, const vector<kraus_t> &kraus_ops,
+                            int qubit);
+superop1_t kraus_to_superop(const vector<kraus_t> &kraus_ops);
+superop1_t pauli_superop(double px, double py, double pz);
 vector<kraus_t> generalized_amplitude_damping_ops(const double& p,
                                             const double& gamma);
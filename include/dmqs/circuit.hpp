@@ -0,0 +1,62 @@
+#pragma once
+#include <armadillo>
+
+#include <cstdint>
+#include <vector>
+#include <dmqs/gates.hpp>
+#include <dmqs/channels.hpp>
+#include <dmqs/random.hpp>
+
+using std::vector;
+using arma::cx_mat;
+
+namespace dmqs {
+/// @brief Kind of a circuit operation.
+enum class OpKind {
+    GATE,       // u_gate on qubits[0]
+    CGATE,      // u_gate on qubits[1] controlled by qubits[0]
+    ROTATION,   // Rotation gate theta degrees around gate on qubits[0]
+    CROTATION,  // Controlled rotation, control qubits[0], target qubits[1]
+    SWAP,       // Swap of qubits[0] and qubits[1]
+    UNITARY,    // 1 qubit gate matrix on qubits[0]
+    CHANNEL,    // u_channel with probability param on qubits[0]
+    MEASURE,    // Measure qubits[0] into classical bit clbit
+    RESET,      // Reset qubits[0] to |0>
+    BARRIER,    // Keeps the optimizer from moving gates across qubits
+};
+
+/// @brief A single operation of a circuit. Fields that do not apply to the
+///        kind are left at their defaults.
+struct Operation {
+    OpKind kind = OpKind::GATE;
+    vector<int> qubits;
+    u_gate gate = GID;
+    u_channel channel = AMPLITUDE_DAMPING;
+    double param = 0;
+    int clbit = -1;
+    gate1_t matrix = gate1_t(arma::fill::eye);
+};
+
+/// @brief Circuit IR: the operations of a program on qubits qubits, with
+///        clbits classical bits for measurement results.
+struct Circuit {
+    int qubits = 0;
+    int clbits = 0;
+    vector<Operation> ops;
+};
+
+/// @brief What the optimizer removed from a circuit.
+struct OptimizationStats {
+    int64_t fused = 0;
+    int64_t cancelled = 0;
+};
+
+    bool IsSingleQubitUnitary(const Operation& op);
+    gate1_t OperationMatrix(const Operation& op);
+    Circuit OptimizeCircuit(const Circuit& circuit,
+                            OptimizationStats* stats = nullptr);
+    void ApplyOperationInPlace(cx_mat& rho, const Operation& op,
+                               vector<int>& clbits, RandomStream& rng);
+    vector<int> RunCircuit(cx_mat& rho, const Circuit& circuit,
+                           RandomStream& rng);
+} // namespace dmqs
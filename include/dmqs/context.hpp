@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+namespace dmqs {
+/// @brief How the library uses the machine on the calling thread. When
+///        simulations already run in parallel (UPPAAL, ensemble drivers)
+///        the inner loops and the BLAS calls should stay serial, otherwise
+///        every worker spawns its own threads and the machine is
+///        oversubscribed.
+struct ExecutionContext {
+    // OpenMP threads of the library loops, 0 keeps the current setting
+    int threads = 0;
+    // OpenBLAS threads inside Armadillo products, 0 keeps the current
+    // setting. OpenBLAS has a single process wide count, so the last
+    // context that sets it wins.
+    int blas_threads = 0;
+    // CPUs the calling thread is pinned to, empty keeps its affinity.
+    // Only applied on Linux.
+    vector<int> cpus;
+    // Loops over fewer than this many entries or shots stay on one thread
+    int64_t serial_threshold = 1 << 14;
+
+    static ExecutionContext Serial();
+};
+
+/// @brief Applies a context for the lifetime of the object and restores
+///        the previous one afterwards, for a single call or a block. The
+///        OpenBLAS count is process wide, so scopes that set blas_threads
+///        are counted and the count from before the first of them is only
+///        restored when the last one ends. While scopes overlap the most
+///        recently set count applies to all threads.
+class ScopedExecutionContext {
+ public:
+    explicit ScopedExecutionContext(const ExecutionContext& context);
+    ~ScopedExecutionContext();
+    ScopedExecutionContext(const ScopedExecutionContext&) = delete;
+    ScopedExecutionContext& operator=(const ScopedExecutionContext&) =
+        delete;
+
+ private:
+    ExecutionContext previous_;
+    int previous_threads_;
+    bool sets_blas_threads_;
+    vector<int> previous_cpus_;
+};
+
+    void SetExecutionContext(const ExecutionContext& context);
+    const ExecutionContext& CurrentExecutionContext();
+    int LibraryThreads();
+    int BlasThreads();
+    bool RunInParallel(int64_t work);
+} // namespace dmqs
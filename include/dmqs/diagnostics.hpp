@@ -0,0 +1,23 @@
+#pragma once
+#include <armadillo>
+
+#include <cstdint>
+
+using arma::cx_mat, arma::cx_vec, arma::vec;
+
+namespace dmqs {
+    /// @brief Eigenvalues (ascending) and eigenvectors of a Hermitian matrix.
+    struct Eigensystem {
+        vec values;
+        cx_mat vectors;
+    };
+
+    double Purity(const cx_mat& rho);
+    double LinearEntropy(const cx_mat& rho);
+    double Fidelity(const cx_mat& rho, const cx_vec& psi);
+    double Fidelity(const cx_mat& rho, const cx_mat& sigma);
+    double TraceDistance(const cx_mat& rho, const cx_mat& sigma);
+    double VonNeumannEntropy(const cx_mat& rho);
+    const Eigensystem& Eigendecomposition(const cx_mat& rho);
+    int64_t EigendecompositionCount();
+} // namespace dmqs
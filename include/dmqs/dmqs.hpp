@@ -7,6 +7,14 @@
 #include <complex>
 #include <cassert>
 #include <dmqs/gates.hpp>
+#include <dmqs/kernels.hpp>
+#include <dmqs/random.hpp>
+#include <dmqs/sampling.hpp>
+#include <dmqs/noise.hpp>
+#include <dmqs/lindblad.hpp>
+#include <dmqs/diagnostics.hpp>
+#include <dmqs/io.hpp>
+#include <dmqs/context.hpp>
 
 using std::vector, std::string, std::invalid_argument, std::to_string,
       std::max, std::min, std::greater, std::map, std::equal,
@@ -18,19 +26,52 @@ namespace dmqs {
     bool IsPure(const cx_mat& rho, double delta);
     cx_mat BinaryStringToDensityMatrix(const string& bin);
     cx_mat ApplyGateToDensityMatrix(const cx_mat& rho, const cx_mat& U);
+    cx_mat UGateToGate(u_gate gate);
     cx_mat ApplyGate(const cx_mat& rho, u_gate gate, int qubit);
     cx_mat ApplyCGate(const cx_mat& rho, u_gate gate, int control, int target);
+    void ApplyGateInPlace(cx_mat& rho, u_gate gate, int qubit);
+    void ApplyGateInPlace(cx_mat& rho, const cx_mat& U1, int qubit);
+    void ApplyCGateInPlace(cx_mat& rho, u_gate gate, int control,
+                           int target);
+    cx_mat ApplyRotation(const cx_mat& rho, u_gate axis, double theta,
+                         int target);
+    cx_mat ApplyCRotation(const cx_mat& rho, u_gate axis, double theta,
+                          int control, int target);
+    void ApplyRotationInPlace(cx_mat& rho, u_gate axis, double theta,
+                              int target);
+    void ApplyCRotationInPlace(cx_mat& rho, u_gate axis, double theta,
+                               int control, int target);
+    cx_mat ApplySwap(const cx_mat& rho, int q1, int q2);
+    void ApplySwapInPlace(cx_mat& rho, int q1, int q2);
     cx_mat GateToNQubitSystem(const cx_mat& U1, int target, int n);
     cx_mat ApplyAmplitudeDampeningAndDephasing(const cx_mat& rho,
                                                const double* T1,
                                                const double* T2, double t);
+    void ApplyAmplitudeDampeningAndDephasingInPlace(cx_mat& rho, int qubit,
+                                                    double T1, double T2,
+                                                    double t);
     cx_mat PartialTrace(const cx_mat& rho, const vector<int>& targets);
+    cx_mat ReleaseQubit(const cx_mat& rho, int qubit, int outcome = -1);
+    cx_mat AllocateQubit(const cx_mat& rho, int position);
     int Sample(const cx_mat& rho, double random);
+    int Sample(const cx_mat& rho, RandomStream& rng);
     int PartialSample(const cx_mat& rho, int target, double random);
     int PartialSample(const cx_mat& rho, const vector<int>& targets,
                       double random);
+    int PartialSample(const cx_mat& rho, const vector<int>& targets,
+                      RandomStream& rng);
     cx_mat BasisProjection(const cx_mat& rho, int target, int state);
     cx_mat BasisProjections(const cx_mat& rho, const vector<int>& targets,
                             int state);
+    void CollapseInPlace(cx_mat& rho, const vector<int>& targets, int state);
+    void CollapseInPlace(cx_vec& psi, const vector<int>& targets, int state);
+    int MeasureAndCollapse(cx_mat& rho, const vector<int>& targets,
+                           double random);
+    int MeasureAndCollapse(cx_vec& psi, const vector<int>& targets,
+                           double random);
+    int MeasureAndCollapse(cx_mat& rho, const vector<int>& targets,
+                           RandomStream& rng);
+    int MeasureAndCollapse(cx_vec& psi, const vector<int>& targets,
+                           RandomStream& rng);
     int rearrangeBits(int i, const vector<int>& a);
 } // namespace dmqs
@@ -0,0 +1,60 @@
+#pragma once
+#include <armadillo>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <dmqs/gates.hpp>
+#include <dmqs/channels.hpp>
+#include <dmqs/random.hpp>
+
+using std::vector, std::string;
+using arma::cx_mat;
+
+namespace dmqs {
+/// @brief Density matrix whose qubits come and go. Qubits are addressed by
+///        logical ids that stay fixed while the physical qubits of rho
+///        shift. A freshly allocated qubit is |0⟩ and unentangled, so it is
+///        only tensored into rho when the first operation touches it, and
+///        a released qubit is traced out (or projected) so rho shrinks 4x.
+///        Reset also hands the qubit back to the lazy |0⟩ form, so
+///        protocols that recycle ancillas keep a small working set.
+class DynamicState {
+ public:
+    DynamicState();
+    explicit DynamicState(const string& bin);
+    int AllocateQubit();
+    void ReleaseQubit(int qubit, int outcome = -1);
+    void Reset(int qubit);
+    bool IsAllocated(int qubit) const;
+    bool IsLive(int qubit) const;
+    int AllocatedQubits() const;
+    int LiveQubits() const;
+    int PeakLiveQubits() const;
+    const vector<int>& LiveOrder() const;
+    const cx_mat& DensityMatrix() const;
+    void ApplyGate(u_gate gate, int target);
+    void ApplyCGate(u_gate gate, int control, int target);
+    void ApplyRotation(u_gate axis, double theta, int target);
+    void ApplyCRotation(u_gate axis, double theta, int control, int target);
+    void ApplySwap(int q1, int q2);
+    void ApplyChannel(const vector<kraus_t>& ops, int qubit);
+    int Measure(int qubit, RandomStream& rng);
+
+ private:
+    static const int kLazy = -1;
+    static const int kReleased = -2;
+
+    int Physical(int qubit);
+    void CheckAllocated(int qubit) const;
+    void Drop(int qubit, int outcome);
+
+    // Physical index of every logical qubit, kLazy or kReleased
+    vector<int> physical_;
+    // Logical id of every physical qubit of rho_
+    vector<int> live_;
+    cx_mat rho_;
+    int allocated_;
+    int peak_;
+};
+} // namespace dmqs
@@ -16,6 +16,9 @@ enum u_gate {
   GH,
   GB0,
   GB1,
+  GRX,
+  GRY,
+  GRZ,
 };
 
 gate1_t X();
@@ -30,6 +33,8 @@ cx_mat Id(int n);
 cx_mat RX(double theta);
 cx_mat RY(double theta);
 cx_mat RZ(double theta);
+cx_mat P(double theta);
+gate1_t RotationGate(u_gate axis, double theta);
 cx_mat CG(const cx_mat& gate, int q1, int q2);
 cx_mat SWAP(int q1, int q2);
 
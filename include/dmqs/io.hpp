@@ -0,0 +1,76 @@
+#pragma once
+#include <armadillo>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+using std::string;
+using arma::cx_mat, arma::cx_double, arma::uword;
+
+namespace dmqs {
+/// @brief How the entries of rho are laid out in a state file.
+enum class StateLayout : uint32_t {
+    FULL = 0,    // All 4^n entries, column-major like cx_mat
+    PACKED = 1,  // Lower triangle column by column, rho is Hermitian
+    TILED = 2,   // tile x tile blocks, column-major by block and inside
+};
+
+/// @brief Precision of the stored entries.
+enum class StatePrecision : uint32_t {
+    DOUBLE = 64,  // complex<double>
+    FLOAT = 32,   // complex<float>
+};
+
+/// @brief Header of a state file. The payload starts at payload_offset,
+///        a multiple of kStatePayloadAlignment, so a mapping of the file
+///        can be used as the matrix memory directly.
+struct StateFileInfo {
+    uint32_t version;
+    int qubits;
+    StatePrecision precision;
+    StateLayout layout;
+    uint32_t tile;
+    uint64_t payload_offset;
+    uint64_t payload_bytes;
+    uint64_t checksum;
+};
+
+static const uint32_t kStateFileVersion = 1;
+static const uint64_t kStatePayloadAlignment = 4096;
+
+/// @brief Read only memory mapping of a state file. A FULL DOUBLE file is
+///        exposed as a cx_mat over the mapped pages without a copy, every
+///        layout can be read entry by entry with At. The mapping is
+///        private, so writes through Matrix() never reach the file.
+class MappedState {
+ public:
+    explicit MappedState(const string& path, bool verify = true);
+    ~MappedState();
+    MappedState(const MappedState&) = delete;
+    MappedState& operator=(const MappedState&) = delete;
+    MappedState(MappedState&& other) noexcept;
+    MappedState& operator=(MappedState&& other) noexcept;
+    const StateFileInfo& Info() const;
+    uword Dimension() const;
+    cx_double At(uword row, uword col) const;
+    cx_mat& Matrix();
+    cx_mat Load() const;
+
+ private:
+    void Unmap();
+
+    StateFileInfo info_;
+    void* data_;
+    size_t size_;
+    // Heap allocated so moves keep it pointing into the same mapping
+    std::unique_ptr<cx_mat> view_;
+};
+
+    void SaveState(const string& path, const cx_mat& rho,
+                   StateLayout layout = StateLayout::FULL,
+                   StatePrecision precision = StatePrecision::DOUBLE,
+                   uint32_t tile = 64);
+    cx_mat LoadState(const string& path, bool verify = true);
+    StateFileInfo ReadStateInfo(const string& path);
+} // namespace dmqs
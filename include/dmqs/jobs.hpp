@@ -0,0 +1,102 @@
+#pragma once
+#include <armadillo>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dmqs/circuit.hpp>
+
+using std::vector, std::string;
+using arma::cx_mat, arma::vec;
+
+namespace dmqs {
+/// @brief An independent simulation: run circuit on the product state
+///        initial (BinaryStringToDensityMatrix syntax) and sample the final
+///        state shots times. The circuit is shared read-only between jobs,
+///        e.g. the result of CompileQasm.
+struct Job {
+    string initial;
+    std::shared_ptr<const Circuit> circuit;
+    int shots = 0;
+};
+
+/// @brief Outcome of a job. id is the value Submit returned or reported.
+struct JobResult {
+    uint64_t id = 0;
+    // Classical register after the circuit
+    vector<int> clbits;
+    // Final outcome probabilities
+    vec probabilities;
+    // Histogram of the shots over the 2^n outcomes, empty without shots
+    vector<int> counts;
+    // Failure message for jobs collected from the completion queue
+    string error;
+};
+
+/// @brief Work-stealing pool for many small simulations of uneven length.
+///        Every worker owns a deque of jobs, takes its newest job first and
+///        steals the oldest job of another worker when it runs dry. Workers
+///        reuse their own density matrix arena between jobs and run with
+///        ExecutionContext::Serial() while the pool lives, so the kernels
+///        do not spawn threads of their own. Job id draws from streams
+///        2 id and 2 id + 1 of the pool seed for its measurements and its
+///        shots, so results do not depend on which worker ran the job.
+class JobPool {
+ public:
+    explicit JobPool(int workers = 0, uint64_t seed = 0);
+    ~JobPool();
+    JobPool(const JobPool&) = delete;
+    JobPool& operator=(const JobPool&) = delete;
+    std::future<JobResult> Submit(Job job);
+    uint64_t Enqueue(Job job);
+    bool NextCompleted(JobResult& result);
+    bool TryNextCompleted(JobResult& result);
+    void Wait();
+    int Workers() const;
+    int64_t Steals() const;
+    int64_t Completed() const;
+
+ private:
+    struct Task {
+        uint64_t id;
+        Job job;
+        // Null for jobs whose result goes to the completion queue
+        std::shared_ptr<std::promise<JobResult>> promise;
+    };
+
+    struct Worker {
+        std::deque<Task> tasks;
+        std::mutex mutex;
+        cx_mat arena;
+        std::thread thread;
+    };
+
+    uint64_t Push(Job job, std::shared_ptr<std::promise<JobResult>> promise);
+    bool Pop(int index, Task& task);
+    void Run(int index);
+    JobResult Execute(const Task& task, cx_mat& arena) const;
+    void Finish(Task& task, cx_mat& arena);
+
+    uint64_t seed_;
+    vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<uint64_t> next_id_;
+    std::atomic<uint64_t> next_worker_;
+    std::atomic<int64_t> queued_;
+    std::atomic<int64_t> steals_;
+    std::atomic<int64_t> completed_;
+    int64_t outstanding_;
+    int64_t queue_outstanding_;
+    bool stopping_;
+    std::mutex mutex_;
+    std::condition_variable work_;
+    std::condition_variable done_;
+    std::deque<JobResult> completed_results_;
+};
+} // namespace dmqs
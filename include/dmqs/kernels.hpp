@@ -0,0 +1,73 @@
+#pragma once
+#include <armadillo>
+
+#include <cstdint>
+#include <vector>
+#include <dmqs/gates.hpp>
+
+using std::vector;
+using arma::cx_mat, arma::cx_vec, arma::cx_double, arma::uword;
+using arma::mat;
+
+// Superoperator of a 1 qubit channel acting on the column-major vectorized
+// 2x2 block [b00, b10, b01, b11]. For Kraus operators K: sum conj(K) ⊗ K.
+typedef cx_mat::fixed<4, 4> superop1_t;
+typedef mat::fixed<4, 4> real_superop1_t;
+
+namespace dmqs {
+    /// @brief When the dense kernels repair floating point drift of rho,
+    ///        rescaling its trace to 1 and dropping its anti-Hermitian part
+    ///        in the same pass that applies the gate or channel.
+    struct RepairPolicy {
+        // Repair every interval kernel passes, 0 to disable
+        int64_t interval = 0;
+        // Repair whenever |tr(rho) - 1| exceeds threshold, 0 to disable
+        double threshold = 0;
+    };
+
+    /// @brief Counts of the repairs made by the kernels.
+    struct RepairCounters {
+        int64_t passes = 0;
+        int64_t repairs = 0;
+        // Sum of |1 - scale| over the trace rescalings
+        double trace_correction = 0;
+        // Sum of the Frobenius norms of the removed anti-Hermitian parts
+        double hermiticity_correction = 0;
+    };
+
+    void SetRepairPolicy(const RepairPolicy& policy);
+    const RepairPolicy& CurrentRepairPolicy();
+    const RepairCounters& Repairs();
+    void ResetRepairs();
+    uword InsertBit(uword k, uword mask, uword value);
+    bool IsDiagonal(const cx_mat& U);
+    cx_vec GateDiagonal(const cx_mat& U1, int target, int n);
+    cx_vec CGateDiagonal(const cx_mat& U1, int control, int target, int n);
+    void ApplyDiagonalInPlace(cx_mat& rho, const cx_vec& phases);
+    cx_mat ApplyDiagonal(const cx_mat& rho, const cx_vec& phases);
+    bool IsPermutation(const cx_mat& U, vector<uword>& perm);
+    vector<uword> XPermutation(int target, int n);
+    vector<uword> CXPermutation(const vector<int>& controls, int target,
+                                int n);
+    vector<uword> SwapPermutation(int q1, int q2, int n);
+    void ApplyPermutationInPlace(cx_mat& rho, const vector<uword>& perm);
+    cx_mat ApplyPermutation(const cx_mat& rho, const vector<uword>& perm);
+    void ApplyGate1InPlace(cx_mat& rho, const cx_mat& U1, int target);
+    void ApplyCGate1InPlace(cx_mat& rho, const cx_mat& U1, int control,
+                            int target);
+    void ApplySuperop1InPlace(cx_mat& rho, const superop1_t& S, int target);
+    void ApplyGate1InPlace(mat& rho, const mat& U1, int target);
+    void ApplyCGate1InPlace(mat& rho, const mat& U1, int control,
+                            int target);
+    void ApplySuperop1InPlace(mat& rho, const real_superop1_t& S,
+                              int target);
+    void ApplyGate1ToVectorInPlace(cx_vec& psi, const cx_mat& U1, int target);
+    void ApplyCGate1ToVectorInPlace(cx_vec& psi, const cx_mat& U1,
+                                    int control, int target);
+    void ApplyPermutationToVectorInPlace(cx_vec& psi,
+                                         const vector<uword>& perm);
+    void ApplyGate1ToColumnsInPlace(cx_mat& A, const cx_mat& U1, int target);
+    void ApplyCGate1ToColumnsInPlace(cx_mat& A, const cx_mat& U1,
+                                     int control, int target);
+    void ApplyPermutationToRowsInPlace(cx_mat& A, const vector<uword>& perm);
+} // namespace dmqs
@@ -0,0 +1,44 @@
+#pragma once
+#include <armadillo>
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+using std::vector;
+using arma::cx_mat;
+
+namespace dmqs {
+/// @brief Lindblad master equation
+///        d rho/dt = -i[H, rho] + sum_k L_k rho L_k† - 1/2 {L_k† L_k, rho}
+///        for a time independent Hamiltonian and collapse operators acting
+///        on the whole system. Up to kExactQubitLimit qubits the evolution
+///        uses the exact propagator exp(L dt), cached per dt, above it an
+///        adaptive Dormand-Prince (RK45) integrator.
+class Lindbladian {
+ public:
+    static constexpr int kExactQubitLimit = 4;
+
+    Lindbladian(const cx_mat& H, const vector<cx_mat>& collapse_ops,
+                double tolerance = 1e-10);
+    cx_mat Derivative(const cx_mat& rho) const;
+    cx_mat Superoperator() const;
+    const cx_mat& Propagator(double dt);
+    void IntegrateInPlace(cx_mat& rho, double t) const;
+    void EvolveInPlace(cx_mat& rho, double t);
+    cx_mat Evolve(const cx_mat& rho, double t);
+    size_t CachedPropagators() const;
+
+ private:
+    void CheckState(const cx_mat& rho) const;
+
+    cx_mat H_;
+    vector<cx_mat> L_;
+    cx_mat Heff_;
+    double tolerance_;
+    std::map<double, cx_mat> propagators_;
+};
+
+Lindbladian AmplitudeDampingAndDephasingLindbladian(const vector<double>& T1,
+                                                    const vector<double>& T2);
+} // namespace dmqs
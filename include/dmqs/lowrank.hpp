@@ -0,0 +1,55 @@
+#pragma once
+#include <armadillo>
+
+#include <string>
+#include <vector>
+#include <dmqs/gates.hpp>
+#include <dmqs/channels.hpp>
+#include <dmqs/random.hpp>
+
+using std::vector, std::string;
+using arma::cx_mat, arma::vec, arma::uword;
+
+namespace dmqs {
+/// @brief Density matrix stored as rho = L L† with L of size 2^n x rank.
+///        Gates act on L directly, Kraus channels stack K L for every
+///        operator and recompress through a truncated SVD. Singular values
+///        are dropped while the discarded weight stays within tolerance
+///        (relative to the trace) and the rank is capped at max_rank.
+class LowRankState {
+ public:
+    explicit LowRankState(const string& bin, double tolerance = 1e-12,
+                          uword max_rank = 64);
+    explicit LowRankState(const char* bin, double tolerance = 1e-12,
+                          uword max_rank = 64);
+    explicit LowRankState(const cx_mat& rho, double tolerance = 1e-12,
+                          uword max_rank = 64);
+    int Qubits() const;
+    uword Rank() const;
+    const cx_mat& Factor() const;
+    cx_mat DensityMatrix() const;
+    double TruncationError() const;
+    vec Probabilities() const;
+    cx_mat PartialTrace(const vector<int>& targets) const;
+    void ApplyGate(const cx_mat& U1, int target);
+    void ApplyGate(u_gate gate, int target);
+    void ApplyCGate(u_gate gate, int control, int target);
+    void ApplyRotation(u_gate axis, double theta, int target);
+    void ApplyCRotation(u_gate axis, double theta, int control, int target);
+    void ApplySwap(int q1, int q2);
+    void ApplyChannel(const vector<kraus_t>& ops, int qubit);
+    int Sample(double random) const;
+    int Sample(RandomStream& rng) const;
+    int MeasureAndCollapse(const vector<int>& targets, double random);
+    int MeasureAndCollapse(const vector<int>& targets, RandomStream& rng);
+
+ private:
+    void Recompress();
+
+    int n_;
+    double tolerance_;
+    uword max_rank_;
+    double truncation_error_;
+    cx_mat L_;
+};
+} // namespace dmqs
@@ -0,0 +1,60 @@
+#pragma once
+#include <armadillo>
+
+#include <string>
+#include <vector>
+#include <dmqs/gates.hpp>
+#include <dmqs/channels.hpp>
+#include <dmqs/random.hpp>
+
+using std::vector, std::string;
+using arma::cx_mat, arma::cx_cube, arma::uword;
+
+namespace dmqs {
+/// @brief Matrix product density operator for chains of qubits with limited
+///        entanglement. Site i holds a Dl x Dr x 4 cube whose slice
+///        p = row + 2 col is the matrix of the local operator |row><col|, so
+///        rho = sum A_0[p_0] A_1[p_1] ... A_n-1[p_n-1]. One qubit gates and
+///        channels act on a single site, nearest neighbour gates contract two
+///        sites and split them again with a truncated SVD, keeping at most
+///        max_bond singular values above cutoff times the largest one.
+///        Gates between distant qubits are routed with adjacent SWAPs.
+class MPDO {
+ public:
+    explicit MPDO(const string& bin, uword max_bond = 64,
+                  double cutoff = 1e-12);
+    int Qubits() const;
+    uword BondDimension(int bond) const;
+    uword MaxBondDimension() const;
+    double TruncationError() const;
+    double Trace() const;
+    cx_mat PartialTrace(const vector<int>& targets) const;
+    cx_mat DensityMatrix() const;
+    void ApplyGate(const cx_mat& U1, int target);
+    void ApplyGate(u_gate gate, int target);
+    void ApplyRotation(u_gate axis, double theta, int target);
+    void ApplyCGate(const cx_mat& U1, int control, int target);
+    void ApplyCGate(u_gate gate, int control, int target);
+    void ApplyCRotation(u_gate axis, double theta, int control, int target);
+    void ApplySwap(int q1, int q2);
+    void ApplyChannel(const vector<kraus_t>& ops, int qubit);
+    vector<int> Sample(double random) const;
+    vector<int> Sample(RandomStream& rng) const;
+    int PartialSample(const vector<int>& targets, double random) const;
+    int PartialSample(const vector<int>& targets, RandomStream& rng) const;
+    int MeasureAndCollapse(const vector<int>& targets, double random);
+    int MeasureAndCollapse(const vector<int>& targets, RandomStream& rng);
+
+ private:
+    void CheckQubit(int qubit) const;
+    cx_mat SiteTrace(int site) const;
+    void ApplySite(const superop1_t& S, int site);
+    void ApplyBond(const cx_mat& U2, int site);
+
+    int n_;
+    uword max_bond_;
+    double cutoff_;
+    double truncation_error_;
+    vector<cx_cube> sites_;
+};
+} // namespace dmqs
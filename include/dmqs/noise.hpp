@@ -0,0 +1,67 @@
+#pragma once
+#include <armadillo>
+
+#include <cstdint>
+#include <vector>
+#include <dmqs/gates.hpp>
+#include <dmqs/channels.hpp>
+
+using std::vector;
+using arma::cx_mat, arma::vec;
+
+namespace dmqs {
+/// @brief Lazy idle noise scheduler. Idle time is recorded per qubit and the
+///        amplitude dampening and dephasing channel is only applied, once for
+///        the whole accumulated time, when an operation touches the qubit.
+///        Used directly, Flush has to be called with the qubits of every
+///        gate, measurement or trace before running it; NoisyState does
+///        that itself.
+class IdleNoise {
+ public:
+    IdleNoise(const vector<double>& T1, const vector<double>& T2);
+    void Idle(double t);
+    void Idle(int qubit, double t);
+    double Pending(int qubit) const;
+    void Flush(cx_mat& rho, const vector<int>& qubits);
+    void FlushAll(cx_mat& rho);
+    int64_t ChannelApplications() const;
+
+ private:
+    void CheckQubit(int qubit) const;
+
+    vector<double> T1_;
+    vector<double> T2_;
+    vector<double> pending_;
+    int64_t applications_;
+};
+
+/// @brief Density matrix with lazy idle noise. Every operation first flushes
+///        the pending noise of the qubits it touches, so the noise can not
+///        be forgotten. Reading the reduced state or measuring a subset
+///        only flushes that subset, since channels on the other qubits do
+///        not change it.
+class NoisyState {
+ public:
+    NoisyState(const cx_mat& rho, const vector<double>& T1,
+               const vector<double>& T2);
+    int Qubits() const;
+    void Idle(double t);
+    void Idle(int qubit, double t);
+    const IdleNoise& Noise() const;
+    const cx_mat& DensityMatrix();
+    vec Probabilities();
+    cx_mat PartialTrace(const vector<int>& targets);
+    void ApplyGate(u_gate gate, int target);
+    void ApplyGate(const cx_mat& U1, int target);
+    void ApplyCGate(u_gate gate, int control, int target);
+    void ApplyRotation(u_gate axis, double theta, int target);
+    void ApplyCRotation(u_gate axis, double theta, int control, int target);
+    void ApplySwap(int q1, int q2);
+    void ApplyChannel(const vector<kraus_t>& ops, int qubit);
+    int MeasureAndCollapse(const vector<int>& targets, double random);
+
+ private:
+    cx_mat rho_;
+    IdleNoise noise_;
+};
+} // namespace dmqs
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <dmqs/state.hpp>
+
+using std::vector, std::string;
+
+namespace dmqs {
+/// @brief Library owned states addressed by integer handles, so bindings
+///        such as UPPAAL carry one int instead of the whole density matrix.
+///        A handle packs a slot index with the generation of that slot, so
+///        a handle that outlives Destroy is rejected instead of silently
+///        addressing whichever state reuses the slot. Creating and
+///        destroying handles is thread safe; a single state must not be
+///        used from two threads at once.
+class StatePool {
+ public:
+    StatePool() = default;
+    StatePool(const StatePool&) = delete;
+    StatePool& operator=(const StatePool&) = delete;
+    int Create(const string& bin);
+    int Create(State state);
+    int Clone(int handle);
+    void Destroy(int handle);
+    State& Get(int handle);
+    bool Contains(int handle) const;
+    size_t Size() const;
+    void Clear();
+    static StatePool& Global();
+
+ private:
+    struct Slot {
+        std::unique_ptr<State> state;
+        uint32_t generation = 0;
+    };
+
+    int Insert(std::unique_ptr<State> state);
+    Slot& Find(int handle);
+
+    vector<Slot> slots_;
+    vector<int> free_;
+    size_t size_ = 0;
+    mutable std::mutex mutex_;
+};
+} // namespace dmqs
@@ -0,0 +1,21 @@
+#pragma once
+#include <armadillo>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <dmqs/circuit.hpp>
+
+using std::vector, std::string;
+using arma::cx_mat;
+
+namespace dmqs {
+    Circuit ParseQasm(const string& source);
+    std::shared_ptr<const Circuit> CompileQasm(const string& source);
+    vector<int> RunCircuit(cx_mat& rho, const string& source,
+                           RandomStream& rng);
+    int64_t QasmCacheHits();
+    int64_t QasmCacheMisses();
+    void ClearQasmCache();
+} // namespace dmqs
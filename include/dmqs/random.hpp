@@ -0,0 +1,43 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace dmqs {
+/// @brief Counter based random number generator (Philox4x32-10). Every
+///        output block is a pure function of (seed, stream, block index),
+///        so independent streams need no shared state and any block can be
+///        recomputed without replaying the ones before it. Giving every
+///        shot or trajectory of a parallel ensemble its own stream, or its
+///        own block index, keeps the run reproducible for any thread count.
+///        Satisfies UniformRandomBitGenerator, so it works with the
+///        standard distributions.
+class RandomStream {
+ public:
+    typedef uint64_t result_type;
+    typedef std::array<uint32_t, 4> block_t;
+
+    explicit RandomStream(uint64_t seed, uint64_t stream = 0);
+    static block_t Philox4x32(const block_t& counter,
+                              const std::array<uint32_t, 2>& key);
+    block_t Block(uint64_t index) const;
+    double Uniform(uint64_t index, int half) const;
+    double Uniform();
+    result_type operator()();
+    void Seek(uint64_t index);
+    uint64_t Position() const;
+    uint64_t Seed() const;
+    uint64_t Stream() const;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() {
+        return std::numeric_limits<result_type>::max();
+    }
+
+ private:
+    uint64_t seed_;
+    uint64_t stream_;
+    uint64_t index_;
+    block_t block_;
+    int used_;
+};
+} // namespace dmqs
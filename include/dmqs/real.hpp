@@ -0,0 +1,51 @@
+#pragma once
+#include <armadillo>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <dmqs/gates.hpp>
+#include <dmqs/channels.hpp>
+#include <dmqs/random.hpp>
+
+using std::vector, std::string;
+using arma::cx_mat, arma::mat, arma::vec;
+
+namespace dmqs {
+/// @brief Density matrix kept in real doubles while it is real, which halves
+///        the memory and cuts the flops of every pass. Gates and channels
+///        whose superoperator is real (H, X, Y, Z, CX, CZ, RY, damping,
+///        flips and depolarizing) keep it real; the first operation with a
+///        complex superoperator, e.g RX or RZ, promotes it to a complex
+///        density matrix for the rest of the run.
+class RealState {
+ public:
+    explicit RealState(const string& bin);
+    explicit RealState(const char* bin);
+    explicit RealState(const cx_mat& rho);
+    int Qubits() const;
+    bool IsReal() const;
+    const mat& RealMatrix() const;
+    cx_mat DensityMatrix() const;
+    vec Probabilities() const;
+    void ApplyGate(const cx_mat& U1, int target);
+    void ApplyGate(u_gate gate, int target);
+    void ApplyCGate(const cx_mat& U1, int control, int target);
+    void ApplyCGate(u_gate gate, int control, int target);
+    void ApplyRotation(u_gate axis, double theta, int target);
+    void ApplyCRotation(u_gate axis, double theta, int control, int target);
+    void ApplySwap(int q1, int q2);
+    void ApplyChannel(const vector<kraus_t>& ops, int qubit);
+    int MeasureAndCollapse(const vector<int>& targets, double random);
+    int MeasureAndCollapse(const vector<int>& targets, RandomStream& rng);
+    void Complexify();
+    int64_t RealOperations() const;
+
+ private:
+    int n_;
+    mat real_;
+    cx_mat rho_;
+    bool is_real_;
+    int64_t real_operations_;
+};
+} // namespace dmqs
@@ -0,0 +1,35 @@
+#pragma once
+#include <armadillo>
+
+#include <cstdint>
+#include <vector>
+#include <dmqs/random.hpp>
+
+using std::vector;
+using arma::cx_mat, arma::vec, arma::uvec, arma::uword;
+
+namespace dmqs {
+    /// @brief Walker/Vose alias table for O(1) sampling of a discrete
+    ///        distribution after an O(size) build.
+    struct AliasTable {
+        vec prob;
+        uvec alias;
+    };
+
+    vec Probabilities(const cx_mat& rho);
+    vec MarginalProbabilities(const cx_mat& rho, const vector<int>& targets);
+    vec MarginalProbabilities(const vec& diag, const vector<int>& targets);
+    int SampleOutcome(const vec& probabilities, double random);
+    AliasTable BuildAliasTable(const vec& probabilities);
+    int SampleAlias(const AliasTable& table, double u1, double u2);
+    vector<int> SampleShots(const cx_mat& rho, int shots, uint64_t seed);
+    vector<int> SampleShots(const cx_mat& rho, int shots,
+                            const RandomStream& rng);
+    vector<int> PartialSampleShots(const cx_mat& rho,
+                                   const vector<int>& targets, int shots,
+                                   uint64_t seed);
+    vector<int> PartialSampleShots(const cx_mat& rho,
+                                   const vector<int>& targets, int shots,
+                                   const RandomStream& rng);
+    vector<int> Histogram(const vector<int>& outcomes, int outcome_count);
+} // namespace dmqs
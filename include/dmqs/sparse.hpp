@@ -0,0 +1,64 @@
+#pragma once
+#include <armadillo>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <dmqs/gates.hpp>
+#include <dmqs/channels.hpp>
+
+using std::vector, std::string;
+using arma::cx_mat, arma::cx_double, arma::vec, arma::uword;
+
+namespace dmqs {
+/// @brief Density matrix stored as a hash map of its nonzero entries. Basis
+///        states, GHZ states and Clifford prepared states stay sparse, so
+///        every gate and channel costs O(nonzeros) instead of O(4^n). Once
+///        the fill (nonzeros / 4^n) exceeds max_fill the state is promoted
+///        to a dense cx_mat and the dense kernels take over, unless it has
+///        more than max_dense_qubits qubits: then 4^n entries would not fit
+///        in memory and it stays sparse, see DensePromotionSkipped.
+class SparseDensityMatrix {
+ public:
+    explicit SparseDensityMatrix(const string& bin, double max_fill = 0.1,
+                                 double cutoff = 0,
+                                 int max_dense_qubits = 14);
+    explicit SparseDensityMatrix(const char* bin, double max_fill = 0.1,
+                                 double cutoff = 0,
+                                 int max_dense_qubits = 14);
+    explicit SparseDensityMatrix(const cx_mat& rho, double max_fill = 0.1,
+                                 double cutoff = 0,
+                                 int max_dense_qubits = 14);
+    int Qubits() const;
+    bool IsDense() const;
+    bool DensePromotionSkipped() const;
+    size_t NonZeros() const;
+    double Fill() const;
+    cx_double At(uword row, uword col) const;
+    cx_mat Dense() const;
+    vec Probabilities() const;
+    void ApplyGate(const cx_mat& U1, int target);
+    void ApplyGate(u_gate gate, int target);
+    void ApplyCGate(const cx_mat& U1, int control, int target);
+    void ApplyCGate(u_gate gate, int control, int target);
+    void ApplyChannel(const vector<kraus_t>& ops, int qubit);
+
+ private:
+    typedef std::unordered_map<uint64_t, cx_double> entries_t;
+
+    uword QubitMask(int qubit) const;
+    void Conjugate(const cx_mat& U1, uword target_mask, uword control_mask,
+                   entries_t& out) const;
+    void Update(entries_t&& next);
+
+    int n_;
+    double max_fill_;
+    double cutoff_;
+    int max_dense_qubits_;
+    entries_t entries_;
+    cx_mat dense_;
+    bool is_dense_;
+    bool promotion_skipped_;
+};
+} // namespace dmqs
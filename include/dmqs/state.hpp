@@ -0,0 +1,64 @@
+#pragma once
+#include <armadillo>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <dmqs/gates.hpp>
+#include <dmqs/channels.hpp>
+#include <dmqs/cache.hpp>
+#include <dmqs/random.hpp>
+
+using std::vector, std::string;
+using arma::cx_mat, arma::cx_vec, arma::vec;
+
+namespace dmqs {
+/// @brief Quantum state that is kept as a 2^n state vector while only
+///        unitaries and projective measurements are applied, and promoted
+///        to a 4^n density matrix psi psi† the first time a non unitary
+///        channel arrives. Promotions() and VectorOperations() show how
+///        long a run stayed on the cheap path. Reduced states are cached
+///        per target set and only recomputed after an operation changed
+///        them, see ReducedStateCache.
+class State {
+ public:
+    explicit State(const string& bin);
+    explicit State(const char* bin);
+    explicit State(const cx_vec& psi);
+    explicit State(const cx_mat& rho);
+    int Qubits() const;
+    bool IsStateVector() const;
+    const cx_vec& StateVector() const;
+    cx_mat DensityMatrix() const;
+    vec Probabilities() const;
+    cx_mat PartialTrace(const vector<int>& targets) const;
+    int PartialSample(const vector<int>& targets, double random) const;
+    int PartialSample(const vector<int>& targets, RandomStream& rng) const;
+    const ReducedStateCache& Cache() const;
+    void ApplyGate(const cx_mat& U1, int target);
+    void ApplyGate(u_gate gate, int target);
+    void ApplyCGate(u_gate gate, int control, int target);
+    void ApplyRotation(u_gate axis, double theta, int target);
+    void ApplyCRotation(u_gate axis, double theta, int control, int target);
+    void ApplySwap(int q1, int q2);
+    void ApplyChannel(const vector<kraus_t>& ops, int qubit);
+    void ApplyAmplitudeDampeningAndDephasing(int qubit, double T1, double T2,
+                                             double t);
+    void Collapse(const vector<int>& targets, int state);
+    int MeasureAndCollapse(const vector<int>& targets, double random);
+    int MeasureAndCollapse(const vector<int>& targets, RandomStream& rng);
+    void Promote();
+    int64_t Promotions() const;
+    int64_t VectorOperations() const;
+
+ private:
+    void CheckQubit(int qubit) const;
+    int n_;
+    cx_vec psi_;
+    cx_mat rho_;
+    bool is_vector_;
+    int64_t promotions_;
+    int64_t vector_operations_;
+    mutable ReducedStateCache cache_;
+};
+} // namespace dmqs
@@ -1,6 +1,8 @@
 #include <cstdlib>
 #include <dmqs/dmqs.hpp>
 #include <dmqs/channels.hpp>
+#include <dmqs/qasm.hpp>
+#include <dmqs/pool.hpp>
 #ifndef INCLUDE_UPPAAL_UPPAAL_H_
 #define INCLUDE_UPPAAL_UPPAAL_H_
 
@@ -9,6 +11,11 @@ extern "C" int MeasureAll(double* rho, int rho_size, double r);
 extern "C" void ApplyGate(double* rho, int rho_size, int gate, int target);
 extern "C" void ApplyCGate(double* rho, int rho_size, int gate, int control,
                             int target);
+extern "C" void ApplyRotation(double* rho, int rho_size, int axis,
+                               double theta, int target);
+extern "C" void ApplyCRotation(double* rho, int rho_size, int axis,
+                                double theta, int control, int target);
+extern "C" void ApplySwap(double* rho, int rho_size, int q1, int q2);
 extern "C" void ApplyUnitary(double* rho, int rho_size, double* U, int u_size);
 extern "C" void PartialTrace(double* rho, int rho_size, double* prho,
                               int prho_size, int* targets, int targets_size);
@@ -18,11 +25,65 @@ extern "C" void BasisProjections(double* rho, int rho_size, int* targets,
                                   int targets_size, int state);
 extern "C" int PartialMeasure(double* rho, int rho_size, int* targets,
                                int targets_size, double r);
+extern "C" void MeasureAllShots(double* rho, int rho_size, int* counts,
+                                 int counts_size, int shots, int seed);
+extern "C" void PartialMeasureShots(double* rho, int rho_size, int* targets,
+                                     int targets_size, int* counts,
+                                     int counts_size, int shots, int seed);
+extern "C" int MeasureAndCollapse(double* rho, int rho_size, int* targets,
+                                   int targets_size, double r);
 extern "C" void AmplitudeDampeningAndDephasing(double* rho, int rho_size,
                                                 const double* T1,
                                                 const double* T2, double t);
+extern "C" void FlushIdleNoise(double* rho, int rho_size, const double* T1,
+                                const double* T2, double* pending,
+                                int* targets, int targets_size);
 extern "C" void ApplyChannel(double* rho, int rho_size, int channel,
                               double probs);
 extern "C" void ApplyGAD(double* rho, int rho_size, double p, double g);
 extern "C" void ResetQubit(double* rho, int rho_size, int qubit);
+extern "C" double Purity(double* rho, int rho_size);
+extern "C" double LinearEntropy(double* rho, int rho_size);
+extern "C" double VonNeumannEntropy(double* rho, int rho_size);
+extern "C" double PureFidelity(double* rho, int rho_size, double* psi,
+                                int psi_size);
+extern "C" double Fidelity(double* rho, int rho_size, double* sigma,
+                            int sigma_size);
+extern "C" double TraceDistance(double* rho, int rho_size, double* sigma,
+                                 int sigma_size);
+extern "C" int RunCircuit(double* rho, int rho_size, const char* source,
+                          int seed);
+extern "C" void SaveState(double* rho, int rho_size, const char* path);
+extern "C" void LoadState(double* rho, int rho_size, const char* path);
+extern "C" int CreateState(int n, const char* init);
+extern "C" int CloneState(int state);
+extern "C" void DestroyState(int state);
+extern "C" int StateQubits(int state);
+extern "C" void StateApplyGate(int state, int gate, int target);
+extern "C" void StateApplyCGate(int state, int gate, int control,
+                                int target);
+extern "C" void StateApplyRotation(int state, int axis, double theta,
+                                   int target);
+extern "C" void StateApplyCRotation(int state, int axis, double theta,
+                                    int control, int target);
+extern "C" void StateApplySwap(int state, int q1, int q2);
+extern "C" void StateApplyChannel(int state, int channel, double prob,
+                                  int qubit);
+extern "C" void StateResetQubit(int state, int qubit);
+extern "C" void StateAmplitudeDampeningAndDephasing(int state,
+                                                    const double* T1,
+                                                    const double* T2,
+                                                    double t);
+extern "C" int StateMeasureAll(int state, double r);
+extern "C" int StatePartialMeasure(int state, int* targets, int targets_size,
+                                   double r);
+extern "C" int StateMeasureAndCollapse(int state, int* targets,
+                                       int targets_size, double r);
+extern "C" void StateReadDensityMatrix(int state, double* rho,
+                                       int rho_size);
+extern "C" void StateSave(int state, const char* path);
+extern "C" int StateLoad(const char* path);
+extern "C" void SetExecutionContext(int threads, int blas_threads,
+                                    int serial_threshold, int* cpus,
+                                    int cpus_size);
 #endif // INCLUDE_UPPAAL_UPPAAL_H_
@@ -0,0 +1,340 @@
+#include <dmqs/async.hpp>
+#include <dmqs/dmqs.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using std::invalid_argument, std::to_string;
+
+namespace dmqs {
+Measurement::Measurement(std::shared_ptr<Shared> shared)
+    : shared_(std::move(shared)) {}
+
+/// @brief Whether the measurement has run.
+bool Measurement::Ready() const {
+    std::lock_guard<std::mutex> lock(shared_->mutex);
+    return shared_->ready;
+}
+
+/// @brief Blocks until the measurement has run and returns its outcome,
+///        with the lowest numbered target as the most significant bit
+///        whatever the order the targets were given in, as in
+///        dmqs::CollapseInPlace. Rethrows the error of a failed queue.
+int Measurement::Get() const {
+    std::unique_lock<std::mutex> lock(shared_->mutex);
+    shared_->ready_cv.wait(lock, [this] { return shared_->ready; });
+    if (shared_->error) {
+        std::rethrow_exception(shared_->error);
+    }
+    return shared_->outcome;
+}
+
+bool Measurement::await_ready() const {
+    return Ready();
+}
+
+/// @brief Parks the awaiting coroutine until the executor resolves the
+///        measurement. Returns false, resuming at once, when it already has.
+bool Measurement::await_suspend(std::coroutine_handle<> continuation) {
+    std::lock_guard<std::mutex> lock(shared_->mutex);
+    if (shared_->ready) {
+        return false;
+    }
+    shared_->continuation = continuation;
+    return true;
+}
+
+int Measurement::await_resume() const {
+    return Get();
+}
+
+void Measurement::Resolve(Shared& shared, int outcome,
+                          std::exception_ptr error) {
+    std::coroutine_handle<> continuation;
+    {
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        shared.outcome = outcome;
+        shared.error = error;
+        shared.ready = true;
+        continuation = std::exchange(shared.continuation, nullptr);
+    }
+    shared.ready_cv.notify_all();
+    if (continuation) {
+        continuation.resume();
+    }
+}
+
+/// @brief Starts an executor for a copy of rho.
+/// @param rho Initial density matrix of 2^n rows.
+/// @param seed Seed of the random stream of the measurements.
+CommandQueue::CommandQueue(const cx_mat& rho, uint64_t seed)
+    : n_(0), rho_(rho), rng_(seed), busy_(false), stopping_(false),
+      batches_(0) {
+    if (rho.n_rows < 2 || rho.n_rows != rho.n_cols ||
+        (rho.n_rows & (rho.n_rows - 1)) != 0) {
+        throw invalid_argument("Density matrix must be a square 2^n matrix");
+    }
+    while ((arma::uword(1) << n_) < rho.n_rows) {
+        n_++;
+    }
+    executor_ = std::thread(&CommandQueue::Run, this);
+}
+
+/// @brief Starts an executor for a product state in the format of
+///        BinaryStringToDensityMatrix.
+CommandQueue::CommandQueue(const string& bin, uint64_t seed)
+    : CommandQueue(BinaryStringToDensityMatrix(bin), seed) {}
+
+/// @brief Runs everything still queued, then stops the executor.
+CommandQueue::~CommandQueue() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_.notify_all();
+    executor_.join();
+}
+
+int CommandQueue::Qubits() const {
+    return n_;
+}
+
+/// @brief Queues an operation of the circuit IR. Qubits are checked here,
+///        so a bad command throws in the caller instead of the executor.
+void CommandQueue::Enqueue(const Operation& op) {
+    if (op.kind == OpKind::MEASURE) {
+        Measure(op.qubits);
+        return;
+    }
+    Push(Command{op, nullptr});
+}
+
+void CommandQueue::ApplyGate(u_gate gate, int target) {
+    Operation op;
+    op.kind = OpKind::GATE;
+    op.gate = gate;
+    op.qubits = {target};
+    Push(Command{op, nullptr});
+}
+
+void CommandQueue::ApplyCGate(u_gate gate, int control, int target) {
+    Operation op;
+    op.kind = OpKind::CGATE;
+    op.gate = gate;
+    op.qubits = {control, target};
+    Push(Command{op, nullptr});
+}
+
+/// @brief Queues a rotation of theta degrees around axis (RX, RY or RZ).
+void CommandQueue::ApplyRotation(u_gate axis, double theta, int target) {
+    Operation op;
+    op.kind = OpKind::ROTATION;
+    op.gate = axis;
+    op.param = theta;
+    op.qubits = {target};
+    Push(Command{op, nullptr});
+}
+
+void CommandQueue::ApplyCRotation(u_gate axis, double theta, int control,
+                                  int target) {
+    Operation op;
+    op.kind = OpKind::CROTATION;
+    op.gate = axis;
+    op.param = theta;
+    op.qubits = {control, target};
+    Push(Command{op, nullptr});
+}
+
+void CommandQueue::ApplySwap(int q1, int q2) {
+    Operation op;
+    op.kind = OpKind::SWAP;
+    op.qubits = {q1, q2};
+    Push(Command{op, nullptr});
+}
+
+void CommandQueue::ApplyChannel(u_channel channel, double p, int qubit) {
+    Operation op;
+    op.kind = OpKind::CHANNEL;
+    op.channel = channel;
+    op.param = p;
+    op.qubits = {qubit};
+    Push(Command{op, nullptr});
+}
+
+void CommandQueue::Reset(int qubit) {
+    Operation op;
+    op.kind = OpKind::RESET;
+    op.qubits = {qubit};
+    Push(Command{op, nullptr});
+}
+
+/// @brief Queues a measurement of the targets that collapses the state.
+/// @return The outcome once the executor reached it, with the lowest
+///         numbered target as the most significant bit, so Measure({2, 0})
+///         returns qubit 0 in the high bit.
+Measurement CommandQueue::Measure(const vector<int>& targets) {
+    Operation op;
+    op.kind = OpKind::MEASURE;
+    op.qubits = targets;
+    auto shared = std::make_shared<Measurement::Shared>();
+    Push(Command{op, shared});
+    return Measurement(shared);
+}
+
+/// @brief Blocks until every queued command has run. Rethrows the error of
+///        a failed command; the queue stays failed afterwards, since the
+///        state is no longer known.
+void CommandQueue::Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return pending_.empty() && !busy_; });
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+/// @brief Runs every queued command and returns a copy of the state.
+cx_mat CommandQueue::Snapshot() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return pending_.empty() && !busy_; });
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+    // The executor cannot start a batch while the lock is held
+    return rho_;
+}
+
+/// @brief Number of batches the executor has run.
+int64_t CommandQueue::Batches() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return batches_;
+}
+
+/// @brief What fusing the batches removed so far.
+OptimizationStats CommandQueue::Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void CommandQueue::Push(Command command) {
+    const vector<int>& qubits = command.op.qubits;
+    size_t expected = 1;
+    if (command.op.kind == OpKind::CGATE ||
+        command.op.kind == OpKind::CROTATION ||
+        command.op.kind == OpKind::SWAP) {
+        expected = 2;
+    }
+    if (command.op.kind == OpKind::MEASURE ? qubits.empty()
+                                           : qubits.size() != expected) {
+        throw invalid_argument("Command expects " + to_string(expected) +
+                               " qubits not " + to_string(qubits.size()));
+    }
+    for (size_t i = 0; i < qubits.size(); i++) {
+        if (qubits[i] < 0 || qubits[i] >= n_) {
+            throw invalid_argument(
+                "Qubit " + to_string(qubits[i]) + " is outside of a " +
+                to_string(n_) + " qubit system");
+        }
+        for (size_t j = 0; j < i; j++) {
+            if (qubits[i] == qubits[j]) {
+                throw invalid_argument("Qubit " + to_string(qubits[i]) +
+                                       " is used twice");
+            }
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            throw invalid_argument("Command queue is shutting down");
+        }
+        pending_.push_back(std::move(command));
+    }
+    work_.notify_one();
+}
+
+void CommandQueue::Run() {
+    while (true) {
+        vector<Command> batch;
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_.wait(lock,
+                       [this] { return stopping_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                return;
+            }
+            batch.swap(pending_);
+            busy_ = true;
+            error = error_;
+        }
+        if (error) {
+            for (Command& command : batch) {
+                if (command.measurement != nullptr) {
+                    Measurement::Resolve(*command.measurement, 0, error);
+                }
+            }
+        } else {
+            try {
+                Execute(batch);
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            busy_ = false;
+            batches_++;
+            if (error) {
+                error_ = error;
+            }
+        }
+        idle_.notify_all();
+    }
+}
+
+/// @brief Runs one batch: the gates and channels between two measurements
+///        are optimized as one circuit, then every measurement collapses
+///        the state and resolves its Measurement.
+void CommandQueue::Execute(vector<Command>& batch) {
+    vector<int> clbits;
+    size_t start = 0;
+    try {
+        while (start < batch.size()) {
+            Circuit circuit;
+            circuit.qubits = n_;
+            size_t end = start;
+            while (end < batch.size() && batch[end].measurement == nullptr) {
+                circuit.ops.push_back(batch[end].op);
+                end++;
+            }
+            if (!circuit.ops.empty()) {
+                OptimizationStats stats;
+                Circuit optimized = OptimizeCircuit(circuit, &stats);
+                for (const Operation& op : optimized.ops) {
+                    ApplyOperationInPlace(rho_, op, clbits, rng_);
+                }
+                std::lock_guard<std::mutex> lock(mutex_);
+                stats_.fused += stats.fused;
+                stats_.cancelled += stats.cancelled;
+            }
+            if (end < batch.size()) {
+                Command& command = batch[end];
+                int outcome = MeasureAndCollapse(rho_, command.op.qubits,
+                                                 rng_);
+                start = end + 1;
+                Measurement::Resolve(*command.measurement, outcome, nullptr);
+            } else {
+                start = end;
+            }
+        }
+    } catch (...) {
+        std::exception_ptr error = std::current_exception();
+        for (size_t i = start; i < batch.size(); i++) {
+            if (batch[i].measurement != nullptr &&
+                !Measurement(batch[i].measurement).Ready()) {
+                Measurement::Resolve(*batch[i].measurement, 0, error);
+            }
+        }
+        throw;
+    }
+}
+} // namespace dmqs
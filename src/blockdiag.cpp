@@ -0,0 +1,539 @@
+#include <dmqs/blockdiag.hpp>
+#include <dmqs/dmqs.hpp>
+#include <algorithm>
+#include <complex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using std::invalid_argument, std::to_string;
+using arma::uvec;
+
+namespace dmqs {
+/// @brief Ascending indices of a qubits-qubit register whose qubit at
+///        position (first qubit most significant) equals value.
+static uvec BitIndices(int qubits, int position, uword value) {
+    uvec indices(uword(1) << (qubits - 1));
+    for (uword r = 0; r < indices.n_elem; r++) {
+        indices(r) = InsertBit(r, uword(1) << (qubits - 1 - position),
+                               value);
+    }
+    return indices;
+}
+
+static void CheckGate(const cx_mat& U1) {
+    if (U1.n_rows != 2 || U1.n_cols != 2) {
+        throw invalid_argument("A 1 qubit gate must be a 2x2 matrix");
+    }
+}
+
+/// @brief Creates a product state from a binary string in the format of
+///        BinaryStringToDensityMatrix. 0 and 1 are classical from the start
+///        and only the + and - qubits are stored densely.
+/// @param bin A string of 0, 1, + and - e.g "0+1"
+BlockDiagonalState::BlockDiagonalState(const string& bin)
+    : n_(bin.length()), promotions_(0), demotions_(0) {
+    if (bin.empty()) {
+        throw invalid_argument("A state needs at least 1 qubit");
+    }
+    string quantum;
+    uword block = 0;
+    for (int q = 0; q < n_; q++) {
+        char c = bin[q];
+        if (c == '0' || c == '1') {
+            classical_.push_back(q);
+            block = (block << 1) | (c == '1');
+        } else if (c == '+' || c == '-') {
+            quantum_.push_back(q);
+            quantum += c;
+        } else {
+            throw invalid_argument(
+                "Invalid basis state '" + string(1, c) + "' in " + bin);
+        }
+    }
+    cx_mat local = quantum.empty() ? cx_mat(1, 1, arma::fill::ones)
+                                   : BinaryStringToDensityMatrix(quantum);
+    blocks_.assign(uword(1) << classical_.size(),
+                   cx_mat(local.n_rows, local.n_cols, arma::fill::zeros));
+    blocks_[block] = local;
+}
+
+BlockDiagonalState::BlockDiagonalState(const char* bin)
+    : BlockDiagonalState(string(bin)) {}
+
+/// @brief Splits a density matrix into blocks, every qubit whose
+///        coherences are exactly zero becomes classical.
+/// @param rho Density matrix.
+BlockDiagonalState::BlockDiagonalState(const cx_mat& rho)
+    : n_(slog2(rho.n_rows)), blocks_{rho}, promotions_(0), demotions_(0) {
+    if (rho.n_rows < 2 || rho.n_rows != rho.n_cols ||
+        (uword(1) << n_) != rho.n_rows) {
+        throw invalid_argument("Density matrix must be a square 2^n matrix");
+    }
+    for (int q = 0; q < n_; q++) {
+        quantum_.push_back(q);
+    }
+    for (int q = 0; q < n_; q++) {
+        TryDemote(q);
+    }
+    demotions_ = 0;
+}
+
+/// @brief Number of qubits in the system.
+int BlockDiagonalState::Qubits() const {
+    return n_;
+}
+
+bool BlockDiagonalState::IsClassical(int qubit) const {
+    CheckQubit(qubit);
+    return ClassicalPosition(qubit) >= 0;
+}
+
+/// @brief Number of classical qubits m, there are 2^m blocks.
+int BlockDiagonalState::ClassicalQubits() const {
+    return static_cast<int>(classical_.size());
+}
+
+/// @brief Number of complex entries stored over all blocks, 4^n / 2^m.
+uword BlockDiagonalState::StoredEntries() const {
+    uword entries = 0;
+    for (const cx_mat& block : blocks_) {
+        entries += block.n_elem;
+    }
+    return entries;
+}
+
+/// @brief Number of times a classical qubit was merged back.
+int64_t BlockDiagonalState::Promotions() const {
+    return promotions_;
+}
+
+/// @brief Number of times a qubit became classical after construction.
+int64_t BlockDiagonalState::Demotions() const {
+    return demotions_;
+}
+
+/// @brief Builds the full density matrix, zero outside the blocks.
+cx_mat BlockDiagonalState::DensityMatrix() const {
+    uword dim = uword(1) << n_;
+    cx_mat rho = cx_mat(dim, dim, arma::fill::zeros);
+    for (uword b = 0; b < blocks_.size(); b++) {
+        uvec indices = FullIndices(b);
+        rho.submat(indices, indices) = blocks_[b];
+    }
+    return rho;
+}
+
+/// @brief Measurement probabilities of every basis state, the diagonals of
+///        the blocks.
+vec BlockDiagonalState::Probabilities() const {
+    vec probabilities = vec(uword(1) << n_);
+    for (uword b = 0; b < blocks_.size(); b++) {
+        probabilities.elem(FullIndices(b)) = real(blocks_[b].diag());
+    }
+    return probabilities;
+}
+
+/// @brief Applies a 1 qubit gate. On a classical qubit a diagonal gate
+///        only reweights blocks and an anti-diagonal gate swaps them, any
+///        other gate promotes the qubit first.
+void BlockDiagonalState::ApplyGate(const cx_mat& U1, int target) {
+    CheckQubit(target);
+    CheckGate(U1);
+    if (IsClassical(target)) {
+        if (ApplyClassical(U1, target, -1)) {
+            return;
+        }
+        Promote(target);
+    }
+    int position = QuantumPosition(target);
+    for (cx_mat& block : blocks_) {
+        ApplyGate1InPlace(block, U1, position);
+    }
+}
+
+void BlockDiagonalState::ApplyGate(u_gate gate, int target) {
+    ApplyGate(UGateToGate(gate), target);
+}
+
+void BlockDiagonalState::ApplyRotation(u_gate axis, double theta,
+                                       int target) {
+    ApplyGate(RotationGate(axis, theta), target);
+}
+
+/// @brief Applies a controlled 1 qubit gate. A classical control selects
+///        the blocks the gate acts on. A diagonal gate on a classical target
+///        is a phase gate on the control within each block.
+void BlockDiagonalState::ApplyCGate(const cx_mat& U1, int control,
+                                    int target) {
+    CheckQubit(control);
+    CheckQubit(target);
+    CheckGate(U1);
+    if (control == target) {
+        throw invalid_argument("Control and target qubit must be different");
+    }
+    if (IsClassical(control)) {
+        if (IsClassical(target)) {
+            if (ApplyClassical(U1, target, control)) {
+                return;
+            }
+            Promote(target);
+        }
+        int position = QuantumPosition(target);
+        for (uword b = 0; b < blocks_.size(); b++) {
+            if (BlockBit(b, control)) {
+                ApplyGate1InPlace(blocks_[b], U1, position);
+            }
+        }
+        return;
+    }
+    if (IsClassical(target)) {
+        if (U1(0, 1) == cx_double(0, 0) && U1(1, 0) == cx_double(0, 0)) {
+            int position = QuantumPosition(control);
+            for (uword b = 0; b < blocks_.size(); b++) {
+                cx_double u = U1(BlockBit(b, target), BlockBit(b, target));
+                if (u != cx_double(1, 0)) {
+                    gate1_t phase = gate1_t(arma::fill::eye);
+                    phase(1, 1) = u;
+                    ApplyGate1InPlace(blocks_[b], phase, position);
+                }
+            }
+            return;
+        }
+        Promote(target);
+    }
+    int c = QuantumPosition(control);
+    int t = QuantumPosition(target);
+    for (cx_mat& block : blocks_) {
+        ApplyCGate1InPlace(block, U1, c, t);
+    }
+}
+
+void BlockDiagonalState::ApplyCGate(u_gate gate, int control, int target) {
+    ApplyCGate(UGateToGate(gate), control, target);
+}
+
+void BlockDiagonalState::ApplyCRotation(u_gate axis, double theta,
+                                        int control, int target) {
+    ApplyCGate(RotationGate(axis, theta), control, target);
+}
+
+/// @brief Swaps two qubits. Two classical qubits swap block labels, a
+///        classical and a quantum qubit exchange roles through a promotion.
+void BlockDiagonalState::ApplySwap(int q1, int q2) {
+    CheckQubit(q1);
+    CheckQubit(q2);
+    if (q1 == q2) {
+        return;
+    }
+    bool classical1 = IsClassical(q1);
+    bool classical2 = IsClassical(q2);
+    if (classical1 && classical2) {
+        int m = ClassicalQubits();
+        uword bit1 = uword(1) << (m - 1 - ClassicalPosition(q1));
+        uword bit2 = uword(1) << (m - 1 - ClassicalPosition(q2));
+        vector<cx_mat> swapped(blocks_.size());
+        for (uword b = 0; b < blocks_.size(); b++) {
+            uword s = b & ~(bit1 | bit2);
+            if (b & bit1) {
+                s |= bit2;
+            }
+            if (b & bit2) {
+                s |= bit1;
+            }
+            swapped[s] = std::move(blocks_[b]);
+        }
+        blocks_ = std::move(swapped);
+        return;
+    }
+    int quantum = classical1 ? q2 : q1;
+    if (classical1 || classical2) {
+        Promote(classical1 ? q1 : q2);
+    }
+    int p1 = QuantumPosition(q1);
+    int p2 = QuantumPosition(q2);
+    for (cx_mat& block : blocks_) {
+        ApplySwapInPlace(block, p1, p2);
+    }
+    if (classical1 || classical2) {
+        TryDemote(quantum);
+    }
+}
+
+/// @brief Applies a 1 qubit channel. On a classical qubit, Kraus operators
+///        with at most one non zero per column (flips, damping, resets and
+///        depolarizing) mix the blocks as a stochastic matrix. Otherwise the
+///        channel runs per block and the qubit is demoted if the channel
+///        left it fully dephased.
+/// @param ops Kraus operators.
+/// @param qubit The qubit the channel acts on.
+void BlockDiagonalState::ApplyChannel(const vector<kraus_t>& ops,
+                                      int qubit) {
+    CheckQubit(qubit);
+    if (ops.empty()) {
+        throw invalid_argument("A channel needs at least 1 Kraus operator");
+    }
+    if (IsClassical(qubit)) {
+        bool stochastic = true;
+        arma::mat::fixed<2, 2> T = arma::mat::fixed<2, 2>(arma::fill::zeros);
+        for (const kraus_t& K : ops) {
+            for (uword c = 0; c < 2; c++) {
+                if (K(0, c) != cx_double(0, 0) &&
+                    K(1, c) != cx_double(0, 0)) {
+                    stochastic = false;
+                }
+                T(0, c) += std::norm(K(0, c));
+                T(1, c) += std::norm(K(1, c));
+            }
+        }
+        if (stochastic && T(0, 0) == 1 && T(1, 1) == 1) {
+            return;
+        }
+        if (stochastic) {
+            int m = ClassicalQubits();
+            uword bit = uword(1) << (m - 1 - ClassicalPosition(qubit));
+            for (uword b = 0; b < blocks_.size(); b++) {
+                if (b & bit) {
+                    continue;
+                }
+                cx_mat block0 = T(0, 0) * blocks_[b] +
+                                T(0, 1) * blocks_[b | bit];
+                blocks_[b | bit] = T(1, 0) * blocks_[b] +
+                                   T(1, 1) * blocks_[b | bit];
+                blocks_[b] = std::move(block0);
+            }
+            return;
+        }
+        Promote(qubit);
+    }
+    int position = QuantumPosition(qubit);
+    for (cx_mat& block : blocks_) {
+        apply_channel_in_place(block, ops, position);
+    }
+    if (TryDemote(qubit)) {
+        DemoteAll();
+    }
+}
+
+/// @brief Fully dephases a qubit, dropping its coherences, and makes it
+///        classical. Same as phase_damping_ops(1) or a non selective
+///        measurement.
+void BlockDiagonalState::Dephase(int qubit) {
+    if (IsClassical(qubit)) {
+        return;
+    }
+    int k = static_cast<int>(quantum_.size());
+    int position = QuantumPosition(qubit);
+    uvec zeros = BitIndices(k, position, 0);
+    uvec ones = BitIndices(k, position, 1);
+    for (cx_mat& block : blocks_) {
+        block.submat(zeros, ones).zeros();
+        block.submat(ones, zeros).zeros();
+    }
+    Demote(qubit);
+    DemoteAll();
+}
+
+/// @brief Measures a set of target qubits and collapses the state in place,
+///        see dmqs::MeasureAndCollapse. The targets become classical and
+///        the blocks of the other outcomes are zeroed.
+int BlockDiagonalState::MeasureAndCollapse(const vector<int>& targets,
+                                           double random) {
+    vec marginal = MarginalProbabilities(Probabilities(), targets);
+    int outcome = SampleOutcome(marginal, random);
+    vector<int> sorted = targets;
+    std::sort(sorted.begin(), sorted.end());
+    for (int t : sorted) {
+        Dephase(t);
+    }
+    for (uword b = 0; b < blocks_.size(); b++) {
+        bool match = true;
+        for (size_t k = 0; k < sorted.size(); k++) {
+            uword bit = (outcome >> (sorted.size() - 1 - k)) & 1;
+            if (BlockBit(b, sorted[k]) != bit) {
+                match = false;
+            }
+        }
+        if (match) {
+            blocks_[b] /= marginal(outcome);
+        } else {
+            blocks_[b].zeros();
+        }
+    }
+    return outcome;
+}
+
+/// @brief Measures a set of target qubits and collapses the state in place,
+///        drawing the random value from rng.
+int BlockDiagonalState::MeasureAndCollapse(const vector<int>& targets,
+                                           RandomStream& rng) {
+    return MeasureAndCollapse(targets, rng.Uniform());
+}
+
+/// @brief Makes a classical qubit quantum again, merging every pair of
+///        blocks that differ in it into one block twice the size.
+void BlockDiagonalState::Promote(int qubit) {
+    if (!IsClassical(qubit)) {
+        return;
+    }
+    int m = ClassicalQubits();
+    uword bit = uword(1) << (m - 1 - ClassicalPosition(qubit));
+    auto at = std::lower_bound(quantum_.begin(), quantum_.end(), qubit);
+    int position = static_cast<int>(at - quantum_.begin());
+    int k = static_cast<int>(quantum_.size()) + 1;
+    uvec zeros = BitIndices(k, position, 0);
+    uvec ones = BitIndices(k, position, 1);
+    uword dim = uword(1) << k;
+    vector<cx_mat> merged(blocks_.size() / 2);
+    for (uword b = 0; b < merged.size(); b++) {
+        merged[b] = cx_mat(dim, dim, arma::fill::zeros);
+        merged[b].submat(zeros, zeros) = blocks_[InsertBit(b, bit, 0)];
+        merged[b].submat(ones, ones) = blocks_[InsertBit(b, bit, 1)];
+    }
+    blocks_ = std::move(merged);
+    classical_.erase(classical_.begin() + ClassicalPosition(qubit));
+    quantum_.insert(at, qubit);
+    promotions_++;
+}
+
+/// @brief Makes a qubit classical if all its coherences are exactly zero.
+/// @return Whether the qubit is classical.
+bool BlockDiagonalState::TryDemote(int qubit) {
+    if (IsClassical(qubit)) {
+        return true;
+    }
+    int k = static_cast<int>(quantum_.size());
+    int position = QuantumPosition(qubit);
+    uvec zeros = BitIndices(k, position, 0);
+    uvec ones = BitIndices(k, position, 1);
+    for (const cx_mat& block : blocks_) {
+        for (uword r : zeros) {
+            for (uword c : ones) {
+                if (block(r, c) != cx_double(0, 0) ||
+                    block(c, r) != cx_double(0, 0)) {
+                    return false;
+                }
+            }
+        }
+    }
+    Demote(qubit);
+    return true;
+}
+
+/// @brief Demotes every qubit whose coherences are zero. Dephasing one
+///        qubit also dephases the qubits only correlated with it, as for a
+///        Bell pair.
+void BlockDiagonalState::DemoteAll() {
+    vector<int> quantum = quantum_;
+    for (int q : quantum) {
+        TryDemote(q);
+    }
+}
+
+/// @brief Position of qubit in classical_, -1 if it is quantum.
+int BlockDiagonalState::ClassicalPosition(int qubit) const {
+    auto at = std::find(classical_.begin(), classical_.end(), qubit);
+    return at == classical_.end() ? -1
+                                  : static_cast<int>(at - classical_.begin());
+}
+
+/// @brief Position of qubit in quantum_, -1 if it is classical.
+int BlockDiagonalState::QuantumPosition(int qubit) const {
+    auto at = std::find(quantum_.begin(), quantum_.end(), qubit);
+    return at == quantum_.end() ? -1
+                                : static_cast<int>(at - quantum_.begin());
+}
+
+/// @brief Value of a classical qubit in the configuration of a block.
+uword BlockDiagonalState::BlockBit(uword block, int qubit) const {
+    int m = ClassicalQubits();
+    return (block >> (m - 1 - ClassicalPosition(qubit))) & 1;
+}
+
+/// @brief Rows of the full density matrix covered by a block, in the order
+///        of its local indices.
+uvec BlockDiagonalState::FullIndices(uword block) const {
+    int m = ClassicalQubits();
+    int k = static_cast<int>(quantum_.size());
+    uvec indices(uword(1) << k);
+    for (uword l = 0; l < indices.n_elem; l++) {
+        uword i = 0;
+        int classical = 0;
+        int quantum = 0;
+        for (int q = 0; q < n_; q++) {
+            uword bit;
+            if (classical < m && classical_[classical] == q) {
+                bit = (block >> (m - 1 - classical++)) & 1;
+            } else {
+                bit = (l >> (k - 1 - quantum++)) & 1;
+            }
+            i = (i << 1) | bit;
+        }
+        indices(l) = i;
+    }
+    return indices;
+}
+
+/// @brief Applies a diagonal or anti-diagonal gate to a classical target
+///        by reweighting or swapping blocks, only in the blocks where the
+///        classical control is 1 unless control is -1.
+/// @return false if the gate mixes |0⟩ and |1⟩ and needs a promotion.
+bool BlockDiagonalState::ApplyClassical(const cx_mat& U1, int target,
+                                        int control) {
+    const cx_double zero = cx_double(0, 0);
+    bool diagonal = U1(0, 1) == zero && U1(1, 0) == zero;
+    bool flip = U1(0, 0) == zero && U1(1, 1) == zero;
+    if (!diagonal && !flip) {
+        return false;
+    }
+    int m = ClassicalQubits();
+    uword bit = uword(1) << (m - 1 - ClassicalPosition(target));
+    for (uword b = 0; b < blocks_.size(); b++) {
+        if ((b & bit) || (control >= 0 && !BlockBit(b, control))) {
+            continue;
+        }
+        double w0 = diagonal ? std::norm(U1(0, 0)) : std::norm(U1(1, 0));
+        double w1 = diagonal ? std::norm(U1(1, 1)) : std::norm(U1(0, 1));
+        if (flip) {
+            std::swap(blocks_[b], blocks_[b | bit]);
+        }
+        // Block b | bit now holds the weight that came from |0⟩
+        if (w0 != 1) {
+            blocks_[diagonal ? b : b | bit] *= w0;
+        }
+        if (w1 != 1) {
+            blocks_[diagonal ? b | bit : b] *= w1;
+        }
+    }
+    return true;
+}
+
+void BlockDiagonalState::CheckQubit(int qubit) const {
+    if (qubit < 0 || qubit >= n_) {
+        throw invalid_argument("Qubit should be in [0, " + to_string(n_) +
+                               "). Got " + to_string(qubit));
+    }
+}
+
+/// @brief Splits every block in two along a quantum qubit whose coherences
+///        are zero, the qubit becomes classical.
+void BlockDiagonalState::Demote(int qubit) {
+    int k = static_cast<int>(quantum_.size());
+    int position = QuantumPosition(qubit);
+    uvec zeros = BitIndices(k, position, 0);
+    uvec ones = BitIndices(k, position, 1);
+    auto at = std::lower_bound(classical_.begin(), classical_.end(), qubit);
+    int m = ClassicalQubits() + 1;
+    int slot = static_cast<int>(at - classical_.begin());
+    uword bit = uword(1) << (m - 1 - slot);
+    vector<cx_mat> split(blocks_.size() * 2);
+    for (uword b = 0; b < blocks_.size(); b++) {
+        split[InsertBit(b, bit, 0)] = blocks_[b].submat(zeros, zeros);
+        split[InsertBit(b, bit, 1)] = blocks_[b].submat(ones, ones);
+    }
+    blocks_ = std::move(split);
+    classical_.insert(at, qubit);
+    quantum_.erase(quantum_.begin() + position);
+    demotions_++;
+}
+} // namespace dmqs
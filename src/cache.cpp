@@ -0,0 +1,118 @@
+#include <dmqs/cache.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using std::invalid_argument, std::to_string;
+
+namespace dmqs {
+/// @brief Creates an empty cache for a system of n qubits.
+ReducedStateCache::ReducedStateCache(int n)
+    : versions_(n, 0), parent_(n), hits_(0), misses_(0) {
+    for (int q = 0; q < n; q++) {
+        parent_[q] = q;
+    }
+}
+
+/// @brief Records an operation acting on qubits. Their versions are bumped
+///        and, for multi qubit operations, their groups are merged.
+/// @param qubits Qubits the operation acts on.
+void ReducedStateCache::Touch(const vector<int>& qubits) {
+    for (int q : qubits) {
+        CheckQubit(q);
+        versions_[q]++;
+    }
+    for (size_t i = 1; i < qubits.size(); i++) {
+        parent_[Group(qubits[i])] = Group(qubits[0]);
+    }
+}
+
+/// @brief Records a projective collapse of qubits, which changes the
+///        reduced state of every qubit they have interacted with.
+/// @param qubits The measured qubits.
+void ReducedStateCache::Collapse(const vector<int>& qubits) {
+    vector<int> groups;
+    for (int q : qubits) {
+        CheckQubit(q);
+        groups.push_back(Group(q));
+    }
+    for (size_t q = 0; q < versions_.size(); q++) {
+        int group = Group(q);
+        if (std::find(groups.begin(), groups.end(), group) != groups.end()) {
+            versions_[q]++;
+        }
+    }
+}
+
+/// @brief Puts every qubit in one group, for a state whose entanglement is
+///        unknown, e.g one built from an arbitrary vector or matrix. A
+///        collapse then changes every reduced state.
+void ReducedStateCache::MergeAll() {
+    for (size_t q = 0; q < parent_.size(); q++) {
+        parent_[q] = 0;
+    }
+}
+
+/// @brief Drops every entry, e.g after the state is replaced.
+void ReducedStateCache::Invalidate() {
+    entries_.clear();
+}
+
+/// @brief Returns the cached reduced state of the targets, or computes it
+///        with trace and stores it if any target changed since.
+/// @param targets Qubits to keep.
+/// @param trace Computes the reduced state of the sorted targets.
+/// @return The reduced density matrix, ordered as PartialTrace.
+const cx_mat& ReducedStateCache::Get(
+    const vector<int>& targets,
+    const std::function<cx_mat(const vector<int>&)>& trace) {
+    vector<int> key = targets;
+    std::sort(key.begin(), key.end());
+    vector<uint64_t> versions;
+    for (int q : key) {
+        CheckQubit(q);
+        versions.push_back(versions_[q]);
+    }
+    auto it = entries_.find(key);
+    if (it != entries_.end() && it->second.versions == versions) {
+        hits_++;
+        return it->second.reduced;
+    }
+    misses_++;
+    Entry& entry = entries_[key];
+    entry.reduced = trace(key);
+    entry.versions = std::move(versions);
+    return entry.reduced;
+}
+
+/// @brief Number of operations that touched a qubit so far.
+uint64_t ReducedStateCache::Version(int qubit) const {
+    CheckQubit(qubit);
+    return versions_[qubit];
+}
+
+/// @brief Number of lookups answered from the cache.
+int64_t ReducedStateCache::Hits() const {
+    return hits_;
+}
+
+/// @brief Number of lookups that had to take the partial trace.
+int64_t ReducedStateCache::Misses() const {
+    return misses_;
+}
+
+int ReducedStateCache::Group(int qubit) const {
+    while (parent_[qubit] != qubit) {
+        qubit = parent_[qubit];
+    }
+    return qubit;
+}
+
+void ReducedStateCache::CheckQubit(int qubit) const {
+    if (qubit < 0 || static_cast<size_t>(qubit) >= versions_.size()) {
+        throw invalid_argument(
+            "Qubit " + to_string(qubit) + " is outside of a " +
+            to_string(versions_.size()) + " qubit system");
+    }
+}
+} // namespace dmqs
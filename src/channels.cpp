@@ -144,6 +144,40 @@ cx_mat apply_channel(const cx_mat& rho, const vector<kraus_t>& ops) {
     return result;
 }
 
+// Superoperator sum_k conj(K) ⊗ K of a 1 qubit channel
+superop1_t kraus_to_superop(const vector<kraus_t>& ops) {
+    superop1_t S(zeros);
+    for (const kraus_t& K : ops) {
+        S += kron(conj(K), K);
+    }
+    return S;
+}
+
+// Superoperator of the Pauli channel
+// (1 - px - py - pz) rho + px X rho X + py Y rho Y + pz Z rho Z
+superop1_t pauli_superop(double px, double py, double pz) {
+    superop1_t S(zeros);
+    S += (1 - px - py - pz) * kron(conj(Id()), Id());
+    S += px * kron(conj(X()), X());
+    S += py * kron(conj(Y()), Y());
+    S += pz * kron(conj(Z()), Z());
+    return S;
+}
+
+// Apply a 1 qubit channel to a single qubit of rho in place
+void apply_channel_in_place(cx_mat& rho, const vector<kraus_t>& ops,
+                            int qubit) {
+    dmqs::ApplySuperop1InPlace(rho, kraus_to_superop(ops), qubit);
+}
+
+// Apply a 1 qubit channel to a single qubit of rho
+cx_mat apply_channel(const cx_mat& rho, const vector<kraus_t>& ops,
+                     int qubit) {
+    cx_mat result = rho;
+    apply_channel_in_place(result, ops, qubit);
+    return result;
+}
+
 cx_mat reset_qubit(const cx_mat& rho, int qubit) {
     int dim = rho.n_rows;
     int n_qubits = slog2(dim);
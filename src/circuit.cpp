@@ -0,0 +1,269 @@
+#include <dmqs/circuit.hpp>
+#include <dmqs/dmqs.hpp>
+#include <cmath>
+#include <string>
+#include <vector>
+
+using std::invalid_argument, std::to_string;
+
+namespace dmqs {
+// Fused gates within this distance of a phase times the identity are dropped
+static const double kIdentityTolerance = 1e-12;
+
+/// @brief Checks if an operation is a 1 qubit unitary the optimizer may fuse.
+/// @param op The operation.
+/// @return Whether op is a unitary u_gate, rotation or gate matrix.
+bool IsSingleQubitUnitary(const Operation& op) {
+    switch (op.kind) {
+        case OpKind::GATE:
+            return op.gate != GB0 && op.gate != GB1;
+        case OpKind::ROTATION:
+        case OpKind::UNITARY:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// @brief The 2x2 matrix of a 1 qubit gate operation.
+/// @param op A GATE, ROTATION or UNITARY operation.
+/// @return The gate matrix.
+gate1_t OperationMatrix(const Operation& op) {
+    switch (op.kind) {
+        case OpKind::GATE:
+            if (op.gate == GID) {
+                return Id();
+            } else if (op.gate == GB0) {
+                return B0();
+            } else if (op.gate == GB1) {
+                return B1();
+            }
+            return UGateToGate(op.gate);
+        case OpKind::ROTATION:
+            return RotationGate(op.gate, op.param);
+        case OpKind::UNITARY:
+            return op.matrix;
+        default:
+            throw invalid_argument("Operation is not a 1 qubit gate");
+    }
+}
+
+/// @brief Checks if U equals the identity up to a global phase, which
+///        leaves every density matrix unchanged.
+static bool IsIdentityUpToPhase(const gate1_t& U) {
+    return std::abs(U(0, 1)) < kIdentityTolerance &&
+           std::abs(U(1, 0)) < kIdentityTolerance &&
+           std::abs(U(0, 0) - U(1, 1)) < kIdentityTolerance &&
+           std::abs(std::abs(U(0, 0)) - 1) < kIdentityTolerance;
+}
+
+/// @brief Checks if two operations are the same self inverse 2 qubit gate,
+///        so that applying both is the identity.
+static bool CancelsOut(const Operation& a, const Operation& b) {
+    if (a.kind != b.kind) {
+        return false;
+    }
+    if (a.kind == OpKind::SWAP) {
+        return (a.qubits[0] == b.qubits[0] && a.qubits[1] == b.qubits[1]) ||
+               (a.qubits[0] == b.qubits[1] && a.qubits[1] == b.qubits[0]);
+    }
+    bool self_inverse = a.gate == GX || a.gate == GY || a.gate == GZ ||
+                        a.gate == GH;
+    return a.kind == OpKind::CGATE && self_inverse && a.gate == b.gate &&
+           a.qubits == b.qubits;
+}
+
+static void CheckQubits(const Operation& op, int n) {
+    size_t expected = 1;
+    if (op.kind == OpKind::CGATE || op.kind == OpKind::CROTATION ||
+        op.kind == OpKind::SWAP) {
+        expected = 2;
+    }
+    if (op.kind != OpKind::BARRIER && op.qubits.size() != expected) {
+        throw invalid_argument(
+            "Operation expects " + to_string(expected) + " qubits not " +
+            to_string(op.qubits.size()));
+    }
+    for (int q : op.qubits) {
+        if (q < 0 || q >= n) {
+            throw invalid_argument(
+                "Qubit " + to_string(q) + " is outside of a " +
+                to_string(n) + " qubit circuit");
+        }
+    }
+}
+
+/// @brief Optimizes a circuit without changing its effect on any density
+///        matrix. Runs of 1 qubit unitaries on the same qubit are fused into
+///        a single gate, even when gates on other qubits sit in between,
+///        and runs that multiply to the identity are dropped. Adjacent pairs
+///        of the same self inverse controlled gate or swap cancel. Barriers
+///        stop both rewrites and are removed.
+/// @param circuit The circuit to optimize.
+/// @param stats If given, filled with the number of removed operations.
+/// @return The optimized circuit.
+Circuit OptimizeCircuit(const Circuit& circuit, OptimizationStats* stats) {
+    struct Run {
+        int64_t count = 0;
+        Operation first;
+        gate1_t U;
+    };
+    int n = circuit.qubits;
+    OptimizationStats local;
+    Circuit result;
+    result.qubits = n;
+    result.clbits = circuit.clbits;
+    vector<bool> alive;
+    vector<Run> runs(n);
+    // Index of the last kept operation on every qubit, -1 if unknown
+    vector<int64_t> last(n, -1);
+
+    auto emit = [&](const Operation& op) {
+        if (op.qubits.size() == 2) {
+            int64_t a = last[op.qubits[0]];
+            if (a >= 0 && a == last[op.qubits[1]] && alive[a] &&
+                CancelsOut(result.ops[a], op)) {
+                alive[a] = false;
+                last[op.qubits[0]] = -1;
+                last[op.qubits[1]] = -1;
+                local.cancelled += 2;
+                return;
+            }
+        }
+        result.ops.push_back(op);
+        alive.push_back(true);
+        for (int q : op.qubits) {
+            last[q] = result.ops.size() - 1;
+        }
+    };
+    auto flush = [&](int q) {
+        Run& run = runs[q];
+        if (run.count == 0) {
+            return;
+        }
+        if (IsIdentityUpToPhase(run.U)) {
+            local.cancelled += run.count;
+        } else if (run.count == 1) {
+            emit(run.first);
+        } else {
+            Operation fused;
+            fused.kind = OpKind::UNITARY;
+            fused.qubits = {q};
+            fused.matrix = run.U;
+            emit(fused);
+            local.fused += run.count - 1;
+        }
+        run.count = 0;
+    };
+
+    for (const Operation& op : circuit.ops) {
+        CheckQubits(op, n);
+        if (IsSingleQubitUnitary(op)) {
+            Run& run = runs[op.qubits[0]];
+            if (run.count == 0) {
+                run.first = op;
+                run.U = OperationMatrix(op);
+            } else {
+                run.U = OperationMatrix(op) * run.U;
+            }
+            run.count++;
+            continue;
+        }
+        for (int q : op.qubits) {
+            flush(q);
+        }
+        if (op.kind == OpKind::BARRIER) {
+            for (int q : op.qubits) {
+                last[q] = -1;
+            }
+            continue;
+        }
+        emit(op);
+    }
+    for (int q = 0; q < n; q++) {
+        flush(q);
+    }
+
+    vector<Operation> kept;
+    for (size_t i = 0; i < result.ops.size(); i++) {
+        if (alive[i]) {
+            kept.push_back(result.ops[i]);
+        }
+    }
+    result.ops = kept;
+    if (stats != nullptr) {
+        *stats = local;
+    }
+    return result;
+}
+
+/// @brief Applies a single circuit operation to rho in place.
+/// @param rho Density matrix that is updated in place.
+/// @param op The operation.
+/// @param clbits Classical bits, updated by measurements.
+/// @param rng Random stream measurements draw from.
+void ApplyOperationInPlace(cx_mat& rho, const Operation& op,
+                           vector<int>& clbits, RandomStream& rng) {
+    switch (op.kind) {
+        case OpKind::GATE:
+            if (op.gate != GID) {
+                ApplyGateInPlace(rho, OperationMatrix(op), op.qubits[0]);
+            }
+            break;
+        case OpKind::CGATE:
+            ApplyCGateInPlace(rho, op.gate, op.qubits[0], op.qubits[1]);
+            break;
+        case OpKind::ROTATION:
+            ApplyRotationInPlace(rho, op.gate, op.param, op.qubits[0]);
+            break;
+        case OpKind::CROTATION:
+            ApplyCRotationInPlace(rho, op.gate, op.param, op.qubits[0],
+                                  op.qubits[1]);
+            break;
+        case OpKind::SWAP:
+            ApplySwapInPlace(rho, op.qubits[0], op.qubits[1]);
+            break;
+        case OpKind::UNITARY:
+            ApplyGateInPlace(rho, op.matrix, op.qubits[0]);
+            break;
+        case OpKind::CHANNEL:
+            apply_channel_in_place(
+                rho, u_channel_to_ops_f(op.channel)(op.param), op.qubits[0]);
+            break;
+        case OpKind::MEASURE: {
+            int outcome = MeasureAndCollapse(rho, op.qubits, rng);
+            if (op.clbit >= 0) {
+                clbits.at(op.clbit) = outcome;
+            }
+            break;
+        }
+        case OpKind::RESET:
+            apply_channel_in_place(rho, reset_ops(), op.qubits[0]);
+            break;
+        case OpKind::BARRIER:
+            break;
+    }
+}
+
+/// @brief Runs a whole circuit on rho in place.
+/// @param rho Density matrix of circuit.qubits qubits, updated in place.
+/// @param circuit The circuit, see OptimizeCircuit.
+/// @param rng Random stream measurements draw from.
+/// @return The classical bits after the run.
+vector<int> RunCircuit(cx_mat& rho, const Circuit& circuit,
+                       RandomStream& rng) {
+    if (rho.n_rows != rho.n_cols ||
+        rho.n_rows != arma::uword(1) << circuit.qubits) {
+        throw invalid_argument(
+            "Density matrix of size " + to_string(rho.n_rows) +
+            " does not match a " + to_string(circuit.qubits) +
+            " qubit circuit");
+    }
+    vector<int> clbits(circuit.clbits, 0);
+    for (const Operation& op : circuit.ops) {
+        CheckQubits(op, circuit.qubits);
+        ApplyOperationInPlace(rho, op, clbits, rng);
+    }
+    return clbits;
+}
+} // namespace dmqs
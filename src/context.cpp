@@ -0,0 +1,167 @@
+#include <dmqs/context.hpp>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using std::invalid_argument, std::to_string;
+
+extern "C" void openblas_set_num_threads(int num_threads);
+extern "C" int openblas_get_num_threads(void);
+
+namespace dmqs {
+static thread_local ExecutionContext execution_context;
+
+// Scopes currently holding the process wide OpenBLAS count, and the count
+// to restore once the last of them ends
+static std::mutex blas_scope_mutex;
+static int blas_scopes = 0;
+static int blas_threads_before_scopes = 0;
+
+/// @brief One library thread and one BLAS thread, for workers of an outer
+///        parallel loop.
+ExecutionContext ExecutionContext::Serial() {
+    ExecutionContext context;
+    context.threads = 1;
+    context.blas_threads = 1;
+    return context;
+}
+
+#ifdef __linux__
+static vector<int> ThreadCpus() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    vector<int> cpus;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return cpus;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+#endif
+
+static void PinThread(const vector<int>& cpus) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu < 0 || cpu >= CPU_SETSIZE) {
+            throw invalid_argument("CPU " + to_string(cpu) +
+                                   " is out of range");
+        }
+        CPU_SET(cpu, &set);
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        throw invalid_argument("Cannot pin the thread to the given CPUs");
+    }
+#else
+    (void)cpus;
+#endif
+}
+
+/// @brief Applies context to the calling thread: the OpenMP thread count
+///        of later library loops, the OpenBLAS thread count, the CPU
+///        affinity and the serial threshold. Other threads keep their own
+///        context.
+void SetExecutionContext(const ExecutionContext& context) {
+    if (context.threads < 0 || context.blas_threads < 0 ||
+        context.serial_threshold < 0) {
+        throw invalid_argument("Execution context counts must not be "
+                               "negative");
+    }
+    if (!context.cpus.empty()) {
+        PinThread(context.cpus);
+    }
+#ifdef _OPENMP
+    if (context.threads > 0) {
+        omp_set_num_threads(context.threads);
+    }
+#endif
+    if (context.blas_threads > 0) {
+        openblas_set_num_threads(context.blas_threads);
+    }
+    execution_context = context;
+}
+
+/// @brief The context last applied on the calling thread.
+const ExecutionContext& CurrentExecutionContext() {
+    return execution_context;
+}
+
+/// @brief Threads the library loops of the calling thread may use.
+int LibraryThreads() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/// @brief Threads OpenBLAS uses inside a product.
+int BlasThreads() {
+    return openblas_get_num_threads();
+}
+
+/// @brief Whether a loop over work entries should be split over threads
+///        under the context of the calling thread.
+bool RunInParallel(int64_t work) {
+    return work >= execution_context.serial_threshold &&
+           LibraryThreads() > 1;
+}
+
+ScopedExecutionContext::ScopedExecutionContext(
+    const ExecutionContext& context)
+    : previous_(execution_context), previous_threads_(LibraryThreads()),
+      sets_blas_threads_(context.blas_threads > 0) {
+#ifdef __linux__
+    if (!context.cpus.empty()) {
+        previous_cpus_ = ThreadCpus();
+    }
+#endif
+    if (sets_blas_threads_) {
+        std::lock_guard<std::mutex> lock(blas_scope_mutex);
+        if (blas_scopes == 0) {
+            blas_threads_before_scopes = BlasThreads();
+        }
+        blas_scopes++;
+    }
+    try {
+        SetExecutionContext(context);
+    } catch (...) {
+        if (sets_blas_threads_) {
+            std::lock_guard<std::mutex> lock(blas_scope_mutex);
+            blas_scopes--;
+        }
+        throw;
+    }
+}
+
+ScopedExecutionContext::~ScopedExecutionContext() {
+#ifdef _OPENMP
+    omp_set_num_threads(previous_threads_);
+#endif
+    if (sets_blas_threads_) {
+        std::lock_guard<std::mutex> lock(blas_scope_mutex);
+        if (--blas_scopes == 0) {
+            openblas_set_num_threads(blas_threads_before_scopes);
+        }
+    }
+    if (!previous_cpus_.empty()) {
+        try {
+            PinThread(previous_cpus_);
+        } catch (const std::exception&) {
+            // The thread keeps the narrower affinity
+        }
+    }
+    execution_context = previous_;
+}
+} // namespace dmqs
@@ -0,0 +1,174 @@
+#include <dmqs/diagnostics.hpp>
+#include <dmqs/gates.hpp>
+#include <dmqs/context.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+
+using std::invalid_argument, std::to_string;
+
+namespace dmqs {
+static thread_local int64_t eigendecompositions = 0;
+
+static void CheckSquare(const cx_mat& rho) {
+    if (rho.n_rows != rho.n_cols || rho.n_rows == 0) {
+        throw invalid_argument(
+            "Density matrix must be square not " + to_string(rho.n_rows) +
+            " by " + to_string(rho.n_cols));
+    }
+}
+
+static void CheckSameSize(const cx_mat& rho, const cx_mat& sigma) {
+    CheckSquare(rho);
+    if (sigma.n_rows != rho.n_rows || sigma.n_cols != rho.n_cols) {
+        throw invalid_argument(
+            "Density matrices must have the same size. Got " +
+            to_string(rho.n_rows) + " and " + to_string(sigma.n_rows));
+    }
+}
+
+/// @brief Purity tr(rho^2). For a Hermitian rho this is the squared
+///        Frobenius norm, a single O(4^n) pass instead of a matrix product.
+/// @param rho Density matrix.
+/// @return 1 for pure states, down to 1/2^n for the maximally mixed state.
+double Purity(const cx_mat& rho) {
+    CheckSquare(rho);
+    const cx_double* data = rho.memptr();
+    int64_t size = rho.n_elem;
+    double sum = 0;
+#ifdef _OPENMP
+    #pragma omp parallel for reduction(+ : sum) if (RunInParallel(size))
+#endif
+    for (int64_t i = 0; i < size; i++) {
+        sum += std::norm(data[i]);
+    }
+    return sum;
+}
+
+/// @brief Linear entropy 1 - tr(rho^2).
+double LinearEntropy(const cx_mat& rho) {
+    return 1 - Purity(rho);
+}
+
+/// @brief Fidelity <psi|rho|psi> against a pure reference, streamed over
+///        the columns of rho without forming rho |psi>.
+/// @param rho Density matrix.
+/// @param psi Normalized reference state vector.
+/// @return The fidelity in [0, 1].
+double Fidelity(const cx_mat& rho, const cx_vec& psi) {
+    CheckSquare(rho);
+    if (psi.n_elem != rho.n_rows) {
+        throw invalid_argument(
+            "State vector of size " + to_string(psi.n_elem) +
+            " does not match density matrix of size " +
+            to_string(rho.n_rows));
+    }
+    int64_t dim = rho.n_cols;
+    double sum = 0;
+#ifdef _OPENMP
+    #pragma omp parallel for reduction(+ : sum) \
+        if (RunInParallel(dim * dim))
+#endif
+    for (int64_t j = 0; j < dim; j++) {
+        const cx_double* col = rho.colptr(j);
+        cx_double column = 0;
+        for (int64_t i = 0; i < dim; i++) {
+            column += std::conj(psi(i)) * col[i];
+        }
+        // The imaginary parts cancel for a Hermitian rho
+        sum += (column * psi(j)).real();
+    }
+    return sum;
+}
+
+/// @brief Uhlmann fidelity (tr sqrt(sqrt(rho) sigma sqrt(rho)))^2. The
+///        eigendecomposition of rho is reused across calls.
+/// @param rho Density matrix.
+/// @param sigma Reference density matrix.
+/// @return The fidelity in [0, 1].
+double Fidelity(const cx_mat& rho, const cx_mat& sigma) {
+    CheckSameSize(rho, sigma);
+    const Eigensystem& eig = Eigendecomposition(rho);
+    cx_mat sqrt_rho = eig.vectors;
+    for (arma::uword c = 0; c < sqrt_rho.n_cols; c++) {
+        sqrt_rho.col(c) *= std::sqrt(std::max(eig.values(c), 0.0));
+    }
+    // With sqrt_rho = V D, sqrt(rho) sigma sqrt(rho) = V M V† for
+    // M = D V† sigma V D, so both share their eigenvalues
+    cx_mat M = sqrt_rho.t() * sigma * sqrt_rho;
+    vec values;
+    if (!eig_sym(values, cx_mat(0.5 * (M + M.t())))) {
+        throw invalid_argument("Eigendecomposition failed");
+    }
+    double root = 0;
+    for (double v : values) {
+        root += std::sqrt(std::max(v, 0.0));
+    }
+    return root * root;
+}
+
+/// @brief Trace distance 1/2 ||rho - sigma||_1.
+/// @param rho Density matrix.
+/// @param sigma Reference density matrix.
+/// @return The distance in [0, 1].
+double TraceDistance(const cx_mat& rho, const cx_mat& sigma) {
+    CheckSameSize(rho, sigma);
+    const Eigensystem& eig = Eigendecomposition(rho - sigma);
+    return 0.5 * accu(abs(eig.values));
+}
+
+/// @brief Von Neumann entropy -tr(rho log2 rho) in bits, from the cached
+///        eigenvalues of rho.
+double VonNeumannEntropy(const cx_mat& rho) {
+    const Eigensystem& eig = Eigendecomposition(rho);
+    double entropy = 0;
+    for (double l : eig.values) {
+        if (l > 0) {
+            entropy -= l * std::log2(l);
+        }
+    }
+    return entropy;
+}
+
+/// @brief Eigendecomposition of a Hermitian matrix. The last few results are
+///        kept per thread and returned again for an identical matrix, so
+///        entropy and fidelity queries on an unchanged state only pay the
+///        O(8^n) decomposition once.
+/// @param rho Hermitian matrix.
+/// @return The eigensystem, valid until the next call on this thread.
+const Eigensystem& Eigendecomposition(const cx_mat& rho) {
+    CheckSquare(rho);
+    struct CachedEigensystem {
+        bool valid = false;
+        cx_mat rho;
+        Eigensystem eig;
+    };
+    static thread_local std::array<CachedEigensystem, 4> cache;
+    static thread_local size_t next = 0;
+    for (CachedEigensystem& entry : cache) {
+        if (entry.valid && entry.rho.n_rows == rho.n_rows &&
+            std::equal(rho.begin(), rho.end(), entry.rho.begin())) {
+            return entry.eig;
+        }
+    }
+
+    CachedEigensystem& entry = cache[next];
+    next = (next + 1) % cache.size();
+    entry.valid = false;
+    if (!eig_sym(entry.eig.values, entry.eig.vectors,
+                 cx_mat(0.5 * (rho + rho.t())))) {
+        throw invalid_argument("Eigendecomposition failed");
+    }
+    entry.rho = rho;
+    entry.valid = true;
+    eigendecompositions++;
+    return entry.eig;
+}
+
+/// @brief Number of eigendecompositions computed on this thread, cache hits
+///        are not counted.
+int64_t EigendecompositionCount() {
+    return eigendecompositions;
+}
+} // namespace dmqs
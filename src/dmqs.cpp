@@ -1,4 +1,5 @@
 #include <dmqs/dmqs.hpp>
+#include <dmqs/channels.hpp>
 #include <string>
 #include <functional>
 #include <algorithm>
@@ -63,6 +64,13 @@ cx_mat GateToNQubitSystem(const cx_mat& U1, int target, int n) {
 /// @param U
 /// @return The modified density matrix
 cx_mat ApplyGateToDensityMatrix(const cx_mat& rho, const cx_mat& U) {
+    if (IsDiagonal(U)) {
+        return ApplyDiagonal(rho, cx_vec(U.diag()));
+    }
+    vector<uword> perm;
+    if (IsPermutation(U, perm)) {
+        return ApplyPermutation(rho, perm);
+    }
     return (U * rho) * adjoint(U);
 }
 
@@ -71,12 +79,14 @@ cx_mat ApplyGateToDensityMatrix(const cx_mat& rho, const cx_mat& U) {
 /// @param delta Numerical tolerance for floating point comparisons
 /// @return true if the state is pure, false if mixed
 bool IsPure(const cx_mat& rho, double delta) {
-    // For a pure state: trace(rho²) = 1
-    // This is more efficient than checking rho² = rho
-    cx_double purity = trace(rho * rho);
-    return abs(purity - cx_double(1, 0)) < delta;
+    // For a pure state: trace(rho²) = 1, computed as the squared Frobenius
+    // norm instead of a matrix product
+    return std::abs(Purity(rho) - 1) < delta;
 }
 
+/// @brief Matrix of a fixed 1 qubit gate.
+/// @param gate The gate, rotations need ApplyRotation.
+/// @return The 2x2 unitary.
 cx_mat UGateToGate(u_gate gate) {
     switch (gate) {
         case GX:
@@ -91,6 +101,13 @@ cx_mat UGateToGate(u_gate gate) {
         case GH:
             return H();
             break;
+        case GRX:
+        case GRY:
+        case GRZ:
+            throw invalid_argument(
+                "UGateToGate " + to_string(static_cast<int>(gate))
+                + " is a rotation gate and needs an angle (ApplyRotation)");
+            break;
         default:
             throw invalid_argument(
                 "UGateToGate " + to_string(static_cast<int>(gate))
@@ -99,23 +116,128 @@ cx_mat UGateToGate(u_gate gate) {
     }
 }
 
-cx_mat ApplyGate(const cx_mat& rho, u_gate gate, int qubit) {
+/// @brief Applies a 1 qubit gate to rho in place using the cheapest kernel:
+///        a phase table for diagonal gates (Z, RZ, B0, B1), a basis
+///        permutation for X and the 2x2 block kernel for everything else.
+/// @param rho Density matrix that is updated in place.
+/// @param U1 The 1 qubit gate.
+/// @param qubit The target qubit.
+static void ApplyUnitaryInPlace(cx_mat& rho, const cx_mat& U1, int qubit) {
     int qubit_count = slog2(rho.n_rows);
-    return ApplyGateToDensityMatrix(
-        rho,
-        GateToNQubitSystem(UGateToGate(gate), qubit, qubit_count));
+    if (IsDiagonal(U1)) {
+        ApplyDiagonalInPlace(rho, GateDiagonal(U1, qubit, qubit_count));
+        return;
+    }
+    vector<uword> perm;
+    if (IsPermutation(U1, perm)) {
+        ApplyPermutationInPlace(rho, XPermutation(qubit, qubit_count));
+        return;
+    }
+    ApplyGate1InPlace(rho, U1, qubit);
 }
 
-cx_mat ApplyCGate(const cx_mat& rho, u_gate gate, int control, int target) {
+/// @brief Controlled version of ApplyUnitaryInPlace, controlled diagonal
+///        gates (CZ, CP) use a phase table and CX a basis permutation.
+/// @param rho Density matrix that is updated in place.
+/// @param U1 The 1 qubit gate applied when the control is 1.
+/// @param control The control qubit.
+/// @param target The target qubit.
+static void ApplyCUnitaryInPlace(cx_mat& rho, const cx_mat& U1, int control,
+                                 int target) {
     int qubit_count = slog2(rho.n_rows);
-    cx_mat U = CG(UGateToGate(gate), control, target);
-    int min_qb = min(control, target);
-    if (min_qb > 0)
-        U = kron(Id(min_qb), U);
-    int diff = qubit_count - max(control, target) -1;
-    if (diff > 0)
-        U = kron(U, Id(diff));
-    return ApplyGateToDensityMatrix(rho, U);
+    if (IsDiagonal(U1)) {
+        ApplyDiagonalInPlace(
+            rho,
+            CGateDiagonal(U1, control, target, qubit_count));
+        return;
+    }
+    vector<uword> perm;
+    if (IsPermutation(U1, perm)) {
+        ApplyPermutationInPlace(
+            rho,
+            CXPermutation({control}, target, qubit_count));
+        return;
+    }
+    ApplyCGate1InPlace(rho, U1, control, target);
+}
+
+void ApplyGateInPlace(cx_mat& rho, u_gate gate, int qubit) {
+    ApplyUnitaryInPlace(rho, UGateToGate(gate), qubit);
+}
+
+/// @brief Applies a 1 qubit gate matrix to a qubit of rho in place, taking
+///        the diagonal and permutation fast paths when U1 allows them.
+/// @param rho Density matrix that is updated in place.
+/// @param U1 The 1 qubit gate.
+/// @param qubit The target qubit.
+void ApplyGateInPlace(cx_mat& rho, const cx_mat& U1, int qubit) {
+    ApplyUnitaryInPlace(rho, U1, qubit);
+}
+
+void ApplyCGateInPlace(cx_mat& rho, u_gate gate, int control, int target) {
+    ApplyCUnitaryInPlace(rho, UGateToGate(gate), control, target);
+}
+
+cx_mat ApplyGate(const cx_mat& rho, u_gate gate, int qubit) {
+    cx_mat result = rho;
+    ApplyGateInPlace(result, gate, qubit);
+    return result;
+}
+
+cx_mat ApplyCGate(const cx_mat& rho, u_gate gate, int control, int target) {
+    cx_mat result = rho;
+    ApplyCGateInPlace(result, gate, control, target);
+    return result;
+}
+
+/// @brief Rotates a qubit of rho in place.
+/// @param rho Density matrix that is updated in place.
+/// @param axis The rotation gate GRX, GRY or GRZ.
+/// @param theta Angle in degrees
+/// @param target The qubit to rotate.
+void ApplyRotationInPlace(cx_mat& rho, u_gate axis, double theta,
+                          int target) {
+    ApplyUnitaryInPlace(rho, RotationGate(axis, theta), target);
+}
+
+/// @brief Rotates the target qubit of rho in place when the control is 1.
+/// @param rho Density matrix that is updated in place.
+/// @param axis The rotation gate GRX, GRY or GRZ.
+/// @param theta Angle in degrees
+/// @param control The control qubit.
+/// @param target The qubit to rotate.
+void ApplyCRotationInPlace(cx_mat& rho, u_gate axis, double theta,
+                           int control, int target) {
+    ApplyCUnitaryInPlace(rho, RotationGate(axis, theta), control, target);
+}
+
+cx_mat ApplyRotation(const cx_mat& rho, u_gate axis, double theta,
+                     int target) {
+    cx_mat result = rho;
+    ApplyRotationInPlace(result, axis, theta, target);
+    return result;
+}
+
+cx_mat ApplyCRotation(const cx_mat& rho, u_gate axis, double theta,
+                      int control, int target) {
+    cx_mat result = rho;
+    ApplyCRotationInPlace(result, axis, theta, control, target);
+    return result;
+}
+
+/// @brief Swaps two qubits of rho in place as a basis permutation.
+/// @param rho Density matrix that is updated in place.
+/// @param q1 The index of the first qubit
+/// @param q2 The index of the second qubit
+void ApplySwapInPlace(cx_mat& rho, int q1, int q2) {
+    ApplyPermutationInPlace(rho,
+                            SwapPermutation(q1, q2, slog2(rho.n_rows)));
+}
+
+cx_mat ApplySwap(const cx_mat& rho, int q1, int q2) {
+    cx_mat result = rho;
+    ApplySwapInPlace(result, q1, q2);
+    return result;
 }
 
 int rearrangeBits(int i, const vector<int>& a) {
@@ -202,6 +324,92 @@ cx_mat PartialTrace(const cx_mat& rho, const vector<int>& targets) {
     return result;
 }
 
+static int CheckedQubits(const cx_mat& rho) {
+    if (rho.n_rows != rho.n_cols || rho.n_rows == 0 ||
+        (rho.n_rows & (rho.n_rows - 1)) != 0) {
+        throw invalid_argument(
+            "Density matrix must be a square 2^n matrix not " +
+            to_string(rho.n_rows) + " by " + to_string(rho.n_cols));
+    }
+    return slog2(rho.n_rows);
+}
+
+/// @brief Removes a qubit from rho, shrinking it 4x. Without an outcome the
+///        qubit is traced out; with outcome 0 or 1 the remaining qubits are
+///        first conditioned on the qubit being |outcome⟩, e.g. right after
+///        it was measured. A single pass over the kept entries, no
+///        intermediate matrix.
+/// @param rho Density matrix of n qubits.
+/// @param qubit Qubit to remove.
+/// @param outcome -1 to trace out, or the basis state to project onto.
+/// @return The density matrix of the other n - 1 qubits, in order.
+cx_mat ReleaseQubit(const cx_mat& rho, int qubit, int outcome) {
+    int n = CheckedQubits(rho);
+    if (qubit < 0 || qubit >= n) {
+        throw invalid_argument("Qubit " + to_string(qubit) +
+                               " is outside of a " + to_string(n) +
+                               " qubit system");
+    }
+    if (outcome < -1 || outcome > 1) {
+        throw invalid_argument("Outcome must be -1, 0 or 1 not " +
+                               to_string(outcome));
+    }
+    uword bit = uword(1) << (n - 1 - qubit);
+    uword dim = rho.n_rows / 2;
+    cx_mat result(dim, dim);
+    if (outcome < 0) {
+        for (uword c = 0; c < dim; c++) {
+            uword c0 = InsertBit(c, bit, 0);
+            uword c1 = InsertBit(c, bit, 1);
+            for (uword r = 0; r < dim; r++) {
+                result(r, c) = rho(InsertBit(r, bit, 0), c0) +
+                               rho(InsertBit(r, bit, 1), c1);
+            }
+        }
+        return result;
+    }
+    double p = 0;
+    for (uword i = 0; i < dim; i++) {
+        uword k = InsertBit(i, bit, outcome);
+        p += rho(k, k).real();
+    }
+    if (p <= 0) {
+        throw invalid_argument("Qubit " + to_string(qubit) +
+                               " has no weight on |" + to_string(outcome) +
+                               "⟩");
+    }
+    for (uword c = 0; c < dim; c++) {
+        uword ck = InsertBit(c, bit, outcome);
+        for (uword r = 0; r < dim; r++) {
+            result(r, c) = rho(InsertBit(r, bit, outcome), ck) / p;
+        }
+    }
+    return result;
+}
+
+/// @brief Adds a qubit in |0⟩ to rho, growing it 4x: rho ⊗ |0⟩⟨0| with the
+///        new qubit at position, written straight into the new matrix.
+/// @param rho Density matrix of n qubits, 1x1 for an empty system.
+/// @param position Index of the new qubit, 0 to n.
+/// @return The density matrix of n + 1 qubits.
+cx_mat AllocateQubit(const cx_mat& rho, int position) {
+    int n = CheckedQubits(rho);
+    if (position < 0 || position > n) {
+        throw invalid_argument("Position " + to_string(position) +
+                               " is outside of 0 to " + to_string(n));
+    }
+    uword bit = uword(1) << (n - position);
+    uword dim = rho.n_rows;
+    cx_mat result(2 * dim, 2 * dim, arma::fill::zeros);
+    for (uword c = 0; c < dim; c++) {
+        uword ck = InsertBit(c, bit, 0);
+        for (uword r = 0; r < dim; r++) {
+            result(InsertBit(r, bit, 0), ck) = rho(r, c);
+        }
+    }
+    return result;
+}
+
 /// @brief Projects a basis state on a density matrix
 /// @param rho
 /// @param target
@@ -220,35 +428,149 @@ cx_mat BasisProjection(const cx_mat& rho, int target, int state) {
     return rho_projected;
 }
 
-cx_mat BasisProjections(const cx_mat& rho, const vector<int>& targets,
-                        int state) {
-    int j = 0;
-    int qc = slog2(rho.n_rows);
-    cx_mat U = Id();
-    int bit_pos = targets.size() - j - 1;
-    if (targets[j] == 0) {
-        U = ((1 << bit_pos) & state) ? B1() : B0();
-        j++;
-    }
-    for (int i = 1; i < qc; i++) {
-        bit_pos = targets.size() - j - 1;
-        if (i == targets[j]) {
-            cx_mat B = ((1 << bit_pos) & state) ? B1() : B0();
-            U = kron(U, B);
-            j++;
-        } else {
-            U = kron(U, Id());
+/// @brief Validates a collapse and computes the basis index mask of the
+///        targets and the bits of state under that mask.
+/// @param marginal Probability of every outcome of the targets.
+/// @param targets Qubits to project.
+/// @param state Basis state of the targets.
+/// @param n The total number of qubits in the system.
+/// @param mask Set to the mask of the targets.
+/// @param value Set to the bits of state under mask.
+/// @return The probability of state.
+static double CollapseMask(const vec& marginal, const vector<int>& targets,
+                           int state, int n, uword& mask, uword& value) {
+    if (state < 0 || static_cast<uword>(state) >= marginal.n_elem) {
+        throw invalid_argument(
+            "State " + to_string(state) + " is not a basis state of " +
+            to_string(targets.size()) + " qubits");
+    }
+    double p = marginal(state);
+    if (!(p > 0)) {
+        throw invalid_argument(
+            "Cannot collapse onto state " + to_string(state) +
+            " with probability 0");
+    }
+
+    vector<int> sorted = targets;
+    sort(sorted.begin(), sorted.end());
+    mask = 0;
+    value = 0;
+    for (size_t k = 0; k < sorted.size(); k++) {
+        uword bit = uword(1) << (n - 1 - sorted[k]);
+        mask |= bit;
+        if ((state >> (sorted.size() - 1 - k)) & 1) {
+            value |= bit;
         }
     }
-    cx_mat rho_projected = ApplyGateToDensityMatrix(rho, U);
+    return p;
+}
 
-    // Normalize by trace
-    cx_double trace_val = trace(rho_projected);
-    rho_projected = rho_projected / trace_val;
+/// @brief Projects the targets of rho onto state and renormalizes in place
+///        with an already computed marginal, in a single pass over rho.
+static void ProjectInPlace(cx_mat& rho, const vec& marginal,
+                           const vector<int>& targets, int state) {
+    uword mask = 0;
+    uword value = 0;
+    double p = CollapseMask(marginal, targets, state, slog2(rho.n_rows), mask,
+                            value);
+    for (uword c = 0; c < rho.n_cols; c++) {
+        cx_double* col = rho.colptr(c);
+        if ((c & mask) != value) {
+            std::fill(col, col + rho.n_rows, cx_double(0, 0));
+            continue;
+        }
+        for (uword r = 0; r < rho.n_rows; r++) {
+            col[r] = ((r & mask) == value) ? col[r] / p : cx_double(0, 0);
+        }
+    }
+}
 
+/// @brief Projects the targets of a state vector onto state and
+///        renormalizes it in place with an already computed marginal.
+static void ProjectInPlace(cx_vec& psi, const vec& marginal,
+                           const vector<int>& targets, int state) {
+    uword mask = 0;
+    uword value = 0;
+    double p = CollapseMask(marginal, targets, state, slog2(psi.n_elem), mask,
+                            value);
+    double norm = sqrt(p);
+    for (uword i = 0; i < psi.n_elem; i++) {
+        psi(i) = ((i & mask) == value) ? psi(i) / norm : cx_double(0, 0);
+    }
+}
+
+/// @brief Projects a set of target qubits of rho onto a basis state and
+///        renormalizes in place, in a single pass and without building the
+///        projector. The lowest target is the most significant bit of state.
+/// @param rho Density matrix that is updated in place.
+/// @param targets Qubits to project.
+/// @param state Basis state of the targets.
+void CollapseInPlace(cx_mat& rho, const vector<int>& targets, int state) {
+    ProjectInPlace(rho, MarginalProbabilities(rho, targets), targets, state);
+}
+
+/// @brief Projects the target qubits of a state vector onto a basis state
+///        and renormalizes it in place.
+/// @param psi State vector that is updated in place.
+/// @param targets Qubits to project.
+/// @param state Basis state of the targets.
+void CollapseInPlace(cx_vec& psi, const vector<int>& targets, int state) {
+    vec probabilities = square(abs(psi));
+    ProjectInPlace(psi, MarginalProbabilities(probabilities, targets),
+                   targets, state);
+}
+
+cx_mat BasisProjections(const cx_mat& rho, const vector<int>& targets,
+                        int state) {
+    cx_mat rho_projected = rho;
+    CollapseInPlace(rho_projected, targets, state);
     return rho_projected;
 }
 
+/// @brief Measures a set of target qubits and collapses rho onto the outcome
+///        in place. Marginals are read from the diagonal once and reused for
+///        the renormalization, so no partial trace or projector is built.
+/// @param rho Density matrix that is updated in place.
+/// @param targets Qubits to measure.
+/// @param random Random value for sampling in [0, 1)
+/// @return The outcome, ordered as in PartialSample.
+int MeasureAndCollapse(cx_mat& rho, const vector<int>& targets,
+                       double random) {
+    vec marginal = MarginalProbabilities(rho, targets);
+    int outcome = SampleOutcome(marginal, random);
+    ProjectInPlace(rho, marginal, targets, outcome);
+    return outcome;
+}
+
+/// @brief Measures a set of target qubits of a state vector and collapses
+///        it onto the outcome in place.
+/// @param psi State vector that is updated in place.
+/// @param targets Qubits to measure.
+/// @param random Random value for sampling in [0, 1)
+/// @return The outcome, ordered as in PartialSample.
+int MeasureAndCollapse(cx_vec& psi, const vector<int>& targets,
+                       double random) {
+    vec probabilities = square(abs(psi));
+    vec marginal = MarginalProbabilities(probabilities, targets);
+    int outcome = SampleOutcome(marginal, random);
+    ProjectInPlace(psi, marginal, targets, outcome);
+    return outcome;
+}
+
+/// @brief Measures a set of target qubits and collapses rho onto the outcome
+///        in place, drawing the random value from rng.
+int MeasureAndCollapse(cx_mat& rho, const vector<int>& targets,
+                       RandomStream& rng) {
+    return MeasureAndCollapse(rho, targets, rng.Uniform());
+}
+
+/// @brief Measures a set of target qubits of a state vector and collapses
+///        it onto the outcome in place, drawing the random value from rng.
+int MeasureAndCollapse(cx_vec& psi, const vector<int>& targets,
+                       RandomStream& rng) {
+    return MeasureAndCollapse(psi, targets, rng.Uniform());
+}
+
 /// @brief Samples a set of target qubits from a larger density matrix
 /// @param rho Density matrix to sample from.
 /// @param targets Qubits to sample
@@ -259,6 +581,13 @@ int PartialSample(const cx_mat& rho, const vector<int>& targets,
     return Sample(PartialTrace(rho, targets), random);
 }
 
+/// @brief Samples a set of target qubits from a larger density matrix,
+///        drawing the random value from rng.
+int PartialSample(const cx_mat& rho, const vector<int>& targets,
+                  RandomStream& rng) {
+    return PartialSample(rho, targets, rng.Uniform());
+}
+
 /// @brief Samples a qubit from a larger density matrix
 /// @param rho Density matrix to sample from.
 /// @param target Qubit to sample
@@ -305,6 +634,34 @@ int Sample(const cx_mat& rho, double random) {
     return static_cast<int>(cumulative.n_elem - 1);
 }
 
+/// @brief Gets a sample from the density matrix, drawing the random value
+///        from rng.
+/// @param rho Density matrix to sample from.
+/// @param rng Random stream that is advanced by one value.
+/// @return The sampled basis state.
+int Sample(const cx_mat& rho, RandomStream& rng) {
+    return Sample(rho, rng.Uniform());
+}
+
+/// @brief Applies amplitude dampening and dephasing to a single qubit of rho
+///        in place as seen in: 10.1098/rspa.2008.0439
+///        The channel scales the Bloch vector by exp(-t/T2) in x and y and by
+///        exp(-t/T1) in z, so applying it for t1 and then t2 equals a single
+///        application for t1 + t2.
+/// @param rho Density matrix that is updated in place.
+/// @param qubit The qubit the noise acts on.
+/// @param T1 Energy relaxation time of the qubit
+/// @param T2 Phase choherence time of the qubit
+/// @param t time channel acts upon the qubit
+void ApplyAmplitudeDampeningAndDephasingInPlace(cx_mat& rho, int qubit,
+                                                double T1, double T2,
+                                                double t) {
+    double px = (1 - exp(-t/T1))*0.25;
+    double py = px;
+    double pz = 0.5 - px - (exp(-t/T2)*0.5);
+    ApplySuperop1InPlace(rho, pauli_superop(px, py, pz), qubit);
+}
+
 /// @brief Applies amplitude dampening and dephasing channel as seen in:
 ///        10.1098/rspa.2008.0439
 /// @param rho Density matrix to apply
@@ -315,18 +672,10 @@ int Sample(const cx_mat& rho, double random) {
 cx_mat ApplyAmplitudeDampeningAndDephasing(const cx_mat& rho, const double* T1,
                                            const double* T2, double t) {
     cx_mat temp_state = rho;
-    double n = slog2(rho.n_rows);
+    int n = slog2(rho.n_rows);
     for (int i = 0; i < n; i++) {
-        double px = (1 - exp(-t/T1[i]))*0.25;
-        double py = px;
-        double pz = 0.5 - px - (exp(-t/T2[i])*0.5);
-        cx_mat XN = GateToNQubitSystem(X(), i, n);
-        cx_mat YN = GateToNQubitSystem(Y(), i, n);
-        cx_mat ZN = GateToNQubitSystem(Z(), i, n);
-        temp_state = ((1 - px - py - pz) * temp_state) +
-                     (px * XN * temp_state * XN) +
-                     (py * YN * temp_state * YN) +
-                     (pz * ZN * temp_state * ZN);
+        ApplyAmplitudeDampeningAndDephasingInPlace(temp_state, i, T1[i],
+                                                   T2[i], t);
     }
     return temp_state;
 }
@@ -0,0 +1,192 @@
+#include <dmqs/dynamic.hpp>
+#include <dmqs/dmqs.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using std::invalid_argument, std::to_string;
+
+namespace dmqs {
+/// @brief An empty system, qubits are added with AllocateQubit.
+DynamicState::DynamicState()
+    : rho_(1, 1, arma::fill::ones), allocated_(0), peak_(0) {}
+
+/// @brief A product state in the format of BinaryStringToDensityMatrix,
+///        qubit i of bin gets logical id i.
+DynamicState::DynamicState(const string& bin)
+    : rho_(BinaryStringToDensityMatrix(bin)), allocated_(bin.length()),
+      peak_(bin.length()) {
+    for (int q = 0; q < allocated_; q++) {
+        physical_.push_back(q);
+        live_.push_back(q);
+    }
+}
+
+/// @brief Allocates a qubit in |0⟩. rho only grows once an operation
+///        touches it.
+/// @return The logical id of the qubit.
+int DynamicState::AllocateQubit() {
+    physical_.push_back(kLazy);
+    allocated_++;
+    return static_cast<int>(physical_.size()) - 1;
+}
+
+/// @brief Releases a qubit, tracing it out of rho or, with outcome 0 or 1,
+///        conditioning the other qubits on it, see dmqs::ReleaseQubit. The
+///        id is not reused.
+void DynamicState::ReleaseQubit(int qubit, int outcome) {
+    CheckAllocated(qubit);
+    if (physical_[qubit] >= 0) {
+        Drop(qubit, outcome);
+    } else if (outcome == 1) {
+        throw invalid_argument("Qubit " + to_string(qubit) +
+                               " is |0⟩ and has no weight on |1⟩");
+    }
+    physical_[qubit] = kReleased;
+    allocated_--;
+}
+
+/// @brief Resets a qubit to |0⟩. The reset qubit is unentangled, so it is
+///        traced out of rho and kept in the lazy |0⟩ form until it is used
+///        again.
+void DynamicState::Reset(int qubit) {
+    CheckAllocated(qubit);
+    if (physical_[qubit] >= 0) {
+        Drop(qubit, -1);
+        physical_[qubit] = kLazy;
+    }
+}
+
+/// @brief Whether qubit is allocated and not released.
+bool DynamicState::IsAllocated(int qubit) const {
+    return qubit >= 0 && qubit < static_cast<int>(physical_.size()) &&
+           physical_[qubit] != kReleased;
+}
+
+/// @brief Whether qubit is part of rho, rather than an implicit |0⟩.
+bool DynamicState::IsLive(int qubit) const {
+    return IsAllocated(qubit) && physical_[qubit] >= 0;
+}
+
+int DynamicState::AllocatedQubits() const {
+    return allocated_;
+}
+
+/// @brief Number of qubits in rho, which has 4^LiveQubits() entries.
+int DynamicState::LiveQubits() const {
+    return static_cast<int>(live_.size());
+}
+
+/// @brief The largest number of live qubits so far.
+int DynamicState::PeakLiveQubits() const {
+    return peak_;
+}
+
+/// @brief Logical ids of the qubits of DensityMatrix(), in order.
+const vector<int>& DynamicState::LiveOrder() const {
+    return live_;
+}
+
+/// @brief The density matrix of the live qubits in LiveOrder(). Lazy
+///        qubits are |0⟩ and not part of it.
+const cx_mat& DynamicState::DensityMatrix() const {
+    return rho_;
+}
+
+void DynamicState::ApplyGate(u_gate gate, int target) {
+    ApplyGateInPlace(rho_, gate, Physical(target));
+}
+
+/// @brief Applies a controlled gate. A lazy control is |0⟩, so the gate is
+///        skipped without growing rho.
+void DynamicState::ApplyCGate(u_gate gate, int control, int target) {
+    CheckAllocated(control);
+    CheckAllocated(target);
+    if (control == target) {
+        throw invalid_argument("Control and target must differ");
+    }
+    if (physical_[control] == kLazy) {
+        return;
+    }
+    int t = Physical(target);
+    ApplyCGateInPlace(rho_, gate, physical_[control], t);
+}
+
+void DynamicState::ApplyRotation(u_gate axis, double theta, int target) {
+    ApplyRotationInPlace(rho_, axis, theta, Physical(target));
+}
+
+/// @brief Applies a controlled rotation, skipped for a lazy control.
+void DynamicState::ApplyCRotation(u_gate axis, double theta, int control,
+                                  int target) {
+    CheckAllocated(control);
+    CheckAllocated(target);
+    if (control == target) {
+        throw invalid_argument("Control and target must differ");
+    }
+    if (physical_[control] == kLazy) {
+        return;
+    }
+    int t = Physical(target);
+    ApplyCRotationInPlace(rho_, axis, theta, physical_[control], t);
+}
+
+/// @brief Swaps two qubits by exchanging their logical ids, rho is not
+///        touched.
+void DynamicState::ApplySwap(int q1, int q2) {
+    CheckAllocated(q1);
+    CheckAllocated(q2);
+    std::swap(physical_[q1], physical_[q2]);
+    if (physical_[q1] >= 0) {
+        live_[physical_[q1]] = q1;
+    }
+    if (physical_[q2] >= 0) {
+        live_[physical_[q2]] = q2;
+    }
+}
+
+void DynamicState::ApplyChannel(const vector<kraus_t>& ops, int qubit) {
+    apply_channel_in_place(rho_, ops, Physical(qubit));
+}
+
+/// @brief Measures a qubit and collapses rho. A lazy qubit is |0⟩ and
+///        returns 0 without drawing from rng.
+int DynamicState::Measure(int qubit, RandomStream& rng) {
+    CheckAllocated(qubit);
+    if (physical_[qubit] == kLazy) {
+        return 0;
+    }
+    return MeasureAndCollapse(rho_, {physical_[qubit]}, rng);
+}
+
+/// @brief Physical index of a qubit, tensoring a lazy qubit into rho as
+///        the last physical qubit first.
+int DynamicState::Physical(int qubit) {
+    CheckAllocated(qubit);
+    if (physical_[qubit] == kLazy) {
+        rho_ = dmqs::AllocateQubit(rho_, LiveQubits());
+        physical_[qubit] = LiveQubits();
+        live_.push_back(qubit);
+        peak_ = std::max(peak_, LiveQubits());
+    }
+    return physical_[qubit];
+}
+
+void DynamicState::CheckAllocated(int qubit) const {
+    if (!IsAllocated(qubit)) {
+        throw invalid_argument("Qubit " + to_string(qubit) +
+                               " is not allocated");
+    }
+}
+
+/// @brief Removes a live qubit from rho and renumbers the qubits after it.
+void DynamicState::Drop(int qubit, int outcome) {
+    int p = physical_[qubit];
+    rho_ = dmqs::ReleaseQubit(rho_, p, outcome);
+    live_.erase(live_.begin() + p);
+    for (int i = p; i < LiveQubits(); i++) {
+        physical_[live_[i]] = i;
+    }
+}
+} // namespace dmqs
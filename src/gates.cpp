@@ -1,4 +1,6 @@
 #include <dmqs/gates.hpp>
+#include <array>
+#include <functional>
 
 /// @brief Basis state |0⟩
 gate1_t B0() {
@@ -119,6 +121,61 @@ cx_mat RZ(double theta) {
     return rz_theta;
 }
 
+/// @brief Phase gate (Adds a phase of theta degrees to |1⟩)
+/// @param theta Angle in degrees
+/// @return P gate with a phase theta
+cx_mat P(double theta) {
+    double theta_r = theta * M_PI / 180.0; // Convert to radians
+    cx_mat::fixed<2, 2> p_theta = {
+        {cx_double(1, 0), cx_double(0, 0)},
+        {cx_double(0, 0), std::exp(cx_double(0, theta_r))},
+    };
+    return p_theta;
+}
+
+/// @brief Rotation gate around the axis of a rotation u_gate (GRX, GRY, GRZ).
+///        The most recently built rotations are kept per thread, so repeated
+///        angles reuse their trigonometric values.
+/// @param axis GRX, GRY or GRZ
+/// @param theta Angle in degrees
+/// @return The rotation gate
+gate1_t RotationGate(u_gate axis, double theta) {
+    struct CachedRotation {
+        bool valid = false;
+        u_gate axis = GRX;
+        double theta = 0;
+        gate1_t gate;
+    };
+    static thread_local std::array<CachedRotation, 32> cache;
+    size_t slot = (std::hash<double>{}(theta) + axis) % cache.size();
+    CachedRotation& entry = cache[slot];
+    if (entry.valid && entry.axis == axis && entry.theta == theta) {
+        return entry.gate;
+    }
+
+    gate1_t gate;
+    switch (axis) {
+        case GRX:
+            gate = RX(theta);
+            break;
+        case GRY:
+            gate = RY(theta);
+            break;
+        case GRZ:
+            gate = RZ(theta);
+            break;
+        default:
+            throw invalid_argument(
+                "RotationGate " + to_string(static_cast<int>(axis))
+                + " is not a rotation gate");
+    }
+    entry.valid = true;
+    entry.axis = axis;
+    entry.theta = theta;
+    entry.gate = gate;
+    return gate;
+}
+
 /// @brief Takes an abitrary 1 qubit gate and control and target qubits
 ///        and constructs a controlled version of the gate.
 /// @param gate The gate to apply to the target qubit when the control is 1.
@@ -160,7 +217,19 @@ cx_mat SWAP(int q1, int q2) {
     if (q1 == q2) {
         throw invalid_argument("The qubits to swap has to be different");
     }
-    return CG(X(), q1, q2) * CG(X(), q2, q1) * CG(X(), q1, q2);
+    // The gate spans the qubits from min(q1, q2) to max(q1, q2), where the
+    // first qubit of the span is the most significant bit of the index.
+    int span = abs(q1 - q2) + 1;
+    arma::uword dim = arma::uword(1) << span;
+    arma::uword m1 = arma::uword(1) << (span - 1);
+    arma::uword m2 = 1;
+    cx_mat gate = cx_mat(dim, dim, arma::fill::zeros);
+    for (arma::uword i = 0; i < dim; i++) {
+        bool b1 = (i & m1) != 0;
+        bool b2 = (i & m2) != 0;
+        gate((b1 != b2) ? i ^ (m1 | m2) : i, i) = cx_double(1, 0);
+    }
+    return gate;
 }
 
 /// @brief Hermitian adjoint (dagger)
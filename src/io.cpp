@@ -0,0 +1,410 @@
+#include <dmqs/io.hpp>
+#include <algorithm>
+#include <bit>
+#include <complex>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::invalid_argument, std::runtime_error, std::to_string;
+using std::vector;
+
+namespace dmqs {
+// On disk header, little-endian, followed by zeros up to payload_offset
+struct RawHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t qubits;
+    uint32_t precision;
+    uint32_t layout;
+    uint32_t tile;
+    uint32_t reserved;
+    uint64_t payload_offset;
+    uint64_t payload_bytes;
+    uint64_t checksum;
+};
+static_assert(sizeof(RawHeader) == 56, "State file header must be packed");
+
+static const char kStateMagic[8] = {'D', 'M', 'Q', 'S', 'R', 'H', 'O', 0};
+static const int kMaxFileQubits = 30;
+// Entries written per chunk when the payload is converted on the fly
+static const uint64_t kChunkEntries = 1 << 16;
+
+static void CheckHost() {
+    if constexpr (std::endian::native != std::endian::little) {
+        throw runtime_error("State files require a little-endian host");
+    }
+}
+
+/// @brief FNV-1a over the 64 bit words of the payload. Every layout and
+///        precision has a payload that is a whole number of words.
+static uint64_t Checksum(uint64_t hash, const void* data, uint64_t bytes) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (uint64_t i = 0; i + 8 <= bytes; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, p + i, 8);
+        hash ^= word;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static const uint64_t kChecksumSeed = 0xcbf29ce484222325ULL;
+
+static uint64_t EntryBytes(StatePrecision precision) {
+    return precision == StatePrecision::DOUBLE ? 16 : 8;
+}
+
+static uint64_t EntryCount(StateLayout layout, uint64_t dim) {
+    return layout == StateLayout::PACKED ? dim * (dim + 1) / 2 : dim * dim;
+}
+
+static uint32_t TileEdge(StateLayout layout, uint32_t tile, uint64_t dim) {
+    if (layout != StateLayout::TILED) {
+        return 0;
+    }
+    if (tile == 0 || (tile & (tile - 1)) != 0) {
+        throw invalid_argument("Tile edge must be a power of two not " +
+                               to_string(tile));
+    }
+    return static_cast<uint32_t>(std::min<uint64_t>(tile, dim));
+}
+
+/// @brief Position of entry (row, col) in the payload of a layout. PACKED
+///        only stores row >= col.
+static uint64_t EntryIndex(StateLayout layout, uint64_t tile, uint64_t dim,
+                           uint64_t row, uint64_t col) {
+    switch (layout) {
+        case StateLayout::FULL:
+            return col * dim + row;
+        case StateLayout::PACKED:
+            return col * dim - col * (col - 1) / 2 + (row - col);
+        case StateLayout::TILED: {
+            uint64_t tiles = dim / tile;
+            uint64_t block = (col / tile) * tiles + row / tile;
+            return block * tile * tile + (col % tile) * tile + row % tile;
+        }
+    }
+    throw invalid_argument("Unknown state layout");
+}
+
+/// @brief Entry k of the payload in storage order, the inverse of
+///        EntryIndex.
+static cx_double PayloadEntry(const cx_mat& rho, StateLayout layout,
+                              uint64_t tile, uint64_t k, uint64_t& col,
+                              uint64_t& row) {
+    uint64_t dim = rho.n_rows;
+    switch (layout) {
+        case StateLayout::FULL:
+            return rho(k % dim, k / dim);
+        case StateLayout::PACKED:
+            // Walks the lower triangle; the caller passes k in order
+            if (row >= dim) {
+                col++;
+                row = col;
+            }
+            return rho(row++, col);
+        case StateLayout::TILED: {
+            uint64_t tiles = dim / tile;
+            uint64_t block = k / (tile * tile);
+            uint64_t inside = k % (tile * tile);
+            return rho((block % tiles) * tile + inside % tile,
+                       (block / tiles) * tile + inside / tile);
+        }
+    }
+    throw invalid_argument("Unknown state layout");
+}
+
+static void ValidateHeader(const RawHeader& raw, uint64_t file_size,
+                           const string& path) {
+    if (std::memcmp(raw.magic, kStateMagic, sizeof(kStateMagic)) != 0) {
+        throw invalid_argument(path + " is not a state file");
+    }
+    if (raw.version != kStateFileVersion) {
+        throw invalid_argument(path + " has state file version " +
+                               to_string(raw.version) + ", expected " +
+                               to_string(kStateFileVersion));
+    }
+    if (raw.qubits == 0 || raw.qubits > kMaxFileQubits) {
+        throw invalid_argument(path + " has an invalid qubit count " +
+                               to_string(raw.qubits));
+    }
+    StatePrecision precision = static_cast<StatePrecision>(raw.precision);
+    if (precision != StatePrecision::DOUBLE &&
+        precision != StatePrecision::FLOAT) {
+        throw invalid_argument(path + " has an unknown precision " +
+                               to_string(raw.precision));
+    }
+    StateLayout layout = static_cast<StateLayout>(raw.layout);
+    if (layout != StateLayout::FULL && layout != StateLayout::PACKED &&
+        layout != StateLayout::TILED) {
+        throw invalid_argument(path + " has an unknown layout " +
+                               to_string(raw.layout));
+    }
+    uint64_t dim = uint64_t(1) << raw.qubits;
+    if (layout == StateLayout::TILED &&
+        (raw.tile == 0 || (raw.tile & (raw.tile - 1)) != 0 ||
+         raw.tile > dim)) {
+        throw invalid_argument(path + " has an invalid tile edge " +
+                               to_string(raw.tile));
+    }
+    uint64_t expected = EntryCount(layout, dim) * EntryBytes(precision);
+    if (raw.payload_bytes != expected ||
+        raw.payload_offset % kStatePayloadAlignment != 0 ||
+        raw.payload_offset < sizeof(RawHeader) ||
+        raw.payload_offset + raw.payload_bytes > file_size) {
+        throw invalid_argument(path + " is truncated or has a bad payload");
+    }
+}
+
+static StateFileInfo ToInfo(const RawHeader& raw) {
+    return StateFileInfo{raw.version,
+                         static_cast<int>(raw.qubits),
+                         static_cast<StatePrecision>(raw.precision),
+                         static_cast<StateLayout>(raw.layout),
+                         raw.tile,
+                         raw.payload_offset,
+                         raw.payload_bytes,
+                         raw.checksum};
+}
+
+/// @brief Writes rho to a state file. The payload starts on a page
+///        boundary so MappedState can use it in place.
+/// @param path File to create or overwrite.
+/// @param rho Square density matrix of 2^n rows.
+/// @param layout FULL, PACKED (lower triangle only) or TILED.
+/// @param precision DOUBLE, or FLOAT to halve the file size.
+/// @param tile Tile edge of the TILED layout, a power of two.
+void SaveState(const string& path, const cx_mat& rho, StateLayout layout,
+               StatePrecision precision, uint32_t tile) {
+    CheckHost();
+    uint64_t dim = rho.n_rows;
+    if (rho.n_rows != rho.n_cols || dim < 2 || (dim & (dim - 1)) != 0) {
+        throw invalid_argument(
+            "Density matrix must be square with 2^n rows not " +
+            to_string(rho.n_rows) + " by " + to_string(rho.n_cols));
+    }
+    RawHeader raw{};
+    std::memcpy(raw.magic, kStateMagic, sizeof(kStateMagic));
+    raw.version = kStateFileVersion;
+    raw.qubits = std::countr_zero(dim);
+    raw.precision = static_cast<uint32_t>(precision);
+    raw.layout = static_cast<uint32_t>(layout);
+    raw.tile = TileEdge(layout, tile, dim);
+    raw.payload_offset = kStatePayloadAlignment;
+    raw.payload_bytes = EntryCount(layout, dim) * EntryBytes(precision);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw runtime_error("Cannot open " + path + " for writing");
+    }
+    vector<char> padding(raw.payload_offset, 0);
+    file.write(padding.data(), padding.size());
+
+    uint64_t hash = kChecksumSeed;
+    if (layout == StateLayout::FULL && precision == StatePrecision::DOUBLE) {
+        hash = Checksum(hash, rho.memptr(), raw.payload_bytes);
+        file.write(reinterpret_cast<const char*>(rho.memptr()),
+                   raw.payload_bytes);
+    } else {
+        uint64_t entries = EntryCount(layout, dim);
+        uint64_t col = 0, row = 0;
+        vector<cx_double> doubles;
+        vector<std::complex<float>> floats;
+        for (uint64_t start = 0; start < entries; start += kChunkEntries) {
+            uint64_t count = std::min(kChunkEntries, entries - start);
+            doubles.resize(count);
+            for (uint64_t k = 0; k < count; k++) {
+                doubles[k] = PayloadEntry(rho, layout, raw.tile, start + k,
+                                          col, row);
+            }
+            const char* bytes = reinterpret_cast<const char*>(doubles.data());
+            if (precision == StatePrecision::FLOAT) {
+                floats.assign(doubles.begin(), doubles.end());
+                bytes = reinterpret_cast<const char*>(floats.data());
+            }
+            uint64_t size = count * EntryBytes(precision);
+            hash = Checksum(hash, bytes, size);
+            file.write(bytes, size);
+        }
+    }
+    raw.checksum = hash;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&raw), sizeof(raw));
+    if (!file) {
+        throw runtime_error("Failed writing " + path);
+    }
+}
+
+/// @brief Reads only the header of a state file.
+StateFileInfo ReadStateInfo(const string& path) {
+    CheckHost();
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw runtime_error("Cannot open " + path);
+    }
+    uint64_t size = file.tellg();
+    RawHeader raw{};
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(&raw), sizeof(raw))) {
+        throw invalid_argument(path + " is not a state file");
+    }
+    ValidateHeader(raw, size, path);
+    return ToInfo(raw);
+}
+
+/// @brief Reads a state file of any layout and precision into a full
+///        complex<double> matrix.
+/// @param path State file.
+/// @param verify Check the payload checksum.
+cx_mat LoadState(const string& path, bool verify) {
+    return MappedState(path, verify).Load();
+}
+
+/// @brief Maps a state file. The mapping is copy-on-write, so the matrix
+///        returned by Matrix() can be evolved further without touching
+///        the file.
+/// @param path State file.
+/// @param verify Check the payload checksum, which reads every page.
+MappedState::MappedState(const string& path, bool verify)
+    : info_{}, data_(nullptr), size_(0) {
+    CheckHost();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("Cannot open " + path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < 0 ||
+        static_cast<uint64_t>(st.st_size) < sizeof(RawHeader)) {
+        ::close(fd);
+        throw invalid_argument(path + " is not a state file");
+    }
+    size_ = st.st_size;
+    data_ = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                   0);
+    ::close(fd);
+    if (data_ == MAP_FAILED) {
+        data_ = nullptr;
+        throw runtime_error("Cannot map " + path);
+    }
+    try {
+        RawHeader raw;
+        std::memcpy(&raw, data_, sizeof(raw));
+        ValidateHeader(raw, size_, path);
+        info_ = ToInfo(raw);
+        const char* payload =
+            static_cast<const char*>(data_) + info_.payload_offset;
+        if (verify && Checksum(kChecksumSeed, payload,
+                               info_.payload_bytes) != info_.checksum) {
+            throw invalid_argument(path + " failed its checksum");
+        }
+    } catch (...) {
+        Unmap();
+        throw;
+    }
+    if (info_.layout == StateLayout::FULL &&
+        info_.precision == StatePrecision::DOUBLE) {
+        uword dim = Dimension();
+        view_ = std::make_unique<cx_mat>(
+            reinterpret_cast<cx_double*>(static_cast<char*>(data_) +
+                                         info_.payload_offset),
+            dim, dim, false, true);
+    }
+}
+
+MappedState::~MappedState() {
+    Unmap();
+}
+
+MappedState::MappedState(MappedState&& other) noexcept
+    : info_(other.info_), data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)), view_(std::move(other.view_)) {
+}
+
+MappedState& MappedState::operator=(MappedState&& other) noexcept {
+    if (this != &other) {
+        Unmap();
+        info_ = other.info_;
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        view_ = std::move(other.view_);
+    }
+    return *this;
+}
+
+void MappedState::Unmap() {
+    view_.reset();
+    if (data_ != nullptr) {
+        ::munmap(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+const StateFileInfo& MappedState::Info() const {
+    return info_;
+}
+
+uword MappedState::Dimension() const {
+    return uword(1) << info_.qubits;
+}
+
+/// @brief Entry (row, col) of the mapped state in any layout. The upper
+///        triangle of a PACKED file is the conjugate of the lower one.
+cx_double MappedState::At(uword row, uword col) const {
+    uword dim = Dimension();
+    if (row >= dim || col >= dim) {
+        throw invalid_argument("Entry (" + to_string(row) + ", " +
+                               to_string(col) + ") is outside a " +
+                               to_string(dim) + " by " + to_string(dim) +
+                               " state");
+    }
+    bool conjugate = info_.layout == StateLayout::PACKED && row < col;
+    if (conjugate) {
+        std::swap(row, col);
+    }
+    uint64_t k = EntryIndex(info_.layout, info_.tile, dim, row, col);
+    const char* payload =
+        static_cast<const char*>(data_) + info_.payload_offset;
+    cx_double value;
+    if (info_.precision == StatePrecision::DOUBLE) {
+        std::memcpy(&value, payload + k * 16, 16);
+    } else {
+        std::complex<float> entry;
+        std::memcpy(&entry, payload + k * 8, 8);
+        value = cx_double(entry);
+    }
+    return conjugate ? std::conj(value) : value;
+}
+
+/// @brief The mapped matrix without a copy. Only FULL DOUBLE files can be
+///        viewed in place; use Load for the other layouts.
+cx_mat& MappedState::Matrix() {
+    if (!view_) {
+        throw invalid_argument(
+            "Only FULL DOUBLE state files can be viewed in place");
+    }
+    return *view_;
+}
+
+/// @brief Copies the mapped state into a full complex<double> matrix.
+cx_mat MappedState::Load() const {
+    uword dim = Dimension();
+    if (view_) {
+        return *view_;
+    }
+    cx_mat rho(dim, dim);
+    for (uword col = 0; col < dim; col++) {
+        for (uword row = 0; row < dim; row++) {
+            rho(row, col) = At(row, col);
+        }
+    }
+    return rho;
+}
+} // namespace dmqs
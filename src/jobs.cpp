@@ -0,0 +1,264 @@
+#include <dmqs/jobs.hpp>
+#include <dmqs/dmqs.hpp>
+#include <dmqs/context.hpp>
+#include <dmqs/state.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using std::invalid_argument, std::to_string;
+
+namespace dmqs {
+// The pool and worker the calling thread belongs to, so jobs submitted from
+// inside a job land on the deque of the worker that runs them
+static thread_local const JobPool* current_pool = nullptr;
+static thread_local int current_worker = -1;
+
+/// @brief Starts the workers.
+/// @param workers Number of worker threads, 0 for one per hardware thread.
+/// @param seed Seed of the random streams of every job.
+JobPool::JobPool(int workers, uint64_t seed)
+    : seed_(seed), next_id_(0), next_worker_(0), queued_(0), steals_(0),
+      completed_(0), outstanding_(0), queue_outstanding_(0),
+      stopping_(false) {
+    if (workers < 0) {
+        throw invalid_argument("Worker count must not be negative");
+    }
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (int i = 0; i < workers; i++) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < workers; i++) {
+        workers_[i]->thread = std::thread(&JobPool::Run, this, i);
+    }
+}
+
+/// @brief Runs every job that is still queued, then stops the workers.
+JobPool::~JobPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_.notify_all();
+    for (std::unique_ptr<Worker>& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+/// @brief Queues a job whose result is delivered through the future.
+///        Failures are rethrown by std::future::get.
+std::future<JobResult> JobPool::Submit(Job job) {
+    auto promise = std::make_shared<std::promise<JobResult>>();
+    std::future<JobResult> future = promise->get_future();
+    Push(std::move(job), std::move(promise));
+    return future;
+}
+
+/// @brief Queues a job whose result is delivered to the completion queue,
+///        see NextCompleted.
+/// @return The id of the job, repeated in its JobResult.
+uint64_t JobPool::Enqueue(Job job) {
+    return Push(std::move(job), nullptr);
+}
+
+/// @brief Blocks until a job queued with Enqueue has finished and moves its
+///        result out, in completion order.
+/// @return false when no Enqueue job is left to collect.
+bool JobPool::NextCompleted(JobResult& result) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] {
+        return !completed_results_.empty() || queue_outstanding_ == 0;
+    });
+    if (completed_results_.empty()) {
+        return false;
+    }
+    result = std::move(completed_results_.front());
+    completed_results_.pop_front();
+    queue_outstanding_--;
+    return true;
+}
+
+/// @brief Like NextCompleted, but returns false instead of blocking when
+///        no result is ready.
+bool JobPool::TryNextCompleted(JobResult& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (completed_results_.empty()) {
+        return false;
+    }
+    result = std::move(completed_results_.front());
+    completed_results_.pop_front();
+    queue_outstanding_--;
+    return true;
+}
+
+/// @brief Blocks until every submitted job has finished.
+void JobPool::Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return outstanding_ == 0; });
+}
+
+int JobPool::Workers() const {
+    return static_cast<int>(workers_.size());
+}
+
+/// @brief Number of jobs a worker took from the deque of another worker.
+int64_t JobPool::Steals() const {
+    return steals_;
+}
+
+/// @brief Number of finished jobs, failed ones included.
+int64_t JobPool::Completed() const {
+    return completed_;
+}
+
+uint64_t JobPool::Push(Job job,
+                       std::shared_ptr<std::promise<JobResult>> promise) {
+    if (job.circuit == nullptr) {
+        throw invalid_argument("Job has no circuit");
+    }
+    if (job.shots < 0) {
+        throw invalid_argument("Shot count must be non negative");
+    }
+    uint64_t id = next_id_++;
+    bool queue = promise == nullptr;
+    int index = current_pool == this
+                    ? current_worker
+                    : static_cast<int>(next_worker_++ % workers_.size());
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            throw invalid_argument("Job pool is shutting down");
+        }
+        outstanding_++;
+        if (queue) {
+            queue_outstanding_++;
+        }
+    }
+    {
+        Worker& worker = *workers_[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(Task{id, std::move(job), std::move(promise)});
+    }
+    {
+        // Counted under mutex_ so a worker cannot miss the wake up
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_++;
+    }
+    work_.notify_one();
+    return id;
+}
+
+/// @brief Takes the newest job of worker index, or steals the oldest job
+///        of another worker.
+bool JobPool::Pop(int index, Task& task) {
+    {
+        Worker& own = *workers_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued_--;
+            return true;
+        }
+    }
+    int n = Workers();
+    for (int k = 1; k < n; k++) {
+        Worker& victim = *workers_[(index + k) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued_--;
+            steals_++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobPool::Run(int index) {
+    current_pool = this;
+    current_worker = index;
+    // Scoped, so the process wide BLAS count returns once the pool is gone
+    ScopedExecutionContext serial(ExecutionContext::Serial());
+    cx_mat& arena = workers_[index]->arena;
+    Task task;
+    while (true) {
+        if (Pop(index, task)) {
+            Finish(task, arena);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+        if (stopping_ && queued_ == 0) {
+            return;
+        }
+    }
+}
+
+/// @brief Runs one job in the arena of the worker. The initial product
+///        state is written into the arena in place, so a worker that runs
+///        jobs of the same size never reallocates its density matrix.
+JobResult JobPool::Execute(const Task& task, cx_mat& arena) const {
+    const Circuit& circuit = *task.job.circuit;
+    if (static_cast<int>(task.job.initial.size()) != circuit.qubits) {
+        throw invalid_argument(
+            "State " + task.job.initial + " does not have the " +
+            to_string(circuit.qubits) + " qubits of the circuit");
+    }
+    cx_vec psi = State(task.job.initial).StateVector();
+    uword dim = psi.n_elem;
+    arena.set_size(dim, dim);
+    for (uword j = 0; j < dim; j++) {
+        cx_double conj_j = std::conj(psi(j));
+        cx_double* col = arena.colptr(j);
+        for (uword i = 0; i < dim; i++) {
+            col[i] = psi(i) * conj_j;
+        }
+    }
+
+    JobResult result;
+    result.id = task.id;
+    RandomStream rng(seed_, 2 * task.id);
+    result.clbits = RunCircuit(arena, circuit, rng);
+    result.probabilities = Probabilities(arena);
+    if (task.job.shots > 0) {
+        RandomStream shots(seed_, 2 * task.id + 1);
+        vector<int> outcomes = SampleShots(arena, task.job.shots, shots);
+        result.counts = Histogram(outcomes, static_cast<int>(dim));
+    }
+    return result;
+}
+
+void JobPool::Finish(Task& task, cx_mat& arena) {
+    JobResult result;
+    std::exception_ptr error;
+    try {
+        result = Execute(task, arena);
+    } catch (const std::exception& e) {
+        error = std::current_exception();
+        result.id = task.id;
+        result.error = e.what();
+    }
+    if (task.promise != nullptr) {
+        if (error) {
+            task.promise->set_exception(error);
+        } else {
+            task.promise->set_value(std::move(result));
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (task.promise == nullptr) {
+            completed_results_.push_back(std::move(result));
+        }
+        outstanding_--;
+        completed_++;
+    }
+    task = Task{};
+    done_.notify_all();
+}
+} // namespace dmqs
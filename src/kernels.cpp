@@ -0,0 +1,720 @@
+#include <dmqs/kernels.hpp>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <utility>
+
+using std::invalid_argument, std::to_string, std::conj, std::swap;
+
+namespace dmqs {
+/// @brief Bit mask of a qubit in a basis index (qubit 0 is the MSB).
+/// @param qubit The index of the qubit.
+/// @param n The total number of qubits in the system.
+/// @return Mask with only the bit of the qubit set.
+static uword QubitMask(int qubit, int n) {
+    if (qubit < 0 || qubit >= n) {
+        throw invalid_argument(
+            "Qubit " + to_string(qubit) + " is outside of a " +
+            to_string(n) + " qubit system");
+    }
+    return uword(1) << (n - 1 - qubit);
+}
+
+static thread_local RepairPolicy repair_policy;
+static thread_local RepairCounters repair_counters;
+
+/// @brief Sets when the kernels repair rho while they pass over it. The
+///        policy and the counters are kept per thread.
+/// @param policy Repair every interval passes and/or whenever the trace is
+///        off by more than threshold. Zero disables either trigger.
+void SetRepairPolicy(const RepairPolicy& policy) {
+    if (policy.interval < 0 || policy.threshold < 0) {
+        throw invalid_argument(
+            "Repair interval and threshold must not be negative");
+    }
+    repair_policy = policy;
+}
+
+/// @brief The repair policy of this thread.
+const RepairPolicy& CurrentRepairPolicy() {
+    return repair_policy;
+}
+
+/// @brief How often and how much the kernels have repaired on this thread.
+const RepairCounters& Repairs() {
+    return repair_counters;
+}
+
+/// @brief Resets the repair counters of this thread.
+void ResetRepairs() {
+    repair_counters = RepairCounters();
+}
+
+/// @brief Counts a kernel pass and decides whether it should repair rho.
+///        Only the diagonal is read here, O(2^n) next to the O(4^n) pass.
+/// @param rho Density matrix the pass is about to update.
+/// @param scale Set to the factor that brings the trace of rho back to 1.
+/// @return Whether the pass should repair rho.
+template <typename eT>
+static bool RepairDue(const arma::Mat<eT>& rho, double& scale) {
+    repair_counters.passes++;
+    const RepairPolicy& policy = repair_policy;
+    bool due = policy.interval > 0 &&
+               repair_counters.passes % policy.interval == 0;
+    if (!due && policy.threshold == 0) {
+        return false;
+    }
+    double tr = 0;
+    for (uword i = 0; i < rho.n_rows; i++) {
+        tr += std::real(rho(i, i));
+    }
+    due = due || std::abs(tr - 1) > policy.threshold;
+    if (!due) {
+        return false;
+    }
+    scale = tr > 0 ? 1 / tr : 1;
+    repair_counters.repairs++;
+    repair_counters.trace_correction += std::abs(1 - scale);
+    return true;
+}
+
+/// @brief Replaces the mirrored entries x = rho(r, c) and y = rho(c, r) by
+///        their Hermitian part scaled by scale.
+/// @param removed Accumulates the squared norm of the removed part.
+static void RepairPair(cx_double& x, cx_double& y, double scale,
+                       double& removed) {
+    cx_double h = 0.5 * (x + conj(y));
+    removed += 2 * std::norm(x - h);
+    x = scale * h;
+    y = scale * conj(h);
+}
+
+/// @brief Replaces the mirrored entries of a real rho by their symmetric
+///        part scaled by scale.
+static void RepairPair(double& x, double& y, double scale, double& removed) {
+    double h = 0.5 * (x + y);
+    removed += 2 * (x - h) * (x - h);
+    x = scale * h;
+    y = scale * h;
+}
+
+/// @brief Keeps the real part of a diagonal entry, scaled by scale.
+static void RepairDiagonal(cx_double& x, double scale, double& removed) {
+    removed += x.imag() * x.imag();
+    x = scale * x.real();
+}
+
+static void RepairDiagonal(double& x, double scale, double&) {
+    x *= scale;
+}
+
+static cx_double Conjugate(const cx_double& x) {
+    return conj(x);
+}
+
+static double Conjugate(double x) {
+    return x;
+}
+
+/// @brief Books the anti-Hermitian part removed by a repair pass.
+static void FinishRepair(double removed) {
+    repair_counters.hermiticity_correction += std::sqrt(removed);
+}
+
+/// @brief Checks if a matrix only has non zero entries on its diagonal.
+/// @param U The matrix to check.
+/// @return Whether U is a square diagonal matrix.
+bool IsDiagonal(const cx_mat& U) {
+    if (U.n_rows != U.n_cols) {
+        return false;
+    }
+    for (uword c = 0; c < U.n_cols; c++) {
+        const cx_double* col = U.colptr(c);
+        for (uword r = 0; r < U.n_rows; r++) {
+            if (r != c && col[r] != cx_double(0, 0)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// @brief Phase table of a diagonal 1 qubit gate acting on a target qubit
+///        in an n-qubit system. Tables of commuting diagonal gates can be
+///        fused with an elementwise product (%) before being applied.
+/// @param U1 Diagonal 1 qubit gate.
+/// @param target The qubit the gate acts on.
+/// @param n The total number of qubits in the system.
+/// @return The diagonal of the n-qubit gate.
+cx_vec GateDiagonal(const cx_mat& U1, int target, int n) {
+    if (U1.n_rows != 2 || !IsDiagonal(U1)) {
+        throw invalid_argument("GateDiagonal expects a diagonal 1 qubit gate");
+    }
+    uword mask = QubitMask(target, n);
+    uword dim = uword(1) << n;
+    cx_double d0 = U1(0, 0);
+    cx_double d1 = U1(1, 1);
+    cx_vec phases(dim);
+    for (uword i = 0; i < dim; i++) {
+        phases(i) = (i & mask) ? d1 : d0;
+    }
+    return phases;
+}
+
+/// @brief Phase table of a controlled diagonal 1 qubit gate in an n-qubit
+///        system.
+/// @param U1 Diagonal 1 qubit gate applied when the control is 1.
+/// @param control The control qubit.
+/// @param target The target qubit.
+/// @param n The total number of qubits in the system.
+/// @return The diagonal of the n-qubit controlled gate.
+cx_vec CGateDiagonal(const cx_mat& U1, int control, int target, int n) {
+    if (control == target) {
+        throw invalid_argument("Control and target qubit must be different");
+    }
+    if (U1.n_rows != 2 || !IsDiagonal(U1)) {
+        throw invalid_argument(
+            "CGateDiagonal expects a diagonal 1 qubit gate");
+    }
+    uword control_mask = QubitMask(control, n);
+    uword target_mask = QubitMask(target, n);
+    uword dim = uword(1) << n;
+    cx_double d0 = U1(0, 0);
+    cx_double d1 = U1(1, 1);
+    cx_vec phases(dim);
+    for (uword i = 0; i < dim; i++) {
+        if (i & control_mask) {
+            phases(i) = (i & target_mask) ? d1 : d0;
+        } else {
+            phases(i) = cx_double(1, 0);
+        }
+    }
+    return phases;
+}
+
+/// @brief Checks if every entry of a phase table has modulus 1, i.e. the
+///        diagonal gate is unitary and not a projection like B0 or B1.
+static bool IsUnitaryDiagonal(const cx_vec& phases) {
+    for (uword i = 0; i < phases.n_elem; i++) {
+        if (std::abs(std::norm(phases(i)) - 1) > 1e-12) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Conjugates rho by a diagonal gate D, i.e. D * rho * D^†, in a
+///        single streaming pass: rho(r, c) *= phases(r) * conj(phases(c)).
+///        Projections change the trace, so they never repair rho.
+/// @param rho Density matrix that is updated in place.
+/// @param phases The diagonal of D.
+void ApplyDiagonalInPlace(cx_mat& rho, const cx_vec& phases) {
+    uword dim = rho.n_rows;
+    if (rho.n_cols != dim || phases.n_elem != dim) {
+        throw invalid_argument(
+            "Phase table of size " + to_string(phases.n_elem) +
+            " does not match density matrix of size " + to_string(dim));
+    }
+    const cx_double* d = phases.memptr();
+    double scale;
+    if (!IsUnitaryDiagonal(phases) || !RepairDue(rho, scale)) {
+        for (uword c = 0; c < dim; c++) {
+            const cx_double dc = conj(d[c]);
+            cx_double* col = rho.colptr(c);
+            for (uword r = 0; r < dim; r++) {
+                col[r] *= d[r] * dc;
+            }
+        }
+        return;
+    }
+    // Visit rho(r, c) together with its mirror rho(c, r)
+    double removed = 0;
+    for (uword c = 0; c < dim; c++) {
+        const cx_double dc = conj(d[c]);
+        cx_double* col = rho.colptr(c);
+        for (uword r = 0; r < c; r++) {
+            cx_double& mirror = rho(c, r);
+            col[r] *= d[r] * dc;
+            mirror *= d[c] * conj(d[r]);
+            RepairPair(col[r], mirror, scale, removed);
+        }
+        col[c] *= std::norm(d[c]);
+        RepairDiagonal(col[c], scale, removed);
+    }
+    FinishRepair(removed);
+}
+
+/// @brief Applies a diagonal gate given by its phase table to rho.
+/// @param rho
+/// @param phases The diagonal of the gate.
+/// @return The modified density matrix
+cx_mat ApplyDiagonal(const cx_mat& rho, const cx_vec& phases) {
+    cx_mat result = rho;
+    ApplyDiagonalInPlace(result, phases);
+    return result;
+}
+
+/// @brief Checks if a matrix is a basis permutation, i.e. every column holds
+///        a single 1 and every row is hit exactly once.
+/// @param U The matrix to check.
+/// @param perm Filled with the permutation, U|i⟩ = |perm[i]⟩.
+/// @return Whether U is a permutation matrix.
+bool IsPermutation(const cx_mat& U, vector<uword>& perm) {
+    if (U.n_rows != U.n_cols) {
+        return false;
+    }
+    uword dim = U.n_rows;
+    vector<bool> hit(dim, false);
+    perm.assign(dim, 0);
+    for (uword c = 0; c < dim; c++) {
+        const cx_double* col = U.colptr(c);
+        bool found = false;
+        for (uword r = 0; r < dim; r++) {
+            if (col[r] == cx_double(0, 0)) {
+                continue;
+            }
+            if (found || hit[r] || col[r] != cx_double(1, 0)) {
+                return false;
+            }
+            found = true;
+            hit[r] = true;
+            perm[c] = r;
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Permutation of an X gate on a target qubit in an n-qubit system.
+/// @param target The qubit to flip.
+/// @param n The total number of qubits in the system.
+/// @return The basis permutation of the gate.
+vector<uword> XPermutation(int target, int n) {
+    return CXPermutation({}, target, n);
+}
+
+/// @brief Permutation of a multi controlled X gate (CX, Toffoli, ...) in an
+///        n-qubit system.
+/// @param controls The qubits that all have to be 1 for the target to flip.
+/// @param target The qubit to flip.
+/// @param n The total number of qubits in the system.
+/// @return The basis permutation of the gate.
+vector<uword> CXPermutation(const vector<int>& controls, int target, int n) {
+    uword target_mask = QubitMask(target, n);
+    uword control_mask = 0;
+    for (int c : controls) {
+        if (c == target) {
+            throw invalid_argument(
+                "Control and target qubit must be different");
+        }
+        control_mask |= QubitMask(c, n);
+    }
+    uword dim = uword(1) << n;
+    vector<uword> perm(dim);
+    for (uword i = 0; i < dim; i++) {
+        perm[i] = ((i & control_mask) == control_mask) ? i ^ target_mask : i;
+    }
+    return perm;
+}
+
+/// @brief Permutation of a SWAP gate in an n-qubit system.
+/// @param q1 The index of the first qubit
+/// @param q2 The index of the second qubit
+/// @param n The total number of qubits in the system.
+/// @return The basis permutation of the gate.
+vector<uword> SwapPermutation(int q1, int q2, int n) {
+    if (q1 == q2) {
+        throw invalid_argument("The qubits to swap has to be different");
+    }
+    uword m1 = QubitMask(q1, n);
+    uword m2 = QubitMask(q2, n);
+    uword dim = uword(1) << n;
+    vector<uword> perm(dim);
+    for (uword i = 0; i < dim; i++) {
+        bool b1 = (i & m1) != 0;
+        bool b2 = (i & m2) != 0;
+        perm[i] = (b1 != b2) ? i ^ (m1 | m2) : i;
+    }
+    return perm;
+}
+
+/// @brief Splits a permutation into its non trivial cycles, each listed as
+///        c0, perm[c0], perm[perm[c0]], ...
+static vector<vector<uword>> PermutationCycles(const vector<uword>& perm) {
+    uword dim = perm.size();
+    vector<bool> visited(dim, false);
+    vector<vector<uword>> cycles;
+    for (uword i = 0; i < dim; i++) {
+        if (visited[i] || perm[i] == i) {
+            visited[i] = true;
+            continue;
+        }
+        vector<uword> cycle;
+        for (uword j = i; !visited[j]; j = perm[j]) {
+            if (perm[j] >= dim) {
+                throw invalid_argument("Permutation index out of range");
+            }
+            visited[j] = true;
+            cycle.push_back(j);
+        }
+        if (perm[cycle.back()] != i) {
+            throw invalid_argument("Permutation is not a bijection");
+        }
+        cycles.push_back(cycle);
+    }
+    return cycles;
+}
+
+/// @brief Conjugates rho by a permutation gate P in place using swaps only,
+///        rho(perm[r], perm[c]) = rho(r, c). Rows are permuted inside each
+///        contiguous column before whole columns are swapped.
+/// @param rho Density matrix that is updated in place.
+/// @param perm The basis permutation, P|i⟩ = |perm[i]⟩.
+void ApplyPermutationInPlace(cx_mat& rho, const vector<uword>& perm) {
+    uword dim = rho.n_rows;
+    if (rho.n_cols != dim || perm.size() != dim) {
+        throw invalid_argument(
+            "Permutation of size " + to_string(perm.size()) +
+            " does not match density matrix of size " + to_string(dim));
+    }
+    vector<vector<uword>> cycles = PermutationCycles(perm);
+    if (cycles.empty()) {
+        return;
+    }
+    for (uword c = 0; c < dim; c++) {
+        cx_double* col = rho.colptr(c);
+        for (const vector<uword>& cycle : cycles) {
+            for (size_t j = cycle.size() - 1; j > 0; j--) {
+                swap(col[cycle[j]], col[cycle[j - 1]]);
+            }
+        }
+    }
+    for (const vector<uword>& cycle : cycles) {
+        for (size_t j = cycle.size() - 1; j > 0; j--) {
+            rho.swap_cols(cycle[j], cycle[j - 1]);
+        }
+    }
+}
+
+/// @brief Applies a permutation gate to rho.
+/// @param rho
+/// @param perm The basis permutation of the gate.
+/// @return The modified density matrix
+cx_mat ApplyPermutation(const cx_mat& rho, const vector<uword>& perm) {
+    cx_mat result = rho;
+    ApplyPermutationInPlace(result, perm);
+    return result;
+}
+
+/// @brief Spreads the bits of k around the bit at the position of mask and
+///        sets that bit to value, so k = 0, 1, ... enumerates all indices
+///        where the masked bit equals value.
+/// @param k Index without the masked bit.
+/// @param mask Single bit mask, e.g. QubitMask of a qubit.
+/// @param value 0 or 1.
+uword InsertBit(uword k, uword mask, uword value) {
+    uword low = k & (mask - 1);
+    return ((k ^ low) << 1) | (value ? mask : 0) | low;
+}
+
+/// @brief Repairs a 2x2 block on the diagonal of rho, [b00, b10, b01, b11].
+template <typename eT>
+static void RepairDiagonalBlock(eT* b, double scale, double& removed) {
+    RepairDiagonal(b[0], scale, removed);
+    RepairPair(b[1], b[2], scale, removed);
+    RepairDiagonal(b[3], scale, removed);
+}
+
+/// @brief Repairs a 2x2 block b and its mirror block m across the diagonal
+///        of rho, both stored as [b00, b10, b01, b11].
+template <typename eT>
+static void RepairMirroredBlocks(eT* b, eT* m, double scale,
+                                 double& removed) {
+    RepairPair(b[0], m[0], scale, removed);
+    RepairPair(b[1], m[2], scale, removed);
+    RepairPair(b[2], m[1], scale, removed);
+    RepairPair(b[3], m[3], scale, removed);
+}
+
+/// @brief Runs transform over every 2x2 block [b00, b10, b01, b11] of rows
+///        and columns differing only in the target bit, reading and writing
+///        each block once. Blocks whose row and column miss a control bit
+///        are skipped. When a repair is due each block is visited together
+///        with its mirror block, so the trace rescaling and the removal of
+///        the anti-Hermitian part happen in the same pass.
+/// @param rho Density matrix that is updated in place.
+/// @param target_mask Mask of the target qubit.
+/// @param control_mask Mask of the control qubits, 0 if uncontrolled.
+/// @param transform Called as transform(b, row_on, col_on).
+template <typename eT, typename Transform>
+static void Apply2x2BlocksInPlace(arma::Mat<eT>& rho, uword target_mask,
+                                  uword control_mask, Transform transform) {
+    uword half = rho.n_rows >> 1;
+    double scale;
+    bool repair = RepairDue(rho, scale);
+    double removed = 0;
+    for (uword jc = 0; jc < half; jc++) {
+        uword j0 = InsertBit(jc, target_mask, 0);
+        uword j1 = j0 | target_mask;
+        bool col_on = (j0 & control_mask) == control_mask;
+        eT* a0 = rho.colptr(j0);
+        eT* a1 = rho.colptr(j1);
+        uword rows = repair ? jc + 1 : half;
+        for (uword ic = 0; ic < rows; ic++) {
+            uword i0 = InsertBit(ic, target_mask, 0);
+            uword i1 = i0 | target_mask;
+            bool row_on = (i0 & control_mask) == control_mask;
+            if (!repair && !row_on && !col_on) {
+                continue;
+            }
+            eT b[4] = {a0[i0], a0[i1], a1[i0], a1[i1]};
+            transform(b, row_on, col_on);
+            if (repair && ic == jc) {
+                RepairDiagonalBlock(b, scale, removed);
+            } else if (repair) {
+                eT* m0 = rho.colptr(i0);
+                eT* m1 = rho.colptr(i1);
+                eT m[4] = {m0[j0], m0[j1], m1[j0], m1[j1]};
+                transform(m, col_on, row_on);
+                RepairMirroredBlocks(b, m, scale, removed);
+                m0[j0] = m[0];
+                m0[j1] = m[1];
+                m1[j0] = m[2];
+                m1[j1] = m[3];
+            }
+            a0[i0] = b[0];
+            a0[i1] = b[1];
+            a1[i0] = b[2];
+            a1[i1] = b[3];
+        }
+    }
+    if (repair) {
+        FinishRepair(removed);
+    }
+}
+
+/// @brief Conjugates rho by a (controlled) 1 qubit gate in place. Every
+///        2x2 block of rows/columns differing only in the target bit is
+///        loaded once, multiplied by U from the left and U^† from the right
+///        and stored, so the whole update is a single pass over rho.
+/// @param rho Density matrix that is updated in place.
+/// @param U1 The 1 qubit gate.
+/// @param target_mask Mask of the target qubit.
+/// @param control_mask Mask of the control qubits, 0 if uncontrolled.
+template <typename eT>
+static void Conjugate2x2InPlace(arma::Mat<eT>& rho, const arma::Mat<eT>& U1,
+                                uword target_mask, uword control_mask) {
+    if (U1.n_rows != 2 || U1.n_cols != 2) {
+        throw invalid_argument("Expected a 1 qubit gate");
+    }
+    const eT u00 = U1(0, 0), u01 = U1(0, 1);
+    const eT u10 = U1(1, 0), u11 = U1(1, 1);
+    const eT c00 = Conjugate(u00), c01 = Conjugate(u01);
+    const eT c10 = Conjugate(u10), c11 = Conjugate(u11);
+    auto conjugate = [&](eT* b, bool row_on, bool col_on) {
+        eT b00 = b[0], b10 = b[1], b01 = b[2], b11 = b[3];
+        if (row_on) {
+            eT t00 = u00 * b00 + u01 * b10;
+            eT t10 = u10 * b00 + u11 * b10;
+            eT t01 = u00 * b01 + u01 * b11;
+            eT t11 = u10 * b01 + u11 * b11;
+            b00 = t00;
+            b10 = t10;
+            b01 = t01;
+            b11 = t11;
+        }
+        if (col_on) {
+            eT t00 = b00 * c00 + b01 * c01;
+            eT t01 = b00 * c10 + b01 * c11;
+            eT t10 = b10 * c00 + b11 * c01;
+            eT t11 = b10 * c10 + b11 * c11;
+            b00 = t00;
+            b10 = t10;
+            b01 = t01;
+            b11 = t11;
+        }
+        b[0] = b00;
+        b[1] = b10;
+        b[2] = b01;
+        b[3] = b11;
+    };
+    Apply2x2BlocksInPlace(rho, target_mask, control_mask, conjugate);
+}
+
+/// @brief Applies a 1 qubit gate to a target qubit of rho in place without
+///        building the n-qubit gate.
+/// @param rho Density matrix that is updated in place.
+/// @param U1 The 1 qubit gate.
+/// @param target The target qubit.
+void ApplyGate1InPlace(cx_mat& rho, const cx_mat& U1, int target) {
+    Conjugate2x2InPlace(rho, U1, QubitMask(target, slog2(rho.n_rows)), 0);
+}
+
+/// @brief Applies a controlled 1 qubit gate to rho in place without building
+///        the n-qubit gate.
+/// @param rho Density matrix that is updated in place.
+/// @param U1 The 1 qubit gate applied when the control is 1.
+/// @param control The control qubit.
+/// @param target The target qubit.
+void ApplyCGate1InPlace(cx_mat& rho, const cx_mat& U1, int control,
+                        int target) {
+    if (control == target) {
+        throw invalid_argument("Control and target qubit must be different");
+    }
+    int n = slog2(rho.n_rows);
+    Conjugate2x2InPlace(rho, U1, QubitMask(target, n), QubitMask(control, n));
+}
+
+/// @brief Applies a 1 qubit channel, given as a superoperator, to a target
+///        qubit of rho in place. Like the gate kernel every 2x2 block is
+///        read and written once.
+/// @param rho Density matrix that is updated in place.
+/// @param S Superoperator of the channel.
+/// @param target The qubit the channel acts on.
+void ApplySuperop1InPlace(cx_mat& rho, const superop1_t& S, int target) {
+    uword target_mask = QubitMask(target, slog2(rho.n_rows));
+    auto apply = [&S](cx_double* b, bool, bool) {
+        const cx_double v[4] = {b[0], b[1], b[2], b[3]};
+        for (int k = 0; k < 4; k++) {
+            b[k] = S(k, 0) * v[0] + S(k, 1) * v[1] +
+                   S(k, 2) * v[2] + S(k, 3) * v[3];
+        }
+    };
+    Apply2x2BlocksInPlace(rho, target_mask, 0, apply);
+}
+
+/// @brief Real version of ApplyGate1InPlace for a real rho and gate, half
+///        the memory traffic and a quarter of the multiplications.
+/// @param rho Real density matrix that is updated in place.
+/// @param U1 The real 1 qubit gate.
+/// @param target The target qubit.
+void ApplyGate1InPlace(mat& rho, const mat& U1, int target) {
+    Conjugate2x2InPlace(rho, U1, QubitMask(target, slog2(rho.n_rows)), 0);
+}
+
+/// @brief Real version of ApplyCGate1InPlace.
+/// @param rho Real density matrix that is updated in place.
+/// @param U1 The real 1 qubit gate applied when the control is 1.
+/// @param control The control qubit.
+/// @param target The target qubit.
+void ApplyCGate1InPlace(mat& rho, const mat& U1, int control, int target) {
+    if (control == target) {
+        throw invalid_argument("Control and target qubit must be different");
+    }
+    int n = slog2(rho.n_rows);
+    Conjugate2x2InPlace(rho, U1, QubitMask(target, n), QubitMask(control, n));
+}
+
+/// @brief Real version of ApplySuperop1InPlace, for channels and gates
+///        whose superoperator is real even if their Kraus operators are
+///        not, e.g. Y or depolarizing.
+/// @param rho Real density matrix that is updated in place.
+/// @param S Real superoperator of the channel.
+/// @param target The qubit the channel acts on.
+void ApplySuperop1InPlace(mat& rho, const real_superop1_t& S, int target) {
+    uword target_mask = QubitMask(target, slog2(rho.n_rows));
+    auto apply = [&S](double* b, bool, bool) {
+        const double v[4] = {b[0], b[1], b[2], b[3]};
+        for (int k = 0; k < 4; k++) {
+            b[k] = S(k, 0) * v[0] + S(k, 1) * v[1] +
+                   S(k, 2) * v[2] + S(k, 3) * v[3];
+        }
+    };
+    Apply2x2BlocksInPlace(rho, target_mask, 0, apply);
+}
+
+/// @brief Multiplies every pair of rows of A differing only in the target
+///        bit by U1, skipping pairs whose control bits are not all set. A
+///        state vector is the single column case.
+static void Apply2x2ToRowsInPlace(cx_mat& A, const cx_mat& U1,
+                                  uword target_mask, uword control_mask) {
+    if (U1.n_rows != 2 || U1.n_cols != 2) {
+        throw invalid_argument("Expected a 1 qubit gate");
+    }
+    const cx_double u00 = U1(0, 0), u01 = U1(0, 1);
+    const cx_double u10 = U1(1, 0), u11 = U1(1, 1);
+    uword half = A.n_rows >> 1;
+    for (uword c = 0; c < A.n_cols; c++) {
+        cx_double* col = A.colptr(c);
+        for (uword k = 0; k < half; k++) {
+            uword i0 = InsertBit(k, target_mask, 0);
+            if ((i0 & control_mask) != control_mask) {
+                continue;
+            }
+            uword i1 = i0 | target_mask;
+            cx_double a0 = col[i0];
+            cx_double a1 = col[i1];
+            col[i0] = u00 * a0 + u01 * a1;
+            col[i1] = u10 * a0 + u11 * a1;
+        }
+    }
+}
+
+/// @brief Applies a 1 qubit gate to a target qubit of a state vector in
+///        place.
+/// @param psi State vector that is updated in place.
+/// @param U1 The 1 qubit gate.
+/// @param target The target qubit.
+void ApplyGate1ToVectorInPlace(cx_vec& psi, const cx_mat& U1, int target) {
+    ApplyGate1ToColumnsInPlace(psi, U1, target);
+}
+
+/// @brief Applies a controlled 1 qubit gate to a state vector in place.
+/// @param psi State vector that is updated in place.
+/// @param U1 The 1 qubit gate applied when the control is 1.
+/// @param control The control qubit.
+/// @param target The target qubit.
+void ApplyCGate1ToVectorInPlace(cx_vec& psi, const cx_mat& U1, int control,
+                                int target) {
+    ApplyCGate1ToColumnsInPlace(psi, U1, control, target);
+}
+
+/// @brief Moves amplitude i of a state vector to perm[i] in place.
+/// @param psi State vector that is updated in place.
+/// @param perm Permutation of the basis states.
+void ApplyPermutationToVectorInPlace(cx_vec& psi,
+                                     const vector<uword>& perm) {
+    ApplyPermutationToRowsInPlace(psi, perm);
+}
+
+/// @brief Applies a 1 qubit gate to every column of A in place, e.g the
+///        factor L of rho = L L†.
+/// @param A Matrix whose columns are state vectors.
+/// @param U1 The 1 qubit gate.
+/// @param target The target qubit.
+void ApplyGate1ToColumnsInPlace(cx_mat& A, const cx_mat& U1, int target) {
+    Apply2x2ToRowsInPlace(A, U1, QubitMask(target, slog2(A.n_rows)), 0);
+}
+
+/// @brief Applies a controlled 1 qubit gate to every column of A in place.
+/// @param A Matrix whose columns are state vectors.
+/// @param U1 The 1 qubit gate applied when the control is 1.
+/// @param control The control qubit.
+/// @param target The target qubit.
+void ApplyCGate1ToColumnsInPlace(cx_mat& A, const cx_mat& U1, int control,
+                                 int target) {
+    if (control == target) {
+        throw invalid_argument("Control and target qubit must be different");
+    }
+    int n = slog2(A.n_rows);
+    Apply2x2ToRowsInPlace(A, U1, QubitMask(target, n), QubitMask(control, n));
+}
+
+/// @brief Moves row i of A to row perm[i] in place, one cycle at a time.
+/// @param A Matrix whose columns are state vectors.
+/// @param perm Permutation of the basis states.
+void ApplyPermutationToRowsInPlace(cx_mat& A, const vector<uword>& perm) {
+    if (perm.size() != A.n_rows) {
+        throw invalid_argument(
+            "Permutation of size " + to_string(perm.size()) +
+            " does not match " + to_string(A.n_rows) + " rows");
+    }
+    for (const vector<uword>& cycle : PermutationCycles(perm)) {
+        for (size_t j = cycle.size() - 1; j > 0; j--) {
+            A.swap_rows(cycle[j], cycle[j - 1]);
+        }
+    }
+}
+} // namespace dmqs
@@ -0,0 +1,212 @@
+#include <dmqs/lindblad.hpp>
+#include <dmqs/dmqs.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace dmqs {
+// Cached propagators are dropped once this many distinct dt have been seen
+static const size_t kMaxCachedPropagators = 16;
+
+/// @brief Creates the generator of a Lindblad master equation.
+/// @param H Hamiltonian of the whole system.
+/// @param collapse_ops Collapse operators of the whole system, rates
+///        included, e.g sqrt(1/T1) |0><1|.
+/// @param tolerance Absolute error per step of the adaptive integrator.
+Lindbladian::Lindbladian(const cx_mat& H, const vector<cx_mat>& collapse_ops,
+                         double tolerance)
+    : H_(H), L_(collapse_ops), tolerance_(tolerance) {
+    if (H.n_rows != H.n_cols || H.n_rows == 0 ||
+        (H.n_rows & (H.n_rows - 1)) != 0) {
+        throw invalid_argument(
+            "Hamiltonian must be a square 2^n x 2^n matrix");
+    }
+    if (!(tolerance > 0)) {
+        throw invalid_argument("Tolerance must be positive");
+    }
+    // -iH - 1/2 sum L†L, so that L(rho) = Heff rho + rho Heff† + sum L rho L†
+    Heff_ = cx_double(0, -1) * H;
+    for (const cx_mat& L : L_) {
+        if (L.n_rows != H.n_rows || L.n_cols != H.n_cols) {
+            throw invalid_argument(
+                "Collapse operators must have the size of the Hamiltonian");
+        }
+        Heff_ -= 0.5 * (L.t() * L);
+    }
+}
+
+/// @brief Evaluates the right hand side of the master equation.
+/// @param rho Density matrix.
+/// @return d rho/dt.
+cx_mat Lindbladian::Derivative(const cx_mat& rho) const {
+    cx_mat half = Heff_ * rho;
+    cx_mat d = half + half.t();
+    for (const cx_mat& L : L_) {
+        d += (L * rho) * L.t();
+    }
+    return d;
+}
+
+/// @brief Builds the superoperator acting on the column-major vectorized
+///        density matrix, vec(A X B) = (B^T ⊗ A) vec(X).
+/// @return The 4^n x 4^n generator.
+cx_mat Lindbladian::Superoperator() const {
+    cx_mat I = cx_mat(H_.n_rows, H_.n_cols, arma::fill::eye);
+    cx_mat S = kron(I, Heff_) + kron(conj(Heff_), I);
+    for (const cx_mat& L : L_) {
+        S += kron(conj(L), L);
+    }
+    return S;
+}
+
+/// @brief Exact propagator exp(L dt), computed once per dt.
+/// @param dt Time step.
+/// @return The 4^n x 4^n propagator.
+const cx_mat& Lindbladian::Propagator(double dt) {
+    auto it = propagators_.find(dt);
+    if (it != propagators_.end()) {
+        return it->second;
+    }
+    if (propagators_.size() >= kMaxCachedPropagators) {
+        propagators_.clear();
+    }
+    return propagators_.emplace(dt, expmat(Superoperator() * dt))
+        .first->second;
+}
+
+/// @brief Evolves rho in place with the adaptive Dormand-Prince method.
+/// @param rho Density matrix to evolve.
+/// @param t Evolution time.
+void Lindbladian::IntegrateInPlace(cx_mat& rho, double t) const {
+    CheckState(rho);
+    // Dormand-Prince 5(4) tableau, the last stage is the next first stage
+    static const double a21 = 1.0 / 5;
+    static const double a31 = 3.0 / 40, a32 = 9.0 / 40;
+    static const double a41 = 44.0 / 45, a42 = -56.0 / 15, a43 = 32.0 / 9;
+    static const double a51 = 19372.0 / 6561, a52 = -25360.0 / 2187,
+                        a53 = 64448.0 / 6561, a54 = -212.0 / 729;
+    static const double a61 = 9017.0 / 3168, a62 = -355.0 / 33,
+                        a63 = 46732.0 / 5247, a64 = 49.0 / 176,
+                        a65 = -5103.0 / 18656;
+    static const double b1 = 35.0 / 384, b3 = 500.0 / 1113,
+                        b4 = 125.0 / 192, b5 = -2187.0 / 6784,
+                        b6 = 11.0 / 84;
+    static const double e1 = 71.0 / 57600, e3 = -71.0 / 16695,
+                        e4 = 71.0 / 1920, e5 = -17253.0 / 339200,
+                        e6 = 22.0 / 525, e7 = -1.0 / 40;
+
+    double elapsed = 0;
+    double h = t;
+    cx_mat k1 = Derivative(rho);
+    while (elapsed < t) {
+        h = std::min(h, t - elapsed);
+        cx_mat k2 = Derivative(rho + h * (a21 * k1));
+        cx_mat k3 = Derivative(rho + h * (a31 * k1 + a32 * k2));
+        cx_mat k4 = Derivative(rho + h * (a41 * k1 + a42 * k2 + a43 * k3));
+        cx_mat k5 = Derivative(rho + h * (a51 * k1 + a52 * k2 + a53 * k3 +
+                                          a54 * k4));
+        cx_mat k6 = Derivative(rho + h * (a61 * k1 + a62 * k2 + a63 * k3 +
+                                          a64 * k4 + a65 * k5));
+        cx_mat next = rho + h * (b1 * k1 + b3 * k3 + b4 * k4 + b5 * k5 +
+                                 b6 * k6);
+        cx_mat k7 = Derivative(next);
+        double err = abs(h * (e1 * k1 + e3 * k3 + e4 * k4 + e5 * k5 +
+                              e6 * k6 + e7 * k7)).max();
+        if (!std::isfinite(err) || elapsed + h == elapsed) {
+            throw std::runtime_error(
+                "Lindblad integration failed at t = " + to_string(elapsed));
+        }
+        if (err <= tolerance_) {
+            elapsed += h;
+            rho = std::move(next);
+            k1 = std::move(k7);
+        }
+        double factor = err == 0 ? 5.0 :
+                        0.9 * std::pow(tolerance_ / err, 0.2);
+        h *= std::clamp(factor, 0.2, 5.0);
+    }
+}
+
+/// @brief Evolves rho in place for a time t. Systems of up to
+///        kExactQubitLimit qubits use the cached exact propagator.
+/// @param rho Density matrix to evolve.
+/// @param t Evolution time.
+void Lindbladian::EvolveInPlace(cx_mat& rho, double t) {
+    if (t < 0) {
+        throw invalid_argument("Evolution time must be non negative");
+    }
+    CheckState(rho);
+    if (t == 0) {
+        return;
+    }
+    if (slog2(rho.n_rows) > kExactQubitLimit) {
+        IntegrateInPlace(rho, t);
+        return;
+    }
+    cx_mat evolved = Propagator(t) * arma::vectorise(rho);
+    evolved.reshape(rho.n_rows, rho.n_cols);
+    rho = std::move(evolved);
+}
+
+/// @brief Evolves rho for a time t.
+/// @param rho Density matrix to evolve.
+/// @param t Evolution time.
+/// @return The evolved density matrix.
+cx_mat Lindbladian::Evolve(const cx_mat& rho, double t) {
+    cx_mat result = rho;
+    EvolveInPlace(result, t);
+    return result;
+}
+
+/// @brief Number of distinct dt with a cached propagator.
+size_t Lindbladian::CachedPropagators() const {
+    return propagators_.size();
+}
+
+void Lindbladian::CheckState(const cx_mat& rho) const {
+    if (rho.n_rows != H_.n_rows || rho.n_cols != H_.n_cols) {
+        throw invalid_argument(
+            "Density matrix is " + to_string(rho.n_rows) + "x" +
+            to_string(rho.n_cols) + ", the Hamiltonian " +
+            to_string(H_.n_rows) + "x" + to_string(H_.n_cols));
+    }
+}
+
+/// @brief Free evolution under energy relaxation towards |0> and pure
+///        dephasing: L = sqrt(1/T1) |0><1| and
+///        sqrt((1/T2 - 1/(2 T1)) / 2) Z on every qubit.
+/// @param T1 Energy relaxation times (1 per qubit)
+/// @param T2 Phase choherence times (1 per qubit), at most 2 T1.
+/// @return The Lindbladian of the idle system.
+Lindbladian AmplitudeDampingAndDephasingLindbladian(const vector<double>& T1,
+                                                    const vector<double>& T2) {
+    if (T1.size() != T2.size() || T1.empty()) {
+        throw invalid_argument(
+            "T1 and T2 should have a value per qubit. Got " +
+            to_string(T1.size()) + " and " + to_string(T2.size()));
+    }
+    int n = T1.size();
+    // |0><1|
+    const cx_mat lower = {
+        {cx_double(0, 0), cx_double(1, 0)},
+        {cx_double(0, 0), cx_double(0, 0)},
+    };
+    vector<cx_mat> ops;
+    for (int q = 0; q < n; q++) {
+        double dephasing = 1 / T2[q] - 1 / (2 * T1[q]);
+        if (dephasing < 0) {
+            throw invalid_argument(
+                "T2 can be at most 2 T1. Got T1 = " + to_string(T1[q]) +
+                " and T2 = " + to_string(T2[q]) + " on qubit " +
+                to_string(q));
+        }
+        ops.push_back(GateToNQubitSystem(sqrt(1 / T1[q]) * lower, q, n));
+        if (dephasing > 0) {
+            ops.push_back(GateToNQubitSystem(sqrt(dephasing / 2) * Z(), q, n));
+        }
+    }
+    return Lindbladian(cx_mat(1 << n, 1 << n, zeros), ops);
+}
+} // namespace dmqs
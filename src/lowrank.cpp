@@ -0,0 +1,281 @@
+#include <dmqs/lowrank.hpp>
+#include <dmqs/dmqs.hpp>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace dmqs {
+/// @brief Creates a rank 1 product state from a binary string in the format
+///        of BinaryStringToDensityMatrix.
+/// @param bin A string of 0, 1, + and - e.g "0+1"
+/// @param tolerance Discarded weight allowed per recompression.
+/// @param max_rank Maximum rank kept after a channel.
+LowRankState::LowRankState(const string& bin, double tolerance,
+                           uword max_rank)
+    : n_(bin.length()), tolerance_(tolerance), max_rank_(max_rank),
+      truncation_error_(0) {
+    if (bin.empty()) {
+        throw invalid_argument("A state needs at least 1 qubit");
+    }
+    if (max_rank == 0) {
+        throw invalid_argument("The maximum rank must be at least 1");
+    }
+    double h = 1 / sqrt(2);
+    cx_vec psi = {cx_double(1, 0)};
+    for (char c : bin) {
+        cx_vec q;
+        if (c == '0') {
+            q = {cx_double(1, 0), cx_double(0, 0)};
+        } else if (c == '1') {
+            q = {cx_double(0, 0), cx_double(1, 0)};
+        } else if (c == '+') {
+            q = {cx_double(h, 0), cx_double(h, 0)};
+        } else if (c == '-') {
+            q = {cx_double(h, 0), cx_double(-h, 0)};
+        } else {
+            throw invalid_argument(
+                "Invalid basis state '" + string(1, c) + "' in " + bin);
+        }
+        psi = kron(psi, q);
+    }
+    L_ = psi;
+}
+
+LowRankState::LowRankState(const char* bin, double tolerance,
+                           uword max_rank)
+    : LowRankState(string(bin), tolerance, max_rank) {}
+
+/// @brief Factorizes a density matrix through its eigendecomposition.
+/// @param rho Density matrix.
+/// @param tolerance Discarded weight allowed per recompression.
+/// @param max_rank Maximum rank kept after a channel.
+LowRankState::LowRankState(const cx_mat& rho, double tolerance,
+                           uword max_rank)
+    : n_(slog2(rho.n_rows)), tolerance_(tolerance), max_rank_(max_rank),
+      truncation_error_(0) {
+    if (rho.n_rows < 2 || rho.n_rows != rho.n_cols ||
+        (uword(1) << n_) != rho.n_rows) {
+        throw invalid_argument("Density matrix must be a square 2^n matrix");
+    }
+    if (max_rank == 0) {
+        throw invalid_argument("The maximum rank must be at least 1");
+    }
+    vec eigval;
+    cx_mat eigvec;
+    if (!eig_sym(eigval, eigvec, cx_mat(0.5 * (rho + rho.t())))) {
+        throw invalid_argument("Eigendecomposition of rho failed");
+    }
+    eigval.clamp(0, arma::datum::inf);
+    L_ = eigvec;
+    for (uword c = 0; c < L_.n_cols; c++) {
+        L_.col(c) *= sqrt(eigval(c));
+    }
+    Recompress();
+}
+
+/// @brief Number of qubits in the system.
+int LowRankState::Qubits() const {
+    return n_;
+}
+
+/// @brief Number of columns of L.
+uword LowRankState::Rank() const {
+    return L_.n_cols;
+}
+
+/// @brief The factor L of rho = L L†.
+const cx_mat& LowRankState::Factor() const {
+    return L_;
+}
+
+/// @brief Builds the full density matrix L L†.
+cx_mat LowRankState::DensityMatrix() const {
+    return L_ * L_.t();
+}
+
+/// @brief Weight (relative to the trace) discarded by all recompressions.
+double LowRankState::TruncationError() const {
+    return truncation_error_;
+}
+
+/// @brief Measurement probabilities of every basis state, the row norms of
+///        L.
+vec LowRankState::Probabilities() const {
+    return sum(square(abs(L_)), 1);
+}
+
+/// @brief Reduced density matrix of the target qubits, Tr_B(L L†) summed
+///        column by column without building rho. Ordered as PartialTrace.
+/// @param targets Qubits to keep.
+/// @return The density matrix of the targets.
+cx_mat LowRankState::PartialTrace(const vector<int>& targets) const {
+    vector<int> sorted = targets;
+    sort(sorted.begin(), sorted.end());
+    if (sorted.empty()) {
+        throw invalid_argument("There should be atleast 1 target");
+    }
+    for (size_t i = 0; i < sorted.size(); i++) {
+        if (sorted[i] < 0 || sorted[i] >= n_ ||
+            (i > 0 && sorted[i] == sorted[i - 1])) {
+            throw invalid_argument(
+                "Targets should be unique and in [0, " + to_string(n_) +
+                "). Got " + to_string(sorted[i]));
+        }
+    }
+
+    uword dim = L_.n_rows;
+    uword kept = uword(1) << sorted.size();
+    uword rest = dim / kept;
+    // Row of the basis state in the targets and in the traced qubits
+    vector<uword> a(dim, 0);
+    vector<uword> b(dim, 0);
+    for (uword i = 0; i < dim; i++) {
+        size_t next = 0;
+        for (int q = 0; q < n_; q++) {
+            uword bit = (i >> (n_ - 1 - q)) & 1;
+            if (next < sorted.size() && sorted[next] == q) {
+                a[i] = (a[i] << 1) | bit;
+                next++;
+            } else {
+                b[i] = (b[i] << 1) | bit;
+            }
+        }
+    }
+    cx_mat result = cx_mat(kept, kept, zeros);
+    cx_mat M = cx_mat(kept, rest);
+    for (uword c = 0; c < L_.n_cols; c++) {
+        for (uword i = 0; i < dim; i++) {
+            M(a[i], b[i]) = L_(i, c);
+        }
+        result += M * M.t();
+    }
+    return result;
+}
+
+/// @brief Applies a 1 qubit gate matrix to the rows of L.
+void LowRankState::ApplyGate(const cx_mat& U1, int target) {
+    ApplyGate1ToColumnsInPlace(L_, U1, target);
+}
+
+void LowRankState::ApplyGate(u_gate gate, int target) {
+    ApplyGate1ToColumnsInPlace(L_, UGateToGate(gate), target);
+}
+
+void LowRankState::ApplyCGate(u_gate gate, int control, int target) {
+    ApplyCGate1ToColumnsInPlace(L_, UGateToGate(gate), control, target);
+}
+
+void LowRankState::ApplyRotation(u_gate axis, double theta, int target) {
+    ApplyGate1ToColumnsInPlace(L_, RotationGate(axis, theta), target);
+}
+
+void LowRankState::ApplyCRotation(u_gate axis, double theta, int control,
+                                  int target) {
+    ApplyCGate1ToColumnsInPlace(L_, RotationGate(axis, theta), control,
+                                target);
+}
+
+void LowRankState::ApplySwap(int q1, int q2) {
+    ApplyPermutationToRowsInPlace(L_, SwapPermutation(q1, q2, n_));
+}
+
+/// @brief Applies a 1 qubit channel: L becomes [K_1 L, K_2 L, ...] and is
+///        recompressed to the lowest rank within tolerance.
+/// @param ops Kraus operators.
+/// @param qubit The qubit the channel acts on.
+void LowRankState::ApplyChannel(const vector<kraus_t>& ops, int qubit) {
+    if (ops.empty()) {
+        throw invalid_argument("A channel needs at least 1 Kraus operator");
+    }
+    uword rank = L_.n_cols;
+    cx_mat stacked = cx_mat(L_.n_rows, rank * ops.size());
+    for (size_t k = 0; k < ops.size(); k++) {
+        cx_mat block = L_;
+        ApplyGate1ToColumnsInPlace(block, ops[k], qubit);
+        stacked.cols(k * rank, (k + 1) * rank - 1) = block;
+    }
+    L_ = std::move(stacked);
+    Recompress();
+}
+
+/// @brief Samples all qubits, see dmqs::Sample.
+int LowRankState::Sample(double random) const {
+    return SampleOutcome(Probabilities(), random);
+}
+
+/// @brief Samples all qubits, drawing the random value from rng.
+int LowRankState::Sample(RandomStream& rng) const {
+    return Sample(rng.Uniform());
+}
+
+/// @brief Measures a set of target qubits and collapses the state in place,
+///        see dmqs::MeasureAndCollapse. The projector is applied to the rows
+///        of L, so the rank never grows.
+int LowRankState::MeasureAndCollapse(const vector<int>& targets,
+                                     double random) {
+    vec marginal = MarginalProbabilities(Probabilities(), targets);
+    int outcome = SampleOutcome(marginal, random);
+    vector<int> sorted = targets;
+    sort(sorted.begin(), sorted.end());
+    uword mask = 0;
+    uword value = 0;
+    for (size_t k = 0; k < sorted.size(); k++) {
+        uword bit = uword(1) << (n_ - 1 - sorted[k]);
+        mask |= bit;
+        if ((outcome >> (sorted.size() - 1 - k)) & 1) {
+            value |= bit;
+        }
+    }
+    double scale = sqrt(marginal(outcome));
+    for (uword c = 0; c < L_.n_cols; c++) {
+        cx_double* col = L_.colptr(c);
+        for (uword r = 0; r < L_.n_rows; r++) {
+            col[r] = ((r & mask) == value) ? col[r] / scale : cx_double(0, 0);
+        }
+    }
+    Recompress();
+    return outcome;
+}
+
+/// @brief Measures a set of target qubits and collapses the state in place,
+///        drawing the random value from rng.
+int LowRankState::MeasureAndCollapse(const vector<int>& targets,
+                                     RandomStream& rng) {
+    return MeasureAndCollapse(targets, rng.Uniform());
+}
+
+/// @brief Truncated SVD of L keeping the fewest singular values whose
+///        discarded weight is within tolerance, at most max_rank of them.
+///        The kept factor is rescaled to the original trace.
+void LowRankState::Recompress() {
+    cx_mat U;
+    vec s;
+    cx_mat V;
+    if (!svd_econ(U, s, V, L_, "left")) {
+        throw invalid_argument("SVD of the low rank factor failed");
+    }
+    vec weights = square(s);
+    double total = accu(weights);
+    if (!(total > 0)) {
+        throw invalid_argument("Low rank state has a zero trace");
+    }
+    uword rank = std::min<uword>(weights.n_elem, max_rank_);
+    double discarded = 0;
+    for (uword i = rank; i < weights.n_elem; i++) {
+        discarded += weights(i);
+    }
+    while (rank > 1 && discarded + weights(rank - 1) <= tolerance_ * total) {
+        rank--;
+        discarded += weights(rank);
+    }
+    truncation_error_ += discarded / total;
+    L_ = U.head_cols(rank);
+    for (uword c = 0; c < rank; c++) {
+        L_.col(c) *= s(c);
+    }
+    if (discarded > 0) {
+        L_ *= sqrt(total / (total - discarded));
+    }
+}
+} // namespace dmqs
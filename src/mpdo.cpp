@@ -0,0 +1,422 @@
+#include <dmqs/mpdo.hpp>
+#include <dmqs/dmqs.hpp>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+using arma::size;
+
+namespace dmqs {
+/// @brief Index of the two site operator |r1 r2><c1 c2| in the column-major
+///        vectorized 4x4 matrix, from the local indices p = row + 2 col.
+static uword PairIndex(uword p1, uword p2) {
+    uword row = ((p1 & 1) << 1) | (p2 & 1);
+    uword col = ((p1 >> 1) << 1) | (p2 >> 1);
+    return row + 4 * col;
+}
+
+/// @brief Creates a product state from a binary string in the format of
+///        BinaryStringToDensityMatrix, every bond has dimension 1.
+/// @param bin A string of 0, 1, + and - e.g "0+1"
+/// @param max_bond Maximum bond dimension kept after a two site update.
+/// @param cutoff Singular values below cutoff times the largest are dropped.
+MPDO::MPDO(const string& bin, uword max_bond, double cutoff)
+    : n_(bin.length()), max_bond_(max_bond), cutoff_(cutoff),
+      truncation_error_(0) {
+    if (bin.empty()) {
+        throw invalid_argument("A state needs at least 1 qubit");
+    }
+    if (max_bond == 0) {
+        throw invalid_argument("The maximum bond dimension must be at least 1");
+    }
+    for (char c : bin) {
+        cx_cube site = cx_cube(1, 1, 4, arma::fill::zeros);
+        if (c == '0') {
+            site(0, 0, 0) = 1;
+        } else if (c == '1') {
+            site(0, 0, 3) = 1;
+        } else if (c == '+' || c == '-') {
+            double sign = c == '+' ? 0.5 : -0.5;
+            site(0, 0, 0) = 0.5;
+            site(0, 0, 1) = sign;
+            site(0, 0, 2) = sign;
+            site(0, 0, 3) = 0.5;
+        } else {
+            throw invalid_argument(
+                "Invalid basis state '" + string(1, c) + "' in " + bin);
+        }
+        sites_.push_back(site);
+    }
+}
+
+/// @brief Number of qubits in the chain.
+int MPDO::Qubits() const {
+    return n_;
+}
+
+/// @brief Dimension of the bond between qubit bond and bond + 1.
+uword MPDO::BondDimension(int bond) const {
+    if (bond < 0 || bond >= n_ - 1) {
+        throw invalid_argument(
+            "Bond " + to_string(bond) + " is outside of a " + to_string(n_) +
+            " qubit chain");
+    }
+    return sites_[bond].n_cols;
+}
+
+/// @brief Largest bond dimension in the chain.
+uword MPDO::MaxBondDimension() const {
+    uword max_bond = 1;
+    for (const cx_cube& site : sites_) {
+        max_bond = std::max(max_bond, site.n_cols);
+    }
+    return max_bond;
+}
+
+/// @brief Weight (relative to the Frobenius norm of the split tensor)
+///        discarded by all truncations.
+double MPDO::TruncationError() const {
+    return truncation_error_;
+}
+
+/// @brief Trace of rho, 1 up to truncation errors.
+double MPDO::Trace() const {
+    cx_mat env = cx_mat(1, 1, arma::fill::ones);
+    for (int i = 0; i < n_; i++) {
+        env = env * SiteTrace(i);
+    }
+    return env(0, 0).real();
+}
+
+/// @brief Reduced density matrix of the target qubits, contracted site by
+///        site without building rho. Ordered as dmqs::PartialTrace.
+/// @param targets Qubits to keep.
+/// @return The density matrix of the targets.
+cx_mat MPDO::PartialTrace(const vector<int>& targets) const {
+    vector<int> sorted = targets;
+    sort(sorted.begin(), sorted.end());
+    if (sorted.empty()) {
+        throw invalid_argument("There should be atleast 1 target");
+    }
+    for (size_t i = 0; i < sorted.size(); i++) {
+        if (sorted[i] < 0 || sorted[i] >= n_ ||
+            (i > 0 && sorted[i] == sorted[i - 1])) {
+            throw invalid_argument(
+                "Targets should be unique and in [0, " + to_string(n_) +
+                "). Got " + to_string(sorted[i]));
+        }
+    }
+
+    // One left environment per assignment of the local indices of the
+    // targets seen so far, the first target is the most significant digit
+    vector<cx_mat> envs = {cx_mat(1, 1, arma::fill::ones)};
+    size_t next = 0;
+    for (int i = 0; i < n_; i++) {
+        if (next < sorted.size() && sorted[next] == i) {
+            vector<cx_mat> expanded;
+            expanded.reserve(envs.size() * 4);
+            for (const cx_mat& env : envs) {
+                for (uword p = 0; p < 4; p++) {
+                    expanded.push_back(env * sites_[i].slice(p));
+                }
+            }
+            envs = std::move(expanded);
+            next++;
+        } else {
+            cx_mat T = SiteTrace(i);
+            for (cx_mat& env : envs) {
+                env = env * T;
+            }
+        }
+    }
+
+    uword kept = uword(1) << sorted.size();
+    cx_mat result = cx_mat(kept, kept, zeros);
+    for (uword e = 0; e < envs.size(); e++) {
+        uword row = 0;
+        uword col = 0;
+        for (size_t k = 0; k < sorted.size(); k++) {
+            uword p = (e >> (2 * (sorted.size() - 1 - k))) & 3;
+            row = (row << 1) | (p & 1);
+            col = (col << 1) | (p >> 1);
+        }
+        result(row, col) = envs[e](0, 0);
+    }
+    return result;
+}
+
+/// @brief Builds the full density matrix, only feasible for small chains.
+cx_mat MPDO::DensityMatrix() const {
+    vector<int> all(n_);
+    for (int q = 0; q < n_; q++) {
+        all[q] = q;
+    }
+    return PartialTrace(all);
+}
+
+/// @brief Applies a 1 qubit gate to a single site.
+/// @param U1 The 1 qubit gate.
+/// @param target The target qubit.
+void MPDO::ApplyGate(const cx_mat& U1, int target) {
+    CheckQubit(target);
+    if (U1.n_rows != 2 || U1.n_cols != 2) {
+        throw invalid_argument("Expected a 1 qubit gate");
+    }
+    ApplySite(kraus_to_superop({kraus_t(U1)}), target);
+}
+
+void MPDO::ApplyGate(u_gate gate, int target) {
+    ApplyGate(UGateToGate(gate), target);
+}
+
+void MPDO::ApplyRotation(u_gate axis, double theta, int target) {
+    ApplyGate(RotationGate(axis, theta), target);
+}
+
+/// @brief Applies a controlled 1 qubit gate. Distant qubits are brought
+///        next to each other with SWAPs and moved back afterwards.
+/// @param U1 The 1 qubit gate applied when the control is 1.
+/// @param control The control qubit.
+/// @param target The target qubit.
+void MPDO::ApplyCGate(const cx_mat& U1, int control, int target) {
+    CheckQubit(control);
+    CheckQubit(target);
+    if (control == target) {
+        throw invalid_argument("Control and target qubit must be different");
+    }
+    // Move the control next to the target
+    int step = control < target ? 1 : -1;
+    int moved = control;
+    while (moved + step != target) {
+        ApplyBond(SWAP(0, 1), std::min(moved, moved + step));
+        moved += step;
+    }
+    ApplyBond(CG(U1, moved < target ? 0 : 1, moved < target ? 1 : 0),
+              std::min(moved, target));
+    while (moved != control) {
+        ApplyBond(SWAP(0, 1), std::min(moved, moved - step));
+        moved -= step;
+    }
+}
+
+void MPDO::ApplyCGate(u_gate gate, int control, int target) {
+    ApplyCGate(UGateToGate(gate), control, target);
+}
+
+void MPDO::ApplyCRotation(u_gate axis, double theta, int control,
+                          int target) {
+    ApplyCGate(RotationGate(axis, theta), control, target);
+}
+
+/// @brief Swaps two qubits through a chain of adjacent SWAPs.
+void MPDO::ApplySwap(int q1, int q2) {
+    CheckQubit(q1);
+    CheckQubit(q2);
+    if (q1 == q2) {
+        throw invalid_argument("The qubits to swap has to be different");
+    }
+    int low = std::min(q1, q2);
+    int high = std::max(q1, q2);
+    for (int q = low; q < high; q++) {
+        ApplyBond(SWAP(0, 1), q);
+    }
+    for (int q = high - 2; q >= low; q--) {
+        ApplyBond(SWAP(0, 1), q);
+    }
+}
+
+/// @brief Applies a 1 qubit channel to a single site.
+/// @param ops Kraus operators.
+/// @param qubit The qubit the channel acts on.
+void MPDO::ApplyChannel(const vector<kraus_t>& ops, int qubit) {
+    CheckQubit(qubit);
+    ApplySite(kraus_to_superop(ops), qubit);
+}
+
+/// @brief Samples every qubit, one at a time from its marginal conditioned
+///        on the qubits before it. Rescaling random at every step gives the
+///        same outcome as dmqs::Sample on the full density matrix.
+/// @param random Random value for sampling in [0, 1)
+/// @return The outcome of every qubit.
+vector<int> MPDO::Sample(double random) const {
+    if (random < 0.0 || random >= 1.0) {
+        throw invalid_argument(
+            "Random value must be in [0, 1]. " +
+            to_string(random) + "was supplied");
+    }
+    // Right environments of the traced remainder of the chain
+    vector<cx_mat> right(n_ + 1);
+    right[n_] = cx_mat(1, 1, arma::fill::ones);
+    for (int i = n_ - 1; i >= 0; i--) {
+        right[i] = SiteTrace(i) * right[i + 1];
+    }
+    vector<int> outcome(n_);
+    cx_mat left = cx_mat(1, 1, arma::fill::ones);
+    for (int i = 0; i < n_; i++) {
+        cx_mat w0 = left * sites_[i].slice(0) * right[i + 1];
+        cx_mat w1 = left * sites_[i].slice(3) * right[i + 1];
+        double p0 = std::max(w0(0, 0).real(), 0.0);
+        double p1 = std::max(w1(0, 0).real(), 0.0);
+        if (!(p0 + p1 > 0)) {
+            throw invalid_argument(
+                "Qubit " + to_string(i) + " has no probability mass left");
+        }
+        double p = p0 / (p0 + p1);
+        if (random < p) {
+            outcome[i] = 0;
+            random = random / p;
+            left = left * sites_[i].slice(0) / p0;
+        } else {
+            outcome[i] = 1;
+            random = std::min((random - p) / (1 - p), 1.0);
+            left = left * sites_[i].slice(3) / p1;
+        }
+    }
+    return outcome;
+}
+
+/// @brief Samples every qubit, drawing the random value from rng.
+vector<int> MPDO::Sample(RandomStream& rng) const {
+    return Sample(rng.Uniform());
+}
+
+/// @brief Samples a set of target qubits from their reduced density matrix.
+/// @param targets Qubits to sample.
+/// @param random Random value for sampling in [0, 1)
+/// @return The outcome, ordered as in dmqs::PartialSample.
+int MPDO::PartialSample(const vector<int>& targets, double random) const {
+    vec probabilities = dmqs::Probabilities(PartialTrace(targets));
+    return SampleOutcome(probabilities / accu(probabilities), random);
+}
+
+/// @brief Samples a set of target qubits, drawing the random value from rng.
+int MPDO::PartialSample(const vector<int>& targets, RandomStream& rng) const {
+    return PartialSample(targets, rng.Uniform());
+}
+
+/// @brief Measures a set of target qubits and collapses the chain in place.
+///        The projection only touches the target sites, so no bond grows.
+/// @param targets Qubits to measure.
+/// @param random Random value for sampling in [0, 1)
+/// @return The outcome, ordered as in dmqs::MeasureAndCollapse.
+int MPDO::MeasureAndCollapse(const vector<int>& targets, double random) {
+    vec marginal = dmqs::Probabilities(PartialTrace(targets));
+    int outcome = SampleOutcome(marginal / accu(marginal), random);
+    vector<int> sorted = targets;
+    sort(sorted.begin(), sorted.end());
+    for (size_t k = 0; k < sorted.size(); k++) {
+        uword bit = (outcome >> (sorted.size() - 1 - k)) & 1;
+        // Only |bit><bit| survives the projection
+        cx_cube& site = sites_[sorted[k]];
+        for (uword p = 0; p < 4; p++) {
+            if (p != 3 * bit) {
+                site.slice(p).zeros();
+            }
+        }
+    }
+    sites_[0] /= marginal(outcome);
+    return outcome;
+}
+
+/// @brief Measures a set of target qubits and collapses the chain in place,
+///        drawing the random value from rng.
+int MPDO::MeasureAndCollapse(const vector<int>& targets, RandomStream& rng) {
+    return MeasureAndCollapse(targets, rng.Uniform());
+}
+
+void MPDO::CheckQubit(int qubit) const {
+    if (qubit < 0 || qubit >= n_) {
+        throw invalid_argument(
+            "Qubit " + to_string(qubit) + " is outside of a " +
+            to_string(n_) + " qubit system");
+    }
+}
+
+/// @brief Traces the physical index of a site, A[0] + A[3].
+cx_mat MPDO::SiteTrace(int site) const {
+    return sites_[site].slice(0) + sites_[site].slice(3);
+}
+
+/// @brief Applies a 1 qubit superoperator to the local index of a site.
+void MPDO::ApplySite(const superop1_t& S, int site) {
+    const cx_cube& A = sites_[site];
+    cx_cube next = cx_cube(A.n_rows, A.n_cols, 4, arma::fill::zeros);
+    for (uword p = 0; p < 4; p++) {
+        for (uword q = 0; q < 4; q++) {
+            if (S(p, q) != cx_double(0, 0)) {
+                next.slice(p) += S(p, q) * A.slice(q);
+            }
+        }
+    }
+    sites_[site] = std::move(next);
+}
+
+/// @brief Applies a 2 qubit gate to the sites site and site + 1: the sites
+///        are contracted, conjugated by U2 and split again with a truncated
+///        SVD whose singular values are absorbed into the right site.
+void MPDO::ApplyBond(const cx_mat& U2, int site) {
+    const cx_cube& A = sites_[site];
+    const cx_cube& B = sites_[site + 1];
+    uword Dl = A.n_rows;
+    uword Dr = B.n_cols;
+    cx_mat S2 = kron(conj(U2), U2);
+
+    // Block (p1, p2) of theta is A[p1] B[p2]
+    cx_mat theta = cx_mat(4 * Dl, 4 * Dr);
+    for (uword p1 = 0; p1 < 4; p1++) {
+        for (uword p2 = 0; p2 < 4; p2++) {
+            theta.submat(p1 * Dl, p2 * Dr, size(Dl, Dr)) =
+                A.slice(p1) * B.slice(p2);
+        }
+    }
+    cx_mat M = cx_mat(4 * Dl, 4 * Dr, zeros);
+    for (uword o1 = 0; o1 < 4; o1++) {
+        for (uword o2 = 0; o2 < 4; o2++) {
+            uword out = PairIndex(o1, o2);
+            for (uword p1 = 0; p1 < 4; p1++) {
+                for (uword p2 = 0; p2 < 4; p2++) {
+                    cx_double s = S2(out, PairIndex(p1, p2));
+                    if (s == cx_double(0, 0)) {
+                        continue;
+                    }
+                    M.submat(o1 * Dl, o2 * Dr, size(Dl, Dr)) +=
+                        s * theta.submat(p1 * Dl, p2 * Dr, size(Dl, Dr));
+                }
+            }
+        }
+    }
+
+    cx_mat U;
+    vec s;
+    cx_mat V;
+    if (!svd_econ(U, s, V, M)) {
+        throw invalid_argument("SVD of the bond tensor failed");
+    }
+    uword keep = 1;
+    while (keep < s.n_elem && keep < max_bond_ &&
+           s(keep) > cutoff_ * s(0)) {
+        keep++;
+    }
+    double total = accu(square(s));
+    double discarded = 0;
+    for (uword k = keep; k < s.n_elem; k++) {
+        discarded += s(k) * s(k);
+    }
+    if (total > 0) {
+        truncation_error_ += discarded / total;
+    }
+
+    cx_cube left = cx_cube(Dl, keep, 4);
+    cx_cube right = cx_cube(keep, Dr, 4);
+    for (uword p = 0; p < 4; p++) {
+        left.slice(p) = U.submat(p * Dl, 0, size(Dl, keep));
+        right.slice(p) = V.submat(p * Dr, 0, size(Dr, keep)).t();
+        for (uword k = 0; k < keep; k++) {
+            right.slice(p).row(k) *= s(k);
+        }
+    }
+    sites_[site] = std::move(left);
+    sites_[site + 1] = std::move(right);
+}
+} // namespace dmqs
@@ -0,0 +1,181 @@
+#include <dmqs/noise.hpp>
+#include <dmqs/dmqs.hpp>
+#include <string>
+#include <vector>
+
+namespace dmqs {
+/// @brief Creates a scheduler for a system with one T1/T2 pair per qubit.
+/// @param T1 Energy relaxation times (1 per qubit)
+/// @param T2 Phase choherence times (1 per qubit)
+IdleNoise::IdleNoise(const vector<double>& T1, const vector<double>& T2)
+    : T1_(T1), T2_(T2), pending_(T1.size(), 0.0), applications_(0) {
+    if (T1.size() != T2.size()) {
+        throw invalid_argument(
+            "T1 and T2 should have a value per qubit. Got " +
+            to_string(T1.size()) + " and " + to_string(T2.size()));
+    }
+}
+
+/// @brief Lets every qubit idle for t.
+void IdleNoise::Idle(double t) {
+    for (double& p : pending_) {
+        p += t;
+    }
+}
+
+/// @brief Lets a single qubit idle for t.
+void IdleNoise::Idle(int qubit, double t) {
+    CheckQubit(qubit);
+    pending_[qubit] += t;
+}
+
+/// @brief Idle time of a qubit that has not been applied yet.
+double IdleNoise::Pending(int qubit) const {
+    CheckQubit(qubit);
+    return pending_[qubit];
+}
+
+/// @brief Applies the pending noise of the given qubits to rho in place.
+/// @param rho Density matrix the scheduled noise belongs to.
+/// @param qubits Qubits about to be touched by an operation.
+void IdleNoise::Flush(cx_mat& rho, const vector<int>& qubits) {
+    if (static_cast<size_t>(slog2(rho.n_rows)) != pending_.size()) {
+        throw invalid_argument(
+            "Density matrix has " + to_string(slog2(rho.n_rows)) +
+            " qubits, the scheduler " + to_string(pending_.size()));
+    }
+    for (int q : qubits) {
+        CheckQubit(q);
+        double t = pending_[q];
+        if (t == 0) {
+            continue;
+        }
+        ApplyAmplitudeDampeningAndDephasingInPlace(rho, q, T1_[q], T2_[q], t);
+        pending_[q] = 0;
+        applications_++;
+    }
+}
+
+/// @brief Applies the pending noise of every qubit to rho in place.
+void IdleNoise::FlushAll(cx_mat& rho) {
+    vector<int> all(pending_.size());
+    for (size_t q = 0; q < all.size(); q++) {
+        all[q] = static_cast<int>(q);
+    }
+    Flush(rho, all);
+}
+
+/// @brief Number of single qubit channels applied so far.
+int64_t IdleNoise::ChannelApplications() const {
+    return applications_;
+}
+
+void IdleNoise::CheckQubit(int qubit) const {
+    if (qubit < 0 || static_cast<size_t>(qubit) >= pending_.size()) {
+        throw invalid_argument(
+            "Qubit " + to_string(qubit) + " is outside of a " +
+            to_string(pending_.size()) + " qubit system");
+    }
+}
+
+/// @brief Wraps a density matrix with one T1/T2 pair per qubit.
+/// @param rho Density matrix, copied.
+/// @param T1 Energy relaxation times (1 per qubit)
+/// @param T2 Phase choherence times (1 per qubit)
+NoisyState::NoisyState(const cx_mat& rho, const vector<double>& T1,
+                       const vector<double>& T2)
+    : rho_(rho), noise_(T1, T2) {
+    if (rho.n_rows != rho.n_cols ||
+        static_cast<size_t>(slog2(rho.n_rows)) != T1.size() ||
+        (uword(1) << T1.size()) != rho.n_rows) {
+        throw invalid_argument(
+            "Density matrix must be a square 2^n matrix with n = " +
+            to_string(T1.size()));
+    }
+}
+
+/// @brief Number of qubits in the system.
+int NoisyState::Qubits() const {
+    return slog2(rho_.n_rows);
+}
+
+/// @brief Lets every qubit idle for t.
+void NoisyState::Idle(double t) {
+    noise_.Idle(t);
+}
+
+/// @brief Lets a single qubit idle for t.
+void NoisyState::Idle(int qubit, double t) {
+    noise_.Idle(qubit, t);
+}
+
+/// @brief The scheduler, for its pending times and counters.
+const IdleNoise& NoisyState::Noise() const {
+    return noise_;
+}
+
+/// @brief The density matrix with all pending noise applied.
+const cx_mat& NoisyState::DensityMatrix() {
+    noise_.FlushAll(rho_);
+    return rho_;
+}
+
+/// @brief Measurement probabilities of every basis state, with all pending
+///        noise applied.
+vec NoisyState::Probabilities() {
+    noise_.FlushAll(rho_);
+    return dmqs::Probabilities(rho_);
+}
+
+/// @brief Reduced density matrix of the targets, only their pending noise
+///        is applied.
+cx_mat NoisyState::PartialTrace(const vector<int>& targets) {
+    noise_.Flush(rho_, targets);
+    return dmqs::PartialTrace(rho_, targets);
+}
+
+void NoisyState::ApplyGate(u_gate gate, int target) {
+    noise_.Flush(rho_, {target});
+    ApplyGateInPlace(rho_, gate, target);
+}
+
+void NoisyState::ApplyGate(const cx_mat& U1, int target) {
+    noise_.Flush(rho_, {target});
+    ApplyGateInPlace(rho_, U1, target);
+}
+
+void NoisyState::ApplyCGate(u_gate gate, int control, int target) {
+    noise_.Flush(rho_, {control, target});
+    ApplyCGateInPlace(rho_, gate, control, target);
+}
+
+void NoisyState::ApplyRotation(u_gate axis, double theta, int target) {
+    noise_.Flush(rho_, {target});
+    ApplyRotationInPlace(rho_, axis, theta, target);
+}
+
+void NoisyState::ApplyCRotation(u_gate axis, double theta, int control,
+                                int target) {
+    noise_.Flush(rho_, {control, target});
+    ApplyCRotationInPlace(rho_, axis, theta, control, target);
+}
+
+void NoisyState::ApplySwap(int q1, int q2) {
+    noise_.Flush(rho_, {q1, q2});
+    ApplySwapInPlace(rho_, q1, q2);
+}
+
+void NoisyState::ApplyChannel(const vector<kraus_t>& ops, int qubit) {
+    noise_.Flush(rho_, {qubit});
+    apply_channel_in_place(rho_, ops, qubit);
+}
+
+/// @brief Measures a set of target qubits and collapses rho, see
+///        dmqs::MeasureAndCollapse. Only the targets' noise is applied,
+///        pending noise on the other qubits commutes with the measurement.
+int NoisyState::MeasureAndCollapse(const vector<int>& targets,
+                                   double random) {
+    noise_.Flush(rho_, targets);
+    return dmqs::MeasureAndCollapse(rho_, targets, random);
+}
+} // namespace dmqs
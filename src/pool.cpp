@@ -0,0 +1,120 @@
+#include <dmqs/pool.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using std::invalid_argument, std::to_string;
+
+namespace dmqs {
+// Handle layout: generation in bits 16-30, slot index in bits 0-15. The
+// generation starts at 1, so 0 is never a valid handle.
+static const int kSlotBits = 16;
+static const int kMaxSlots = 1 << kSlotBits;
+static const uint32_t kGenerationMask = 0x7fff;
+
+static int Handle(int slot, uint32_t generation) {
+    return static_cast<int>(generation << kSlotBits) | slot;
+}
+
+/// @brief Creates a product state from a binary string in the format of
+///        BinaryStringToDensityMatrix and returns its handle.
+int StatePool::Create(const string& bin) {
+    return Insert(std::make_unique<State>(bin));
+}
+
+/// @brief Moves an existing state into the pool and returns its handle.
+int StatePool::Create(State state) {
+    return Insert(std::make_unique<State>(std::move(state)));
+}
+
+/// @brief Copies the state behind handle into a new handle.
+int StatePool::Clone(int handle) {
+    std::unique_ptr<State> copy;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        copy = std::make_unique<State>(*Find(handle).state);
+    }
+    return Insert(std::move(copy));
+}
+
+/// @brief Frees the state behind handle. The handle, and every copy of it,
+///        is invalid afterwards.
+void StatePool::Destroy(int handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Slot& slot = Find(handle);
+    slot.state.reset();
+    slot.generation = slot.generation % kGenerationMask + 1;
+    free_.push_back(handle & (kMaxSlots - 1));
+    size_--;
+}
+
+/// @brief The state behind handle. The reference stays valid until the
+///        handle is destroyed.
+State& StatePool::Get(int handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return *Find(handle).state;
+}
+
+/// @brief Whether handle addresses a live state.
+bool StatePool::Contains(int handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int slot = handle & (kMaxSlots - 1);
+    return handle > 0 && slot < static_cast<int>(slots_.size()) &&
+           slots_[slot].state != nullptr &&
+           Handle(slot, slots_[slot].generation) == handle;
+}
+
+/// @brief Number of live states.
+size_t StatePool::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+/// @brief Destroys every state, invalidating all handles.
+void StatePool::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < slots_.size(); i++) {
+        if (slots_[i].state != nullptr) {
+            slots_[i].state.reset();
+            slots_[i].generation = slots_[i].generation % kGenerationMask + 1;
+            free_.push_back(static_cast<int>(i));
+        }
+    }
+    size_ = 0;
+}
+
+/// @brief The pool shared by the C bindings.
+StatePool& StatePool::Global() {
+    static StatePool pool;
+    return pool;
+}
+
+int StatePool::Insert(std::unique_ptr<State> state) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int slot;
+    if (!free_.empty()) {
+        slot = free_.back();
+        free_.pop_back();
+    } else {
+        if (slots_.size() >= static_cast<size_t>(kMaxSlots)) {
+            throw invalid_argument("State pool is full (" +
+                                   to_string(kMaxSlots) + " states)");
+        }
+        slot = static_cast<int>(slots_.size());
+        slots_.push_back(Slot{nullptr, 1});
+    }
+    slots_[slot].state = std::move(state);
+    size_++;
+    return Handle(slot, slots_[slot].generation);
+}
+
+StatePool::Slot& StatePool::Find(int handle) {
+    int slot = handle & (kMaxSlots - 1);
+    if (handle <= 0 || slot >= static_cast<int>(slots_.size()) ||
+        slots_[slot].state == nullptr ||
+        Handle(slot, slots_[slot].generation) != handle) {
+        throw invalid_argument("Invalid state handle " + to_string(handle));
+    }
+    return slots_[slot];
+}
+} // namespace dmqs
@@ -0,0 +1,541 @@
+#include <dmqs/qasm.hpp>
+#include <dmqs/dmqs.hpp>
+#include <cctype>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using std::invalid_argument, std::to_string, std::map;
+
+namespace dmqs {
+// Parsed circuits kept by CompileQasm before the cache is cleared
+static const size_t kQasmCacheLimit = 64;
+
+namespace {
+enum class TokenType { IDENT, NUMBER, STRING, SYMBOL, PRAGMA, END };
+
+struct Token {
+    TokenType type;
+    string text;
+    double value;
+    int line;
+};
+
+/// @brief Splits OpenQASM 2 source into tokens. Comments are dropped and
+///        "#pragma" becomes a single token.
+vector<Token> Tokenize(const string& source) {
+    vector<Token> tokens;
+    int line = 1;
+    size_t i = 0;
+    auto fail = [&line](const string& message) {
+        throw invalid_argument(
+            "QASM line " + to_string(line) + ": " + message);
+    };
+    while (i < source.size()) {
+        char c = source[i];
+        if (c == '\n') {
+            line++;
+            i++;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            i++;
+        } else if (source.compare(i, 2, "//") == 0) {
+            while (i < source.size() && source[i] != '\n') {
+                i++;
+            }
+        } else if (c == '#') {
+            if (source.compare(i, 7, "#pragma") != 0) {
+                fail("Unexpected '#'");
+            }
+            tokens.push_back({TokenType::PRAGMA, "#pragma", 0, line});
+            i += 7;
+        } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            size_t start = i;
+            while (i < source.size() &&
+                   (std::isalnum(static_cast<unsigned char>(source[i])) ||
+                    source[i] == '_')) {
+                i++;
+            }
+            tokens.push_back({TokenType::IDENT,
+                              source.substr(start, i - start), 0, line});
+        } else if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            size_t length = 0;
+            double value = 0;
+            try {
+                value = std::stod(source.substr(i, 64), &length);
+            } catch (const std::logic_error&) {
+                fail("Invalid number");
+            }
+            tokens.push_back({TokenType::NUMBER, source.substr(i, length),
+                              value, line});
+            i += length;
+        } else if (c == '"') {
+            size_t end = source.find('"', i + 1);
+            if (end == string::npos) {
+                fail("Unterminated string");
+            }
+            tokens.push_back({TokenType::STRING,
+                              source.substr(i + 1, end - i - 1), 0, line});
+            i = end + 1;
+        } else if (source.compare(i, 2, "->") == 0) {
+            tokens.push_back({TokenType::SYMBOL, "->", 0, line});
+            i += 2;
+        } else if (string(";,()[]{}+-*/^").find(c) != string::npos) {
+            tokens.push_back({TokenType::SYMBOL, string(1, c), 0, line});
+            i++;
+        } else {
+            fail("Unexpected character '" + string(1, c) + "'");
+        }
+    }
+    tokens.push_back({TokenType::END, "", 0, line});
+    return tokens;
+}
+
+/// @brief Recursive descent parser for the supported OpenQASM 2 subset.
+class QasmParser {
+ public:
+    explicit QasmParser(const string& source)
+        : tokens_(Tokenize(source)), pos_(0) {}
+
+    Circuit Parse() {
+        if (Peek().type == TokenType::IDENT && Peek().text == "OPENQASM") {
+            Next();
+            const Token& version = Expect(TokenType::NUMBER, "a version");
+            if (version.value < 2 || version.value >= 3) {
+                Fail("Only OpenQASM 2 is supported, not " + version.text);
+            }
+            ExpectSymbol(";");
+        }
+        while (Peek().type != TokenType::END) {
+            Statement();
+        }
+        return circuit_;
+    }
+
+ private:
+    struct Register {
+        int offset;
+        int size;
+    };
+
+    [[noreturn]] void Fail(const string& message) const {
+        throw invalid_argument(
+            "QASM line " + to_string(Peek().line) + ": " + message);
+    }
+
+    const Token& Peek() const {
+        return tokens_[pos_];
+    }
+
+    const Token& Next() {
+        const Token& token = tokens_[pos_];
+        if (token.type != TokenType::END) {
+            pos_++;
+        }
+        return token;
+    }
+
+    bool AcceptSymbol(const string& symbol) {
+        if (Peek().type == TokenType::SYMBOL && Peek().text == symbol) {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+
+    void ExpectSymbol(const string& symbol) {
+        if (!AcceptSymbol(symbol)) {
+            Fail("Expected '" + symbol + "' but found '" + Peek().text + "'");
+        }
+    }
+
+    const Token& Expect(TokenType type, const string& what) {
+        if (Peek().type != type) {
+            Fail("Expected " + what + " but found '" + Peek().text + "'");
+        }
+        return Next();
+    }
+
+    void Statement() {
+        if (Peek().type == TokenType::PRAGMA) {
+            Pragma(Next().line);
+            return;
+        }
+        string name = Expect(TokenType::IDENT, "a statement").text;
+        if (name == "include") {
+            string file = Expect(TokenType::STRING, "a file name").text;
+            if (file != "qelib1.inc") {
+                Fail("Unsupported include \"" + file + "\"");
+            }
+        } else if (name == "qreg" || name == "creg") {
+            Declaration(name == "qreg" ? qregs_ : cregs_,
+                        name == "qreg" ? circuit_.qubits : circuit_.clbits);
+        } else if (name == "measure") {
+            Measure();
+        } else if (name == "reset") {
+            Broadcast(OpKind::RESET, Operation());
+        } else if (name == "barrier") {
+            Operation op;
+            op.kind = OpKind::BARRIER;
+            do {
+                vector<int> qubits = Argument(qregs_, "quantum register");
+                op.qubits.insert(op.qubits.end(), qubits.begin(),
+                                 qubits.end());
+            } while (AcceptSymbol(","));
+            circuit_.ops.push_back(op);
+        } else {
+            Gate(name);
+        }
+        ExpectSymbol(";");
+    }
+
+    void Declaration(map<string, Register>& registers, int& total) {
+        string name = Expect(TokenType::IDENT, "a register name").text;
+        ExpectSymbol("[");
+        int size = Index();
+        ExpectSymbol("]");
+        if (size < 1) {
+            Fail("Register " + name + " must have at least one bit");
+        }
+        if (qregs_.count(name) || cregs_.count(name)) {
+            Fail("Register " + name + " is already declared");
+        }
+        registers[name] = {total, size};
+        total += size;
+    }
+
+    int Index() {
+        const Token& token = Expect(TokenType::NUMBER, "an index");
+        if (token.value != std::floor(token.value)) {
+            Fail("Index " + token.text + " is not an integer");
+        }
+        return static_cast<int>(token.value);
+    }
+
+    /// @brief Reads name or name[i] and returns the bits it refers to.
+    vector<int> Argument(const map<string, Register>& registers,
+                         const string& what) {
+        string name = Expect(TokenType::IDENT, "a " + what).text;
+        auto it = registers.find(name);
+        if (it == registers.end()) {
+            Fail("Unknown " + what + " " + name);
+        }
+        const Register& reg = it->second;
+        if (AcceptSymbol("[")) {
+            int index = Index();
+            ExpectSymbol("]");
+            if (index < 0 || index >= reg.size) {
+                Fail("Index " + to_string(index) + " is outside of " + name +
+                     "[" + to_string(reg.size) + "]");
+            }
+            return {reg.offset + index};
+        }
+        vector<int> bits(reg.size);
+        for (int i = 0; i < reg.size; i++) {
+            bits[i] = reg.offset + i;
+        }
+        return bits;
+    }
+
+    /// @brief Applies a 1 qubit operation to every qubit of a register
+    ///        argument, or to a single indexed qubit.
+    void Broadcast(OpKind kind, Operation op) {
+        op.kind = kind;
+        for (int q : Argument(qregs_, "quantum register")) {
+            op.qubits = {q};
+            circuit_.ops.push_back(op);
+        }
+    }
+
+    void TwoQubit(Operation op) {
+        vector<int> a = Argument(qregs_, "quantum register");
+        ExpectSymbol(",");
+        vector<int> b = Argument(qregs_, "quantum register");
+        if (a.size() != 1 || b.size() != 1) {
+            Fail("Two qubit gates need indexed qubit arguments");
+        }
+        if (a[0] == b[0]) {
+            Fail("Two qubit gates need two different qubits");
+        }
+        op.qubits = {a[0], b[0]};
+        circuit_.ops.push_back(op);
+    }
+
+    void Measure() {
+        vector<int> qubits = Argument(qregs_, "quantum register");
+        ExpectSymbol("->");
+        vector<int> clbits = Argument(cregs_, "classical register");
+        if (qubits.size() != clbits.size()) {
+            Fail("Measured register sizes do not match");
+        }
+        for (size_t i = 0; i < qubits.size(); i++) {
+            Operation op;
+            op.kind = OpKind::MEASURE;
+            op.qubits = {qubits[i]};
+            op.clbit = clbits[i];
+            circuit_.ops.push_back(op);
+        }
+    }
+
+    /// @brief #pragma dmqs <channel>(p) args; applies a u_channel with the
+    ///        same parameter as ApplyChannel. Pragmas for other tools are
+    ///        skipped up to the end of their line, or their ; if they have
+    ///        one, so a pragma without ; does not swallow the next line.
+    /// @param line Source line of the #pragma token.
+    void Pragma(int line) {
+        if (Peek().type != TokenType::IDENT || Peek().text != "dmqs") {
+            while (Peek().type != TokenType::END && Peek().line == line &&
+                   !AcceptSymbol(";")) {
+                Next();
+            }
+            return;
+        }
+        Next();
+        static const map<string, u_channel> channels = {
+            {"amplitude_damping", AMPLITUDE_DAMPING},
+            {"phase_damping", PHASE_DAMPING},
+            {"bit_flip", BIT_FLIP},
+            {"phase_flip", PHASE_FLIP},
+            {"bit_phase_flip", BIT_PHASE_FLIP},
+            {"depolarizing", DEPOLARIZING},
+        };
+        string name = Expect(TokenType::IDENT, "a channel").text;
+        auto it = channels.find(name);
+        if (it == channels.end()) {
+            Fail("Unknown channel " + name);
+        }
+        Operation op;
+        op.channel = it->second;
+        op.param = Parameter();
+        if (op.param < 0 || op.param > 1) {
+            Fail("Channel parameter must be in [0, 1]");
+        }
+        Broadcast(OpKind::CHANNEL, op);
+        ExpectSymbol(";");
+    }
+
+    /// @brief Reads a parenthesized parameter expression.
+    double Parameter() {
+        ExpectSymbol("(");
+        double value = Expression();
+        ExpectSymbol(")");
+        return value;
+    }
+
+    /// @brief Reads a rotation angle in radians and converts it to the
+    ///        degrees used by the gate library.
+    double Angle() {
+        return Parameter() * 180.0 / M_PI;
+    }
+
+    void Gate(const string& name) {
+        static const map<string, u_gate> fixed = {
+            {"id", GID}, {"x", GX}, {"y", GY}, {"z", GZ}, {"h", GH},
+            {"b0", GB0}, {"b1", GB1},
+        };
+        static const map<string, double> phases = {
+            {"s", 90}, {"sdg", -90}, {"t", 45}, {"tdg", -45},
+        };
+        static const map<string, u_gate> rotations = {
+            {"rx", GRX}, {"ry", GRY}, {"rz", GRZ},
+        };
+        static const map<string, u_gate> controlled = {
+            {"cx", GX}, {"CX", GX}, {"cy", GY}, {"cz", GZ}, {"ch", GH},
+        };
+        Operation op;
+        if (fixed.count(name)) {
+            op.gate = fixed.at(name);
+            Broadcast(OpKind::GATE, op);
+        } else if (phases.count(name)) {
+            op.matrix = P(phases.at(name));
+            Broadcast(OpKind::UNITARY, op);
+        } else if (name == "u1" || name == "p") {
+            op.matrix = P(Angle());
+            Broadcast(OpKind::UNITARY, op);
+        } else if (rotations.count(name)) {
+            op.gate = rotations.at(name);
+            op.param = Angle();
+            Broadcast(OpKind::ROTATION, op);
+        } else if (controlled.count(name)) {
+            op.kind = OpKind::CGATE;
+            op.gate = controlled.at(name);
+            TwoQubit(op);
+        } else if (name.size() == 3 && name[0] == 'c' &&
+                   rotations.count(name.substr(1))) {
+            op.kind = OpKind::CROTATION;
+            op.gate = rotations.at(name.substr(1));
+            op.param = Angle();
+            TwoQubit(op);
+        } else if (name == "swap") {
+            op.kind = OpKind::SWAP;
+            TwoQubit(op);
+        } else {
+            Fail("Unsupported statement " + name);
+        }
+    }
+
+    // expression := term (('+' | '-') term)*
+    double Expression() {
+        double value = Term();
+        while (true) {
+            if (AcceptSymbol("+")) {
+                value += Term();
+            } else if (AcceptSymbol("-")) {
+                value -= Term();
+            } else {
+                return value;
+            }
+        }
+    }
+
+    // term := unary (('*' | '/') unary)*
+    double Term() {
+        double value = Unary();
+        while (true) {
+            if (AcceptSymbol("*")) {
+                value *= Unary();
+            } else if (AcceptSymbol("/")) {
+                value /= Unary();
+            } else {
+                return value;
+            }
+        }
+    }
+
+    // unary := ('-' | '+') unary | primary ('^' unary)?
+    double Unary() {
+        if (AcceptSymbol("-")) {
+            return -Unary();
+        }
+        if (AcceptSymbol("+")) {
+            return Unary();
+        }
+        double value = Primary();
+        if (AcceptSymbol("^")) {
+            value = std::pow(value, Unary());
+        }
+        return value;
+    }
+
+    // primary := number | pi | function '(' expression ')' | '(' expression ')'
+    double Primary() {
+        static const map<string, std::function<double(double)>> functions = {
+            {"sin", [](double x) { return std::sin(x); }},
+            {"cos", [](double x) { return std::cos(x); }},
+            {"tan", [](double x) { return std::tan(x); }},
+            {"exp", [](double x) { return std::exp(x); }},
+            {"ln", [](double x) { return std::log(x); }},
+            {"sqrt", [](double x) { return std::sqrt(x); }},
+        };
+        if (Peek().type == TokenType::NUMBER) {
+            return Next().value;
+        }
+        if (AcceptSymbol("(")) {
+            double value = Expression();
+            ExpectSymbol(")");
+            return value;
+        }
+        string name = Expect(TokenType::IDENT, "an expression").text;
+        if (name == "pi") {
+            return M_PI;
+        }
+        auto it = functions.find(name);
+        if (it == functions.end()) {
+            Fail("Unknown identifier " + name + " in expression");
+        }
+        return it->second(Parameter());
+    }
+
+    vector<Token> tokens_;
+    size_t pos_;
+    Circuit circuit_;
+    map<string, Register> qregs_;
+    map<string, Register> cregs_;
+};
+
+struct CachedCircuit {
+    string source;
+    std::shared_ptr<const Circuit> circuit;
+};
+
+std::mutex qasm_cache_mutex;
+std::unordered_map<size_t, CachedCircuit> qasm_cache;
+int64_t qasm_cache_hits = 0;
+int64_t qasm_cache_misses = 0;
+} // namespace
+
+/// @brief Parses an OpenQASM 2 program into the circuit IR. Supported are
+///        qreg/creg declarations, the u_gate set (id, x, y, z, h and the
+///        b0/b1 projections), s, sdg, t, tdg, u1/p, rx, ry, rz, cx, cy, cz,
+///        ch, crx, cry, crz, swap, measure, reset and barrier. Angles are
+///        in radians. Noise is added with
+///        "#pragma dmqs <channel>(p) q;" for the u_channel models, e.g.
+///        "#pragma dmqs depolarizing(0.01) q[0];". 1 qubit statements on a
+///        whole register apply to every qubit in it, and registers are laid
+///        out in declaration order.
+/// @param source The program.
+/// @return The circuit, not optimized.
+Circuit ParseQasm(const string& source) {
+    return QasmParser(source).Parse();
+}
+
+/// @brief Parses and optimizes an OpenQASM 2 program. Circuits are cached by
+///        the hash of their source, so running the same program again skips
+///        both steps. Safe to call from several threads.
+/// @param source The program.
+/// @return The optimized circuit, shared with the cache.
+std::shared_ptr<const Circuit> CompileQasm(const string& source) {
+    size_t hash = std::hash<string>{}(source);
+    {
+        std::lock_guard<std::mutex> lock(qasm_cache_mutex);
+        auto it = qasm_cache.find(hash);
+        if (it != qasm_cache.end() && it->second.source == source) {
+            qasm_cache_hits++;
+            return it->second.circuit;
+        }
+        qasm_cache_misses++;
+    }
+    auto circuit = std::make_shared<const Circuit>(
+        OptimizeCircuit(ParseQasm(source)));
+    std::lock_guard<std::mutex> lock(qasm_cache_mutex);
+    if (qasm_cache.size() >= kQasmCacheLimit) {
+        qasm_cache.clear();
+    }
+    qasm_cache[hash] = {source, circuit};
+    return circuit;
+}
+
+/// @brief Runs an OpenQASM 2 program on rho in place, see CompileQasm.
+/// @param rho Density matrix that is updated in place.
+/// @param source The program.
+/// @param rng Random stream measurements draw from.
+/// @return The classical bits after the run.
+vector<int> RunCircuit(cx_mat& rho, const string& source,
+                       RandomStream& rng) {
+    return RunCircuit(rho, *CompileQasm(source), rng);
+}
+
+/// @brief Number of CompileQasm calls served from the cache.
+int64_t QasmCacheHits() {
+    std::lock_guard<std::mutex> lock(qasm_cache_mutex);
+    return qasm_cache_hits;
+}
+
+/// @brief Number of CompileQasm calls that had to parse.
+int64_t QasmCacheMisses() {
+    std::lock_guard<std::mutex> lock(qasm_cache_mutex);
+    return qasm_cache_misses;
+}
+
+/// @brief Drops all cached circuits and resets the counters.
+void ClearQasmCache() {
+    std::lock_guard<std::mutex> lock(qasm_cache_mutex);
+    qasm_cache.clear();
+    qasm_cache_hits = 0;
+    qasm_cache_misses = 0;
+}
+} // namespace dmqs
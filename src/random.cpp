@@ -0,0 +1,113 @@
+#include <dmqs/random.hpp>
+
+namespace dmqs {
+static const uint32_t kPhiloxM0 = 0xD2511F53;
+static const uint32_t kPhiloxM1 = 0xCD9E8D57;
+static const uint32_t kPhiloxW0 = 0x9E3779B9;
+static const uint32_t kPhiloxW1 = 0xBB67AE85;
+static const int kPhiloxRounds = 10;
+
+/// @brief Combines two 32 bit words into a 64 bit one.
+static uint64_t Join(uint32_t hi, uint32_t lo) {
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+/// @brief Maps 64 random bits to a double in [0, 1) using the top 53 bits.
+static double ToUniform(uint64_t bits) {
+    return static_cast<double>(bits >> 11) * 0x1.0p-53;
+}
+
+/// @brief Creates a stream. Streams with the same seed but a different
+///        stream number are statistically independent.
+/// @param seed Key of the generator.
+/// @param stream Stream number, e.g. the index of a shot or a thread.
+RandomStream::RandomStream(uint64_t seed, uint64_t stream)
+    : seed_(seed), stream_(stream), index_(0), block_(), used_(4) {}
+
+/// @brief The Philox4x32-10 bijection of Salmon et al., "Parallel random
+///        numbers: as easy as 1, 2, 3" (SC 2011).
+/// @param counter The counter to encrypt.
+/// @param key The key.
+/// @return Four random 32 bit words.
+RandomStream::block_t RandomStream::Philox4x32(
+    const block_t& counter, const std::array<uint32_t, 2>& key) {
+    block_t c = counter;
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+    for (int round = 0; round < kPhiloxRounds; round++) {
+        uint64_t p0 = static_cast<uint64_t>(kPhiloxM0) * c[0];
+        uint64_t p1 = static_cast<uint64_t>(kPhiloxM1) * c[2];
+        c = {static_cast<uint32_t>(p1 >> 32) ^ c[1] ^ k0,
+             static_cast<uint32_t>(p1),
+             static_cast<uint32_t>(p0 >> 32) ^ c[3] ^ k1,
+             static_cast<uint32_t>(p0)};
+        k0 += kPhiloxW0;
+        k1 += kPhiloxW1;
+    }
+    return c;
+}
+
+/// @brief Random block at an index of this stream, independent of the
+///        position of the stream.
+/// @param index Block index.
+/// @return Four random 32 bit words.
+RandomStream::block_t RandomStream::Block(uint64_t index) const {
+    block_t counter = {static_cast<uint32_t>(index),
+                       static_cast<uint32_t>(index >> 32),
+                       static_cast<uint32_t>(stream_),
+                       static_cast<uint32_t>(stream_ >> 32)};
+    return Philox4x32(counter, {static_cast<uint32_t>(seed_),
+                                static_cast<uint32_t>(seed_ >> 32)});
+}
+
+/// @brief One of the two uniform values held by a block, independent of the
+///        position of the stream. Lets parallel loops draw the values of
+///        item i from block i.
+/// @param index Block index.
+/// @param half 0 for the first value of the block and 1 for the second.
+/// @return Uniform random value in [0, 1).
+double RandomStream::Uniform(uint64_t index, int half) const {
+    block_t b = Block(index);
+    return half == 0 ? ToUniform(Join(b[1], b[0]))
+                     : ToUniform(Join(b[3], b[2]));
+}
+
+/// @brief Next uniform random value of the stream.
+/// @return Uniform random value in [0, 1).
+double RandomStream::Uniform() {
+    return ToUniform((*this)());
+}
+
+/// @brief Next 64 random bits of the stream.
+RandomStream::result_type RandomStream::operator()() {
+    if (used_ == 4) {
+        block_ = Block(index_++);
+        used_ = 0;
+    }
+    uint64_t bits = Join(block_[used_ + 1], block_[used_]);
+    used_ += 2;
+    return bits;
+}
+
+/// @brief Moves the stream to the start of a block in O(1).
+/// @param index Block index the next value is drawn from.
+void RandomStream::Seek(uint64_t index) {
+    index_ = index;
+    used_ = 4;
+}
+
+/// @brief Index of the block the next value is drawn from.
+uint64_t RandomStream::Position() const {
+    return used_ == 4 ? index_ : index_ - 1;
+}
+
+/// @brief The seed of the stream.
+uint64_t RandomStream::Seed() const {
+    return seed_;
+}
+
+/// @brief The stream number.
+uint64_t RandomStream::Stream() const {
+    return stream_;
+}
+} // namespace dmqs
@@ -0,0 +1,230 @@
+#include <dmqs/real.hpp>
+#include <dmqs/dmqs.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+using std::invalid_argument;
+
+namespace dmqs {
+/// @brief Whether every entry of A has an imaginary part of exactly zero.
+static bool HasRealEntries(const cx_mat& A) {
+    for (uword i = 0; i < A.n_elem; i++) {
+        if (A(i).imag() != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Creates a product state from a binary string in the format of
+///        BinaryStringToDensityMatrix, which is always real.
+/// @param bin A string of 0, 1, + and - e.g "0+1"
+RealState::RealState(const string& bin)
+    : n_(bin.length()), is_real_(true), real_operations_(0) {
+    if (bin.empty()) {
+        throw invalid_argument("A state needs at least 1 qubit");
+    }
+    for (char c : bin) {
+        if (c != '0' && c != '1' && c != '+' && c != '-') {
+            throw invalid_argument(
+                "Invalid basis state '" + string(1, c) + "' in " + bin);
+        }
+    }
+    real_ = real(BinaryStringToDensityMatrix(bin));
+}
+
+RealState::RealState(const char* bin) : RealState(string(bin)) {}
+
+/// @brief Wraps a density matrix, stored in real doubles if its imaginary
+///        part is exactly zero.
+/// @param rho Density matrix.
+RealState::RealState(const cx_mat& rho)
+    : n_(slog2(rho.n_rows)), is_real_(HasRealEntries(rho)),
+      real_operations_(0) {
+    if (rho.n_rows < 2 || rho.n_rows != rho.n_cols ||
+        (uword(1) << n_) != rho.n_rows) {
+        throw invalid_argument("Density matrix must be a square 2^n matrix");
+    }
+    if (is_real_) {
+        real_ = real(rho);
+    } else {
+        rho_ = rho;
+    }
+}
+
+/// @brief Number of qubits in the system.
+int RealState::Qubits() const {
+    return n_;
+}
+
+/// @brief Whether rho is still stored in real doubles.
+bool RealState::IsReal() const {
+    return is_real_;
+}
+
+/// @brief The real density matrix, only valid while IsReal().
+const mat& RealState::RealMatrix() const {
+    if (!is_real_) {
+        throw invalid_argument("The state has been promoted to complex");
+    }
+    return real_;
+}
+
+/// @brief The density matrix as a complex matrix.
+cx_mat RealState::DensityMatrix() const {
+    if (is_real_) {
+        return cx_mat(real_, mat(real_.n_rows, real_.n_cols,
+                                 arma::fill::zeros));
+    }
+    return rho_;
+}
+
+/// @brief Measurement probabilities of every basis state.
+vec RealState::Probabilities() const {
+    if (is_real_) {
+        return real_.diag();
+    }
+    return dmqs::Probabilities(rho_);
+}
+
+/// @brief Applies a 1 qubit gate. A real gate runs the real kernel, a gate
+///        that is complex but real up to conjugation, like Y, runs as a
+///        real superoperator and any other gate promotes rho to complex.
+void RealState::ApplyGate(const cx_mat& U1, int target) {
+    if (U1.n_rows != 2 || U1.n_cols != 2) {
+        throw invalid_argument("A 1 qubit gate must be a 2x2 matrix");
+    }
+    if (is_real_ && HasRealEntries(U1)) {
+        ApplyGate1InPlace(real_, mat(real(U1)), target);
+        real_operations_++;
+        return;
+    }
+    if (is_real_) {
+        superop1_t S = kraus_to_superop({kraus_t(U1)});
+        if (HasRealEntries(S)) {
+            ApplySuperop1InPlace(real_, real_superop1_t(real(S)), target);
+            real_operations_++;
+            return;
+        }
+        Complexify();
+    }
+    ApplyGate1InPlace(rho_, U1, target);
+}
+
+void RealState::ApplyGate(u_gate gate, int target) {
+    ApplyGate(UGateToGate(gate), target);
+}
+
+/// @brief Applies a controlled 1 qubit gate, on the real kernel if the gate
+///        is real. The phase of U1 matters once controlled, so CY promotes.
+void RealState::ApplyCGate(const cx_mat& U1, int control, int target) {
+    if (is_real_ && HasRealEntries(U1)) {
+        ApplyCGate1InPlace(real_, mat(real(U1)), control, target);
+        real_operations_++;
+        return;
+    }
+    Complexify();
+    ApplyCGate1InPlace(rho_, U1, control, target);
+}
+
+void RealState::ApplyCGate(u_gate gate, int control, int target) {
+    ApplyCGate(UGateToGate(gate), control, target);
+}
+
+void RealState::ApplyRotation(u_gate axis, double theta, int target) {
+    ApplyGate(RotationGate(axis, theta), target);
+}
+
+void RealState::ApplyCRotation(u_gate axis, double theta, int control,
+                               int target) {
+    ApplyCGate(RotationGate(axis, theta), control, target);
+}
+
+void RealState::ApplySwap(int q1, int q2) {
+    vector<uword> perm = SwapPermutation(q1, q2, n_);
+    if (!is_real_) {
+        ApplyPermutationInPlace(rho_, perm);
+        return;
+    }
+    // A swap is its own inverse, so gathering by perm permutes rho
+    arma::uvec indices = arma::conv_to<arma::uvec>::from(perm);
+    real_ = real_.submat(indices, indices);
+    real_operations_++;
+}
+
+/// @brief Applies a 1 qubit channel, as a real superoperator while that
+///        keeps rho real.
+/// @param ops Kraus operators.
+/// @param qubit The qubit the channel acts on.
+void RealState::ApplyChannel(const vector<kraus_t>& ops, int qubit) {
+    if (ops.empty()) {
+        throw invalid_argument("A channel needs at least 1 Kraus operator");
+    }
+    if (is_real_) {
+        superop1_t S = kraus_to_superop(ops);
+        if (HasRealEntries(S)) {
+            ApplySuperop1InPlace(real_, real_superop1_t(real(S)), qubit);
+            real_operations_++;
+            return;
+        }
+        Complexify();
+    }
+    apply_channel_in_place(rho_, ops, qubit);
+}
+
+/// @brief Measures a set of target qubits and collapses the state in place,
+///        see dmqs::MeasureAndCollapse. A projection keeps rho real.
+int RealState::MeasureAndCollapse(const vector<int>& targets,
+                                  double random) {
+    if (!is_real_) {
+        return dmqs::MeasureAndCollapse(rho_, targets, random);
+    }
+    vec marginal = MarginalProbabilities(vec(real_.diag()), targets);
+    int outcome = SampleOutcome(marginal, random);
+    vector<int> sorted = targets;
+    std::sort(sorted.begin(), sorted.end());
+    uword mask = 0;
+    uword value = 0;
+    for (size_t k = 0; k < sorted.size(); k++) {
+        uword bit = uword(1) << (n_ - 1 - sorted[k]);
+        mask |= bit;
+        if ((outcome >> (sorted.size() - 1 - k)) & 1) {
+            value |= bit;
+        }
+    }
+    double scale = 1 / marginal(outcome);
+    for (uword c = 0; c < real_.n_cols; c++) {
+        double* col = real_.colptr(c);
+        bool col_on = (c & mask) == value;
+        for (uword r = 0; r < real_.n_rows; r++) {
+            col[r] = col_on && (r & mask) == value ? col[r] * scale : 0;
+        }
+    }
+    real_operations_++;
+    return outcome;
+}
+
+/// @brief Measures a set of target qubits and collapses the state in place,
+///        drawing the random value from rng.
+int RealState::MeasureAndCollapse(const vector<int>& targets,
+                                  RandomStream& rng) {
+    return MeasureAndCollapse(targets, rng.Uniform());
+}
+
+/// @brief Moves rho to complex storage, done automatically by the first
+///        operation that needs it.
+void RealState::Complexify() {
+    if (!is_real_) {
+        return;
+    }
+    rho_ = DensityMatrix();
+    real_.reset();
+    is_real_ = false;
+}
+
+/// @brief Number of operations that ran in real arithmetic.
+int64_t RealState::RealOperations() const {
+    return real_operations_;
+}
+} // namespace dmqs
@@ -0,0 +1,212 @@
+#include <dmqs/sampling.hpp>
+#include <dmqs/gates.hpp>
+#include <dmqs/context.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using std::invalid_argument, std::to_string, std::sort;
+
+namespace dmqs {
+/// @brief Measurement probabilities of every basis state of rho.
+/// @param rho Density matrix to sample from.
+/// @return The (unnormalized) diagonal of rho.
+vec Probabilities(const cx_mat& rho) {
+    if (rho.n_rows != rho.n_cols) {
+        throw invalid_argument("Density matrix must be square");
+    }
+    return abs(rho.diag());
+}
+
+/// @brief Measurement probabilities of a set of target qubits, summed
+///        straight from the diagonal of rho without a partial trace. The
+///        outcome ordering matches PartialSample: the lowest target is the
+///        most significant bit.
+/// @param rho Density matrix to sample from.
+/// @param targets Qubits to measure.
+/// @return Probability of each of the 2^targets outcomes.
+vec MarginalProbabilities(const cx_mat& rho, const vector<int>& targets) {
+    return MarginalProbabilities(Probabilities(rho), targets);
+}
+
+/// @brief Measurement probabilities of a set of target qubits, summed from
+///        the probabilities of every basis state.
+/// @param diag Probability of every basis state, e.g |psi|^2.
+/// @param targets Qubits to measure.
+/// @return Probability of each of the 2^targets outcomes.
+vec MarginalProbabilities(const vec& diag, const vector<int>& targets) {
+    int n = slog2(diag.n_elem);
+    if (targets.empty()) {
+        throw invalid_argument("There should be atleast 1 target");
+    }
+    vector<int> sorted = targets;
+    sort(sorted.begin(), sorted.end());
+    for (size_t i = 0; i < sorted.size(); i++) {
+        if (sorted[i] < 0 || sorted[i] >= n ||
+            (i > 0 && sorted[i] == sorted[i - 1])) {
+            throw invalid_argument(
+                "Targets should be unique and in [0, " + to_string(n) +
+                "). Got " + to_string(sorted[i]));
+        }
+    }
+
+    vec marginal = vec(uword(1) << sorted.size(), arma::fill::zeros);
+    for (uword i = 0; i < diag.n_elem; i++) {
+        uword outcome = 0;
+        for (int t : sorted) {
+            outcome = (outcome << 1) | ((i >> (n - 1 - t)) & 1);
+        }
+        marginal(outcome) += diag(i);
+    }
+    return marginal;
+}
+
+/// @brief Picks the outcome whose cumulative probability first exceeds
+///        random. If rounding keeps the total below random the last outcome
+///        with a non zero probability is returned.
+/// @param probabilities Probability of every outcome.
+/// @param random Random value for sampling in [0, 1)
+/// @return The sampled outcome.
+int SampleOutcome(const vec& probabilities, double random) {
+    if (random < 0.0 || random >= 1.0) {
+        throw invalid_argument(
+            "Random value must be in [0, 1]. " +
+            to_string(random) + "was supplied");
+    }
+    vec cumulative = cumsum(probabilities);
+    for (uword i = 0; i < cumulative.n_elem; ++i) {
+        if (random < cumulative(i)) {
+            return static_cast<int>(i);
+        }
+    }
+    int outcome = static_cast<int>(cumulative.n_elem - 1);
+    while (outcome > 0 && !(probabilities(outcome) > 0)) {
+        outcome--;
+    }
+    return outcome;
+}
+
+/// @brief Builds an alias table (Vose's method) for a discrete distribution.
+/// @param probabilities Non negative weights, normalized internally.
+/// @return The alias table.
+AliasTable BuildAliasTable(const vec& probabilities) {
+    uword size = probabilities.n_elem;
+    double total = accu(probabilities);
+    if (size == 0 || !(total > 0) || any(probabilities < 0)) {
+        throw invalid_argument(
+            "Distribution must be non negative with a positive total");
+    }
+
+    vec scaled = probabilities * (static_cast<double>(size) / total);
+    AliasTable table = {vec(size, arma::fill::ones),
+                        arma::regspace<uvec>(0, size - 1)};
+    vector<uword> small;
+    vector<uword> large;
+    for (uword i = 0; i < size; i++) {
+        (scaled(i) < 1.0 ? small : large).push_back(i);
+    }
+    while (!small.empty() && !large.empty()) {
+        uword s = small.back();
+        small.pop_back();
+        uword l = large.back();
+        large.pop_back();
+        table.prob(s) = scaled(s);
+        table.alias(s) = l;
+        scaled(l) = (scaled(l) + scaled(s)) - 1.0;
+        (scaled(l) < 1.0 ? small : large).push_back(l);
+    }
+    // Entries left in either list only differ from 1 by rounding and keep
+    // their initial probability of 1.
+    return table;
+}
+
+/// @brief Draws one outcome from an alias table.
+/// @param table The alias table.
+/// @param u1 Uniform random value in [0, 1) selecting the column.
+/// @param u2 Uniform random value in [0, 1) selecting column or alias.
+/// @return The sampled outcome.
+int SampleAlias(const AliasTable& table, double u1, double u2) {
+    uword size = table.prob.n_elem;
+    uword i = std::min(static_cast<uword>(u1 * size), size - 1);
+    return static_cast<int>(u2 < table.prob(i) ? i : table.alias(i));
+}
+
+/// @brief Draws shots outcomes from a probability vector. Shot s uses block
+///        s of rng, so the outcomes do not depend on the thread count.
+static vector<int> SampleDistribution(const vec& probabilities, int shots,
+                                      const RandomStream& rng) {
+    if (shots < 0) {
+        throw invalid_argument("Shot count must be non negative");
+    }
+    AliasTable table = BuildAliasTable(probabilities);
+    vector<int> outcomes(shots);
+#ifdef _OPENMP
+    #pragma omp parallel for if (RunInParallel(shots))
+#endif
+    for (int s = 0; s < shots; s++) {
+        outcomes[s] = SampleAlias(table, rng.Uniform(s, 0),
+                                  rng.Uniform(s, 1));
+    }
+    return outcomes;
+}
+
+/// @brief Measures all qubits of rho shots times without collapsing it. The
+///        distribution is built once, each shot is O(1).
+/// @param rho Density matrix to sample from.
+/// @param shots Number of samples.
+/// @param seed Seed of the random generator.
+/// @return The outcome of every shot.
+vector<int> SampleShots(const cx_mat& rho, int shots, uint64_t seed) {
+    return SampleShots(rho, shots, RandomStream(seed));
+}
+
+/// @brief Measures all qubits of rho shots times without collapsing it.
+/// @param rho Density matrix to sample from.
+/// @param shots Number of samples.
+/// @param rng Random stream, shot s uses its block s.
+/// @return The outcome of every shot.
+vector<int> SampleShots(const cx_mat& rho, int shots,
+                        const RandomStream& rng) {
+    return SampleDistribution(Probabilities(rho), shots, rng);
+}
+
+/// @brief Measures a set of target qubits shots times without collapsing rho.
+/// @param rho Density matrix to sample from.
+/// @param targets Qubits to measure.
+/// @param shots Number of samples.
+/// @param seed Seed of the random generator.
+/// @return The outcome of every shot, ordered as in PartialSample.
+vector<int> PartialSampleShots(const cx_mat& rho, const vector<int>& targets,
+                               int shots, uint64_t seed) {
+    return PartialSampleShots(rho, targets, shots, RandomStream(seed));
+}
+
+/// @brief Measures a set of target qubits shots times without collapsing rho.
+/// @param rho Density matrix to sample from.
+/// @param targets Qubits to measure.
+/// @param shots Number of samples.
+/// @param rng Random stream, shot s uses its block s.
+/// @return The outcome of every shot, ordered as in PartialSample.
+vector<int> PartialSampleShots(const cx_mat& rho, const vector<int>& targets,
+                               int shots, const RandomStream& rng) {
+    return SampleDistribution(MarginalProbabilities(rho, targets), shots,
+                              rng);
+}
+
+/// @brief Counts how often every outcome occurs.
+/// @param outcomes Outcomes from SampleShots or PartialSampleShots.
+/// @param outcome_count Number of possible outcomes.
+/// @return The count of every outcome.
+vector<int> Histogram(const vector<int>& outcomes, int outcome_count) {
+    vector<int> counts(outcome_count, 0);
+    for (int outcome : outcomes) {
+        if (outcome < 0 || outcome >= outcome_count) {
+            throw invalid_argument(
+                "Outcome " + to_string(outcome) + " is outside of [0, " +
+                to_string(outcome_count) + ")");
+        }
+        counts[outcome]++;
+    }
+    return counts;
+}
+} // namespace dmqs
@@ -0,0 +1,310 @@
+#include <dmqs/sparse.hpp>
+#include <dmqs/dmqs.hpp>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dmqs {
+// Entries are keyed by row << 32 | col
+static const int kMaxSparseQubits = 32;
+
+static uint64_t Key(uword row, uword col) {
+    return (static_cast<uint64_t>(row) << 32) | col;
+}
+
+static uword Row(uint64_t key) {
+    return key >> 32;
+}
+
+static uword Col(uint64_t key) {
+    return key & 0xFFFFFFFF;
+}
+
+/// @brief Creates a sparse basis (or +/-) state from a binary string in the
+///        format of BinaryStringToDensityMatrix.
+/// @param bin A string of 0, 1, + and - e.g "0+1"
+/// @param max_fill Fill above which the state is promoted to dense.
+/// @param cutoff Entries with a magnitude at or below it are dropped.
+/// @param max_dense_qubits Largest system that is promoted to dense.
+SparseDensityMatrix::SparseDensityMatrix(const string& bin, double max_fill,
+                                         double cutoff, int max_dense_qubits)
+    : n_(bin.length()), max_fill_(max_fill), cutoff_(cutoff),
+      max_dense_qubits_(max_dense_qubits), is_dense_(false),
+      promotion_skipped_(false) {
+    if (n_ < 1 || n_ > kMaxSparseQubits) {
+        throw invalid_argument(
+            "Sparse density matrices support 1 to " +
+            to_string(kMaxSparseQubits) + " qubits. Got " + to_string(n_));
+    }
+    entries_t entries = {{Key(0, 0), cx_double(1, 0)}};
+    for (char c : bin) {
+        entries_t next;
+        for (const auto& [key, v] : entries) {
+            uword r = Row(key) << 1;
+            uword col = Col(key) << 1;
+            if (c == '0') {
+                next[Key(r, col)] = v;
+            } else if (c == '1') {
+                next[Key(r | 1, col | 1)] = v;
+            } else if (c == '+' || c == '-') {
+                double sign = c == '+' ? 0.5 : -0.5;
+                next[Key(r, col)] = 0.5 * v;
+                next[Key(r, col | 1)] = sign * v;
+                next[Key(r | 1, col)] = sign * v;
+                next[Key(r | 1, col | 1)] = 0.5 * v;
+            } else {
+                throw invalid_argument(
+                    "Invalid basis state '" + string(1, c) + "' in " + bin);
+            }
+        }
+        entries = std::move(next);
+    }
+    Update(std::move(entries));
+}
+
+// String literals would otherwise be ambiguous with the cx_mat text
+// constructor. The other backends that take a basis string or a density
+// matrix (State, LowRankState, BlockDiagonalState, RealState) forward
+// const char* for the same reason.
+SparseDensityMatrix::SparseDensityMatrix(const char* bin, double max_fill,
+                                         double cutoff, int max_dense_qubits)
+    : SparseDensityMatrix(string(bin), max_fill, cutoff, max_dense_qubits) {}
+
+/// @brief Creates a sparse density matrix from the nonzeros of rho.
+/// @param rho Density matrix.
+/// @param max_fill Fill above which the state is promoted to dense.
+/// @param cutoff Entries with a magnitude at or below it are dropped.
+/// @param max_dense_qubits Largest system that is promoted to dense.
+SparseDensityMatrix::SparseDensityMatrix(const cx_mat& rho, double max_fill,
+                                         double cutoff, int max_dense_qubits)
+    : n_(slog2(rho.n_rows)), max_fill_(max_fill), cutoff_(cutoff),
+      max_dense_qubits_(max_dense_qubits), is_dense_(false),
+      promotion_skipped_(false) {
+    if (rho.n_rows != rho.n_cols || (uword(1) << n_) != rho.n_rows) {
+        throw invalid_argument("Density matrix must be a square 2^n matrix");
+    }
+    entries_t entries;
+    for (uword c = 0; c < rho.n_cols; c++) {
+        for (uword r = 0; r < rho.n_rows; r++) {
+            if (rho(r, c) != cx_double(0, 0)) {
+                entries[Key(r, c)] = rho(r, c);
+            }
+        }
+    }
+    Update(std::move(entries));
+}
+
+/// @brief Number of qubits in the system.
+int SparseDensityMatrix::Qubits() const {
+    return n_;
+}
+
+/// @brief Whether the state has been promoted to a dense matrix.
+bool SparseDensityMatrix::IsDense() const {
+    return is_dense_;
+}
+
+/// @brief Whether the fill exceeded max_fill but the state stayed sparse
+///        because it has more than max_dense_qubits qubits.
+bool SparseDensityMatrix::DensePromotionSkipped() const {
+    return promotion_skipped_;
+}
+
+/// @brief Number of stored entries, 4^n once dense.
+size_t SparseDensityMatrix::NonZeros() const {
+    return is_dense_ ? dense_.n_elem : entries_.size();
+}
+
+/// @brief Fraction of the 4^n entries that are stored.
+double SparseDensityMatrix::Fill() const {
+    return NonZeros() / std::ldexp(1.0, 2 * n_);
+}
+
+/// @brief Entry of the density matrix.
+cx_double SparseDensityMatrix::At(uword row, uword col) const {
+    if (is_dense_) {
+        return dense_(row, col);
+    }
+    auto it = entries_.find(Key(row, col));
+    return it == entries_.end() ? cx_double(0, 0) : it->second;
+}
+
+/// @brief Converts the state to a dense density matrix, refused above
+///        max_dense_qubits qubits.
+cx_mat SparseDensityMatrix::Dense() const {
+    if (is_dense_) {
+        return dense_;
+    }
+    if (n_ > max_dense_qubits_) {
+        throw invalid_argument(
+            "A dense density matrix of " + to_string(n_) +
+            " qubits exceeds the limit of " + to_string(max_dense_qubits_));
+    }
+    uword dim = uword(1) << n_;
+    cx_mat rho = cx_mat(dim, dim, zeros);
+    for (const auto& [key, v] : entries_) {
+        rho(Row(key), Col(key)) = v;
+    }
+    return rho;
+}
+
+/// @brief Measurement probabilities of every basis state, see
+///        dmqs::Probabilities.
+vec SparseDensityMatrix::Probabilities() const {
+    if (is_dense_) {
+        return dmqs::Probabilities(dense_);
+    }
+    vec probabilities = vec(uword(1) << n_, arma::fill::zeros);
+    for (const auto& [key, v] : entries_) {
+        if (Row(key) == Col(key)) {
+            probabilities(Row(key)) = std::abs(v);
+        }
+    }
+    return probabilities;
+}
+
+/// @brief Applies a 1 qubit gate.
+/// @param U1 The 1 qubit gate.
+/// @param target The target qubit.
+void SparseDensityMatrix::ApplyGate(const cx_mat& U1, int target) {
+    uword target_mask = QubitMask(target);
+    if (is_dense_) {
+        ApplyGate1InPlace(dense_, U1, target);
+        return;
+    }
+    entries_t next;
+    Conjugate(U1, target_mask, 0, next);
+    Update(std::move(next));
+}
+
+void SparseDensityMatrix::ApplyGate(u_gate gate, int target) {
+    if (is_dense_) {
+        QubitMask(target);
+        ApplyGateInPlace(dense_, gate, target);
+        return;
+    }
+    ApplyGate(UGateToGate(gate), target);
+}
+
+/// @brief Applies a controlled 1 qubit gate.
+/// @param U1 The 1 qubit gate applied when the control is 1.
+/// @param control The control qubit.
+/// @param target The target qubit.
+void SparseDensityMatrix::ApplyCGate(const cx_mat& U1, int control,
+                                     int target) {
+    if (control == target) {
+        throw invalid_argument(
+            "Control and target qubit must be different. Got " +
+            to_string(control) + " for both");
+    }
+    uword control_mask = QubitMask(control);
+    uword target_mask = QubitMask(target);
+    if (is_dense_) {
+        ApplyCGate1InPlace(dense_, U1, control, target);
+        return;
+    }
+    entries_t next;
+    Conjugate(U1, target_mask, control_mask, next);
+    Update(std::move(next));
+}
+
+void SparseDensityMatrix::ApplyCGate(u_gate gate, int control, int target) {
+    if (is_dense_) {
+        QubitMask(control);
+        QubitMask(target);
+        ApplyCGateInPlace(dense_, gate, control, target);
+        return;
+    }
+    ApplyCGate(UGateToGate(gate), control, target);
+}
+
+/// @brief Applies a 1 qubit channel given by its Kraus operators.
+/// @param ops Kraus operators.
+/// @param qubit The qubit the channel acts on.
+void SparseDensityMatrix::ApplyChannel(const vector<kraus_t>& ops,
+                                       int qubit) {
+    uword target_mask = QubitMask(qubit);
+    if (is_dense_) {
+        apply_channel_in_place(dense_, ops, qubit);
+        return;
+    }
+    entries_t next;
+    for (const kraus_t& K : ops) {
+        Conjugate(K, target_mask, 0, next);
+    }
+    Update(std::move(next));
+}
+
+uword SparseDensityMatrix::QubitMask(int qubit) const {
+    if (qubit < 0 || qubit >= n_) {
+        throw invalid_argument(
+            "Qubit " + to_string(qubit) + " is outside of a " +
+            to_string(n_) + " qubit system");
+    }
+    return uword(1) << (n_ - 1 - qubit);
+}
+
+/// @brief Adds U rho U† to out, where U acts as U1 on the target when every
+///        control bit is set. Each entry spreads to at most 4 entries.
+void SparseDensityMatrix::Conjugate(const cx_mat& U1, uword target_mask,
+                                    uword control_mask,
+                                    entries_t& out) const {
+    uword rows[2];
+    uword cols[2];
+    cx_double row_factors[2];
+    cx_double col_factors[2];
+    // Fills the basis states a row or column index maps to
+    auto spread = [&](uword i, uword* targets, cx_double* factors,
+                      bool conjugate) {
+        if ((i & control_mask) != control_mask) {
+            targets[0] = i;
+            factors[0] = cx_double(1, 0);
+            return 1;
+        }
+        int count = 0;
+        uword bit = (i & target_mask) ? 1 : 0;
+        for (uword b = 0; b < 2; b++) {
+            cx_double u = U1(b, bit);
+            if (u != cx_double(0, 0)) {
+                targets[count] = b ? (i | target_mask) : (i & ~target_mask);
+                factors[count] = conjugate ? std::conj(u) : u;
+                count++;
+            }
+        }
+        return count;
+    };
+    for (const auto& [key, v] : entries_) {
+        int row_count = spread(Row(key), rows, row_factors, false);
+        int col_count = spread(Col(key), cols, col_factors, true);
+        for (int i = 0; i < row_count; i++) {
+            for (int j = 0; j < col_count; j++) {
+                out[Key(rows[i], cols[j])] +=
+                    (row_factors[i] * v) * col_factors[j];
+            }
+        }
+    }
+}
+
+/// @brief Replaces the entries, pruning zeros and entries at or below the
+///        cutoff, and promotes to dense once the fill exceeds max_fill if
+///        the system is at most max_dense_qubits qubits.
+void SparseDensityMatrix::Update(entries_t&& next) {
+    for (auto it = next.begin(); it != next.end();) {
+        double magnitude = std::abs(it->second);
+        if (magnitude == 0 || magnitude <= cutoff_) {
+            it = next.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    entries_ = std::move(next);
+    if (Fill() > max_fill_ && n_ > max_dense_qubits_) {
+        promotion_skipped_ = true;
+    } else if (Fill() > max_fill_) {
+        dense_ = Dense();
+        entries_.clear();
+        is_dense_ = true;
+    }
+}
+} // namespace dmqs
@@ -0,0 +1,314 @@
+#include <dmqs/state.hpp>
+#include <dmqs/dmqs.hpp>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace dmqs {
+/// @brief Reduced density matrix of the sorted targets of a state vector:
+///        psi is reshaped into a (targets x rest) matrix M and Tr_B is M M†.
+static cx_mat ReducedStateVector(const cx_vec& psi,
+                                 const vector<int>& sorted, int n) {
+    uword kept = uword(1) << sorted.size();
+    cx_mat M = cx_mat(kept, psi.n_elem / kept);
+    for (uword i = 0; i < psi.n_elem; i++) {
+        uword a = 0;
+        uword b = 0;
+        size_t next = 0;
+        for (int q = 0; q < n; q++) {
+            uword bit = (i >> (n - 1 - q)) & 1;
+            if (next < sorted.size() && sorted[next] == q) {
+                a = (a << 1) | bit;
+                next++;
+            } else {
+                b = (b << 1) | bit;
+            }
+        }
+        M(a, b) = psi(i);
+    }
+    return M * M.t();
+}
+
+/// @brief Creates a product state from a binary string in the format of
+///        BinaryStringToDensityMatrix.
+/// @param bin A string of 0, 1, + and - e.g "0+1"
+State::State(const string& bin)
+    : n_(bin.length()), is_vector_(true), promotions_(0),
+      vector_operations_(0), cache_(n_) {
+    if (bin.empty()) {
+        throw invalid_argument("A state needs at least 1 qubit");
+    }
+    double h = 1 / sqrt(2);
+    psi_ = cx_vec({cx_double(1, 0)});
+    for (char c : bin) {
+        cx_vec q;
+        if (c == '0') {
+            q = {cx_double(1, 0), cx_double(0, 0)};
+        } else if (c == '1') {
+            q = {cx_double(0, 0), cx_double(1, 0)};
+        } else if (c == '+') {
+            q = {cx_double(h, 0), cx_double(h, 0)};
+        } else if (c == '-') {
+            q = {cx_double(h, 0), cx_double(-h, 0)};
+        } else {
+            throw invalid_argument(
+                "Invalid basis state '" + string(1, c) + "' in " + bin);
+        }
+        psi_ = kron(psi_, q);
+    }
+}
+
+State::State(const char* bin) : State(string(bin)) {}
+
+/// @brief Creates a pure state from a normalized state vector. Its qubits
+///        may already be entangled, so the cache treats them as one group.
+State::State(const cx_vec& psi)
+    : n_(slog2(psi.n_elem)), psi_(psi), is_vector_(true), promotions_(0),
+      vector_operations_(0), cache_(n_) {
+    if (psi.n_elem < 2 || (uword(1) << n_) != psi.n_elem) {
+        throw invalid_argument("State vector must have 2^n entries");
+    }
+    cache_.MergeAll();
+}
+
+/// @brief Creates a state from a density matrix, it is never demoted back
+///        to a state vector. Its qubits may already be entangled, so the
+///        cache treats them as one group.
+State::State(const cx_mat& rho)
+    : n_(slog2(rho.n_rows)), rho_(rho), is_vector_(false), promotions_(0),
+      vector_operations_(0), cache_(n_) {
+    if (rho.n_rows < 2 || rho.n_rows != rho.n_cols ||
+        (uword(1) << n_) != rho.n_rows) {
+        throw invalid_argument("Density matrix must be a square 2^n matrix");
+    }
+    cache_.MergeAll();
+}
+
+/// @brief Number of qubits in the system.
+int State::Qubits() const {
+    return n_;
+}
+
+/// @brief Whether the state is still stored as a state vector.
+bool State::IsStateVector() const {
+    return is_vector_;
+}
+
+/// @brief The state vector, only available before promotion.
+const cx_vec& State::StateVector() const {
+    if (!is_vector_) {
+        throw invalid_argument(
+            "State has been promoted to a density matrix");
+    }
+    return psi_;
+}
+
+/// @brief The density matrix of the state, psi psi† before promotion.
+cx_mat State::DensityMatrix() const {
+    return is_vector_ ? cx_mat(psi_ * psi_.t()) : rho_;
+}
+
+/// @brief Measurement probabilities of every basis state.
+vec State::Probabilities() const {
+    if (is_vector_) {
+        return square(abs(psi_));
+    }
+    return dmqs::Probabilities(rho_);
+}
+
+/// @brief Reduced density matrix of the targets, served from the cache
+///        while none of them changed.
+/// @param targets Qubits to keep.
+/// @return The density matrix of the targets, ordered as dmqs::PartialTrace.
+cx_mat State::PartialTrace(const vector<int>& targets) const {
+    vector<int> sorted = targets;
+    std::sort(sorted.begin(), sorted.end());
+    if (sorted.empty()) {
+        throw invalid_argument("There should be atleast 1 target");
+    }
+    for (size_t i = 0; i < sorted.size(); i++) {
+        if (sorted[i] < 0 || sorted[i] >= n_ ||
+            (i > 0 && sorted[i] == sorted[i - 1])) {
+            throw invalid_argument(
+                "Targets should be unique and in [0, " + to_string(n_) +
+                "). Got " + to_string(sorted[i]));
+        }
+    }
+    return cache_.Get(sorted, [this](const vector<int>& key) {
+        if (is_vector_) {
+            return ReducedStateVector(psi_, key, n_);
+        }
+        return dmqs::PartialTrace(rho_, key);
+    });
+}
+
+/// @brief Samples a set of target qubits from their (cached) reduced state,
+///        see dmqs::PartialSample.
+int State::PartialSample(const vector<int>& targets, double random) const {
+    return Sample(PartialTrace(targets), random);
+}
+
+/// @brief Samples a set of target qubits, drawing the random value from rng.
+int State::PartialSample(const vector<int>& targets, RandomStream& rng) const {
+    return PartialSample(targets, rng.Uniform());
+}
+
+/// @brief The reduced state cache, for its hit and miss counters.
+const ReducedStateCache& State::Cache() const {
+    return cache_;
+}
+
+/// @brief Applies a 1 qubit gate matrix, staying a state vector.
+void State::ApplyGate(const cx_mat& U1, int target) {
+    cache_.Touch({target});
+    if (!is_vector_) {
+        ApplyGateInPlace(rho_, U1, target);
+        return;
+    }
+    ApplyGate1ToVectorInPlace(psi_, U1, target);
+    vector_operations_++;
+}
+
+void State::ApplyGate(u_gate gate, int target) {
+    cache_.Touch({target});
+    if (!is_vector_) {
+        ApplyGateInPlace(rho_, gate, target);
+        return;
+    }
+    ApplyGate1ToVectorInPlace(psi_, UGateToGate(gate), target);
+    vector_operations_++;
+}
+
+void State::ApplyCGate(u_gate gate, int control, int target) {
+    cache_.Touch({control, target});
+    if (!is_vector_) {
+        ApplyCGateInPlace(rho_, gate, control, target);
+        return;
+    }
+    ApplyCGate1ToVectorInPlace(psi_, UGateToGate(gate), control, target);
+    vector_operations_++;
+}
+
+void State::ApplyRotation(u_gate axis, double theta, int target) {
+    cache_.Touch({target});
+    if (!is_vector_) {
+        ApplyRotationInPlace(rho_, axis, theta, target);
+        return;
+    }
+    ApplyGate1ToVectorInPlace(psi_, RotationGate(axis, theta), target);
+    vector_operations_++;
+}
+
+void State::ApplyCRotation(u_gate axis, double theta, int control,
+                           int target) {
+    cache_.Touch({control, target});
+    if (!is_vector_) {
+        ApplyCRotationInPlace(rho_, axis, theta, control, target);
+        return;
+    }
+    ApplyCGate1ToVectorInPlace(psi_, RotationGate(axis, theta), control,
+                               target);
+    vector_operations_++;
+}
+
+void State::ApplySwap(int q1, int q2) {
+    cache_.Touch({q1, q2});
+    if (!is_vector_) {
+        ApplySwapInPlace(rho_, q1, q2);
+        return;
+    }
+    ApplyPermutationToVectorInPlace(psi_, SwapPermutation(q1, q2, n_));
+    vector_operations_++;
+}
+
+/// @brief Applies a 1 qubit channel. A single unitary Kraus operator keeps
+///        the state vector, any other channel promotes the state first.
+/// @param ops Kraus operators.
+/// @param qubit The qubit the channel acts on.
+void State::ApplyChannel(const vector<kraus_t>& ops, int qubit) {
+    CheckQubit(qubit);
+    cache_.Touch({qubit});
+    if (is_vector_ && ops.size() == 1 &&
+        approx_equal(ops[0].t() * ops[0], Id(), "absdiff", 1e-12)) {
+        ApplyGate1ToVectorInPlace(psi_, ops[0], qubit);
+        vector_operations_++;
+        return;
+    }
+    Promote();
+    apply_channel_in_place(rho_, ops, qubit);
+}
+
+/// @brief Applies ApplyAmplitudeDampeningAndDephasingInPlace, promoting the
+///        state first. No time passing leaves the state vector alone.
+void State::ApplyAmplitudeDampeningAndDephasing(int qubit, double T1,
+                                                double T2, double t) {
+    CheckQubit(qubit);
+    if (t == 0) {
+        return;
+    }
+    cache_.Touch({qubit});
+    Promote();
+    ApplyAmplitudeDampeningAndDephasingInPlace(rho_, qubit, T1, T2, t);
+}
+
+/// @brief Projects the target qubits onto a basis state, see
+///        CollapseInPlace. Projections keep a state vector pure.
+void State::Collapse(const vector<int>& targets, int state) {
+    cache_.Collapse(targets);
+    if (!is_vector_) {
+        CollapseInPlace(rho_, targets, state);
+        return;
+    }
+    CollapseInPlace(psi_, targets, state);
+    vector_operations_++;
+}
+
+/// @brief Measures the target qubits and collapses the state, see
+///        dmqs::MeasureAndCollapse.
+int State::MeasureAndCollapse(const vector<int>& targets, double random) {
+    cache_.Collapse(targets);
+    if (!is_vector_) {
+        return dmqs::MeasureAndCollapse(rho_, targets, random);
+    }
+    int outcome = dmqs::MeasureAndCollapse(psi_, targets, random);
+    vector_operations_++;
+    return outcome;
+}
+
+/// @brief Measures the target qubits and collapses the state, drawing the
+///        random value from rng.
+int State::MeasureAndCollapse(const vector<int>& targets, RandomStream& rng) {
+    return MeasureAndCollapse(targets, rng.Uniform());
+}
+
+/// @brief Converts the state vector to the density matrix psi psi†. Does
+///        nothing if the state already is a density matrix.
+void State::Promote() {
+    if (!is_vector_) {
+        return;
+    }
+    rho_ = psi_ * psi_.t();
+    psi_.reset();
+    is_vector_ = false;
+    promotions_++;
+}
+
+/// @brief Number of times the state was promoted to a density matrix.
+int64_t State::Promotions() const {
+    return promotions_;
+}
+
+/// @brief Number of operations applied to the state vector.
+int64_t State::VectorOperations() const {
+    return vector_operations_;
+}
+
+void State::CheckQubit(int qubit) const {
+    if (qubit < 0 || qubit >= n_) {
+        throw invalid_argument(
+            "Qubit " + to_string(qubit) + " is outside of a " +
+            to_string(n_) + " qubit system");
+    }
+}
+} // namespace dmqs
@@ -0,0 +1,86 @@
+#include <dmqs/async.hpp>
+#include <dmqs/dmqs.hpp>
+#include <coroutine>
+#include <exception>
+#include <future>
+#include "doctest/doctest.h"
+
+#define DEC12 1e-12
+using namespace dmqs;
+
+// Coroutine that starts at once and frees itself when done
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// Measures qubit 0 and copies the outcome onto qubit 1
+static Detached CopyOutcome(CommandQueue& queue, std::promise<int>& done) {
+    int outcome = co_await queue.Measure({0});
+    if (outcome == 1) {
+        queue.ApplyGate(GX, 1);
+    }
+    done.set_value(outcome);
+}
+
+TEST_CASE("Queued gates match the synchronous API") {
+    cx_mat expected = BinaryStringToDensityMatrix("0+1");
+    CommandQueue queue("0+1");
+    CHECK_EQ(queue.Qubits(), 3);
+    for (int i = 0; i < 50; i++) {
+        queue.ApplyGate(GH, i % 3);
+        queue.ApplyRotation(GRX, 10.0 * i, (i + 1) % 3);
+        queue.ApplyCGate(GX, i % 3, (i + 2) % 3);
+        ApplyGateInPlace(expected, GH, i % 3);
+        ApplyRotationInPlace(expected, GRX, 10.0 * i, (i + 1) % 3);
+        ApplyCGateInPlace(expected, GX, i % 3, (i + 2) % 3);
+    }
+    queue.ApplyChannel(AMPLITUDE_DAMPING, 0.3, 1);
+    queue.ApplySwap(0, 2);
+    apply_channel_in_place(expected, amplitude_damping_ops(0.3), 1);
+    ApplySwapInPlace(expected, 0, 2);
+    CHECK(approx_equal(queue.Snapshot(), expected, "absdiff", DEC12));
+    CHECK(queue.Batches() >= 1);
+}
+
+TEST_CASE("Measurements resolve as futures") {
+    CommandQueue queue("+0", 3);
+    queue.ApplyCGate(GX, 0, 1);
+    Measurement m = queue.Measure({0, 1});
+    int outcome = m.Get();
+    CHECK(m.Ready());
+    CHECK((outcome == 0 || outcome == 3));
+    cx_mat rho = queue.Snapshot();
+    CHECK(std::abs(rho(outcome, outcome) - 1.0) < DEC12);
+    // The lowest numbered target is the most significant bit
+    CommandQueue ordered("10");
+    CHECK_EQ(ordered.Measure({1, 0}).Get(), 2);
+}
+
+TEST_CASE("Measurements can be awaited") {
+    for (uint64_t seed = 0; seed < 8; seed++) {
+        CommandQueue queue("+0", seed);
+        std::promise<int> done;
+        CopyOutcome(queue, done);
+        int outcome = done.get_future().get();
+        queue.Flush();
+        cx_mat rho = queue.Snapshot();
+        int index = outcome == 1 ? 3 : 0;
+        CHECK(std::abs(rho(index, index) - 1.0) < DEC12);
+    }
+}
+
+TEST_CASE("Bad commands throw in the caller") {
+    CommandQueue queue("00");
+    CHECK_THROWS_AS(queue.ApplyGate(GX, 2), std::invalid_argument);
+    CHECK_THROWS_AS(queue.ApplyCGate(GX, 1, 1), std::invalid_argument);
+    CHECK_THROWS_AS(queue.Measure({}), std::invalid_argument);
+    queue.ApplyGate(GX, 0);
+    CHECK(approx_equal(queue.Snapshot(), BinaryStringToDensityMatrix("10"),
+                       "absdiff", DEC12));
+}
@@ -0,0 +1,100 @@
+#include <dmqs/blockdiag.hpp>
+#include <dmqs/dmqs.hpp>
+#include "doctest/doctest.h"
+
+#define DEC12 1e-12
+using namespace dmqs;
+
+TEST_CASE("Basis qubits start classical") {
+    BlockDiagonalState state("0+1");
+    CHECK_EQ(state.Qubits(), 3);
+    CHECK_EQ(state.ClassicalQubits(), 2);
+    CHECK(state.IsClassical(0));
+    CHECK_FALSE(state.IsClassical(1));
+    CHECK_EQ(state.StoredEntries(), arma::uword(16));
+    CHECK(approx_equal(state.DensityMatrix(),
+                       BinaryStringToDensityMatrix("0+1"), "absdiff",
+                       DEC12));
+    CHECK(approx_equal(state.Probabilities(),
+                       Probabilities(BinaryStringToDensityMatrix("0+1")),
+                       "absdiff", DEC12));
+    CHECK_THROWS_AS(BlockDiagonalState("0a"), std::invalid_argument);
+    CHECK_THROWS_AS(state.ApplyGate(GX, 3), std::invalid_argument);
+}
+
+TEST_CASE("Gates match the dense simulator") {
+    cx_mat expected = BinaryStringToDensityMatrix("0+10");
+    BlockDiagonalState state("0+10");
+    state.ApplyGate(GX, 0);
+    state.ApplyGate(GZ, 2);
+    state.ApplyCGate(GX, 0, 3);
+    state.ApplyCGate(GZ, 1, 2);
+    state.ApplyCRotation(GRZ, 30, 1, 3);
+    state.ApplySwap(0, 2);
+    ApplyGateInPlace(expected, GX, 0);
+    ApplyGateInPlace(expected, GZ, 2);
+    ApplyCGateInPlace(expected, GX, 0, 3);
+    ApplyCGateInPlace(expected, GZ, 1, 2);
+    ApplyCRotationInPlace(expected, GRZ, 30, 1, 3);
+    ApplySwapInPlace(expected, 0, 2);
+    // None of these create superpositions of the basis qubits
+    CHECK_EQ(state.Promotions(), 0);
+    CHECK_EQ(state.ClassicalQubits(), 3);
+    CHECK(approx_equal(state.DensityMatrix(), expected, "absdiff", DEC12));
+
+    state.ApplyGate(GH, 0);
+    state.ApplyCGate(GX, 1, 3);
+    state.ApplyRotation(GRY, 40, 2);
+    state.ApplySwap(1, 2);
+    ApplyGateInPlace(expected, GH, 0);
+    ApplyCGateInPlace(expected, GX, 1, 3);
+    ApplyRotationInPlace(expected, GRY, 40, 2);
+    ApplySwapInPlace(expected, 1, 2);
+    CHECK(state.Promotions() >= 2);
+    CHECK(approx_equal(state.DensityMatrix(), expected, "absdiff", DEC12));
+}
+
+TEST_CASE("Dephased qubits are demoted") {
+    cx_mat rho = BinaryStringToDensityMatrix("+0+");
+    ApplyCGateInPlace(rho, GX, 0, 1);
+    BlockDiagonalState state(rho);
+    CHECK_EQ(state.ClassicalQubits(), 0);
+
+    state.ApplyChannel(phase_damping_ops(1), 0);
+    apply_channel_in_place(rho, phase_damping_ops(1), 0);
+    CHECK(state.IsClassical(0));
+    CHECK(state.IsClassical(1));
+    CHECK_EQ(state.StoredEntries(), arma::uword(16));
+    CHECK(approx_equal(state.DensityMatrix(), rho, "absdiff", DEC12));
+
+    // Channels stay within the blocks of a classical qubit
+    state.ApplyChannel(amplitude_damping_ops(0.3), 0);
+    state.ApplyChannel(depolarizing_ops(0.2), 1);
+    state.ApplyChannel(amplitude_damping_ops(0.1), 2);
+    apply_channel_in_place(rho, amplitude_damping_ops(0.3), 0);
+    apply_channel_in_place(rho, depolarizing_ops(0.2), 1);
+    apply_channel_in_place(rho, amplitude_damping_ops(0.1), 2);
+    CHECK_EQ(state.Promotions(), 0);
+    CHECK(approx_equal(state.DensityMatrix(), rho, "absdiff", DEC12));
+
+    state.Dephase(2);
+    CHECK_EQ(state.ClassicalQubits(), 3);
+    CHECK(std::abs(trace(state.DensityMatrix()) - 1.0) < DEC12);
+}
+
+TEST_CASE("Measurement collapses onto one block") {
+    cx_mat rho = BinaryStringToDensityMatrix("+00");
+    ApplyCGateInPlace(rho, GX, 0, 1);
+    ApplyGateInPlace(rho, GH, 2);
+    for (double r : {0.2, 0.8}) {
+        BlockDiagonalState state(rho);
+        cx_mat expected = rho;
+        int outcome = state.MeasureAndCollapse({0, 1}, r);
+        CHECK_EQ(MeasureAndCollapse(expected, {0, 1}, r), outcome);
+        CHECK((outcome == 0 || outcome == 3));
+        CHECK(state.IsClassical(0));
+        CHECK(state.IsClassical(1));
+        CHECK(approx_equal(state.DensityMatrix(), expected, "absdiff",
+                           DEC12));
+    }
+}
@@ -0,0 +1,96 @@
+#include <dmqs/dmqs.hpp>
+#include <dmqs/state.hpp>
+#include <cmath>
+#include <vector>
+#include <string>
+#include "doctest/doctest.h"
+
+#define DEC14 1e-14
+using namespace dmqs;
+
+TEST_CASE("Reduced state cache versions") {
+    ReducedStateCache cache(4);
+    int traces = 0;
+    auto trace = [&traces](const vector<int>& key) {
+        traces++;
+        return cx_mat(1 << key.size(), 1 << key.size(), zeros);
+    };
+    cache.Get({1, 0}, trace);
+    cache.Get({0, 1}, trace);
+    CHECK_EQ(traces, 1);
+    CHECK_EQ(cache.Hits(), 1);
+    CHECK_EQ(cache.Misses(), 1);
+    // Operations on other qubits keep the entry
+    cache.Touch({2, 3});
+    cache.Get({0, 1}, trace);
+    CHECK_EQ(traces, 1);
+    cache.Touch({1});
+    CHECK_EQ(cache.Version(1), 1u);
+    cache.Get({0, 1}, trace);
+    CHECK_EQ(traces, 2);
+    // Collapsing qubit 3 only changes the qubits it interacted with
+    cache.Get({0}, trace);
+    cache.Collapse({3});
+    cache.Get({0}, trace);
+    CHECK_EQ(traces, 3);
+    CHECK_EQ(cache.Version(2), 2u);
+    cache.Touch({0, 2});
+    cache.Get({1}, trace);
+    cache.Collapse({3});
+    cache.Get({1}, trace);
+    CHECK_EQ(traces, 4);
+    cache.Invalidate();
+    cache.Get({1}, trace);
+    CHECK_EQ(traces, 5);
+    CHECK_THROWS(cache.Touch({4}));
+}
+
+TEST_CASE("State partial traces are cached") {
+    State state("+000");
+    state.ApplyCGate(GX, 0, 1);
+    auto check = [&state](const vector<int>& targets) {
+        CHECK(mat_eq(state.PartialTrace(targets),
+                     PartialTrace(state.DensityMatrix(), targets), DEC14));
+    };
+    check({0});
+    int64_t misses = state.Cache().Misses();
+    check({0});
+    state.ApplyGate(GH, 2);
+    state.ApplyCGate(GX, 2, 3);
+    check({0});
+    CHECK_EQ(state.Cache().Misses(), misses);
+    // A channel on the partner promotes the state but leaves qubit 0 alone
+    state.ApplyChannel(amplitude_damping_ops(0.3), 1);
+    CHECK_FALSE(state.IsStateVector());
+    check({0});
+    CHECK_EQ(state.Cache().Misses(), misses);
+    check({0, 1});
+    CHECK_EQ(state.Cache().Misses(), misses + 1);
+    // Measuring qubit 1 changes qubit 0 through the entanglement, not 2
+    check({2});
+    misses = state.Cache().Misses();
+    state.MeasureAndCollapse({1}, 0.2);
+    check({2});
+    CHECK_EQ(state.Cache().Misses(), misses);
+    check({0});
+    CHECK_EQ(state.Cache().Misses(), misses + 1);
+    CHECK_EQ(state.PartialSample({0, 1}, 0.5),
+             PartialSample(state.DensityMatrix(), {0, 1}, 0.5));
+    CHECK_THROWS(state.PartialTrace({0, 0}));
+}
+
+TEST_CASE("States built from entangled input invalidate on collapse") {
+    cx_mat bell = BinaryStringToDensityMatrix("+0");
+    ApplyCGateInPlace(bell, GX, 0, 1);
+    State state(bell);
+    CHECK(mat_eq(state.PartialTrace({1}), PartialTrace(bell, {1}), DEC14));
+    state.MeasureAndCollapse({0}, 0.25);
+    CHECK(mat_eq(state.PartialTrace({1}),
+                 PartialTrace(state.DensityMatrix(), {1}), DEC14));
+    CHECK(std::abs(state.PartialTrace({1})(0, 0) - 1.0) < DEC14);
+
+    State vector_state(cx_vec(bell.col(0) * std::sqrt(2.0)));
+    vector_state.PartialTrace({1});
+    vector_state.MeasureAndCollapse({0}, 0.75);
+    CHECK(std::abs(vector_state.PartialTrace({1})(1, 1) - 1.0) < DEC14);
+}
@@ -0,0 +1,113 @@
+#include <dmqs/dmqs.hpp>
+#include <dmqs/circuit.hpp>
+#include <vector>
+#include "doctest/doctest.h"
+
+#define DEC12 1e-12
+using namespace dmqs;
+
+static Operation Gate(u_gate gate, int q) {
+    Operation op;
+    op.kind = OpKind::GATE;
+    op.gate = gate;
+    op.qubits = {q};
+    return op;
+}
+
+static Operation Rotation(u_gate axis, double theta, int q) {
+    Operation op = Gate(axis, q);
+    op.kind = OpKind::ROTATION;
+    op.param = theta;
+    return op;
+}
+
+static Operation CGate(u_gate gate, int control, int target) {
+    Operation op = Gate(gate, control);
+    op.kind = OpKind::CGATE;
+    op.qubits = {control, target};
+    return op;
+}
+
+static cx_mat Run(const Circuit& circuit, const string& bin) {
+    cx_mat rho = BinaryStringToDensityMatrix(bin);
+    RandomStream rng(1);
+    RunCircuit(rho, circuit, rng);
+    return rho;
+}
+
+TEST_CASE("Circuit execution") {
+    Circuit circuit{2, 2, {Gate(GH, 0), CGate(GX, 0, 1)}};
+    cx_mat expected = BinaryStringToDensityMatrix("00");
+    ApplyGateInPlace(expected, GH, 0);
+    ApplyCGateInPlace(expected, GX, 0, 1);
+    CHECK(mat_eq(Run(circuit, "00"), expected, DEC12));
+
+    SUBCASE("Measurements fill classical bits") {
+        Operation m0;
+        m0.kind = OpKind::MEASURE;
+        m0.qubits = {0};
+        m0.clbit = 1;
+        Operation m1 = m0;
+        m1.qubits = {1};
+        m1.clbit = 0;
+        circuit.ops.push_back(m0);
+        circuit.ops.push_back(m1);
+        for (uint64_t seed = 0; seed < 8; seed++) {
+            cx_mat rho = BinaryStringToDensityMatrix("00");
+            RandomStream rng(seed);
+            vector<int> bits = RunCircuit(rho, circuit, rng);
+            CHECK_EQ(bits[0], bits[1]);
+            CHECK(std::abs(Purity(rho) - 1) < DEC12);
+        }
+    }
+    SUBCASE("Errors") {
+        cx_mat rho = BinaryStringToDensityMatrix("000");
+        RandomStream rng(1);
+        CHECK_THROWS_AS(RunCircuit(rho, circuit, rng), std::invalid_argument);
+        Circuit bad{2, 0, {Gate(GX, 2)}};
+        rho = BinaryStringToDensityMatrix("00");
+        CHECK_THROWS_AS(RunCircuit(rho, bad, rng), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Circuit optimizer") {
+    OptimizationStats stats;
+    SUBCASE("Runs of 1 qubit gates are fused") {
+        Circuit circuit{2, 0, {Gate(GH, 0), Rotation(GRZ, 30, 0),
+                               Gate(GX, 1), Gate(GH, 0), Gate(GY, 1),
+                               CGate(GX, 0, 1), Rotation(GRY, 20, 1)}};
+        Circuit optimized = OptimizeCircuit(circuit, &stats);
+        CHECK_EQ(optimized.ops.size(), size_t(4));
+        CHECK_EQ(stats.fused, 3);
+        CHECK_EQ(optimized.ops[0].kind, OpKind::UNITARY);
+        CHECK(mat_eq(Run(optimized, "01"), Run(circuit, "01"), DEC12));
+    }
+    SUBCASE("Inverse pairs cancel") {
+        Circuit circuit{3, 0, {Gate(GH, 0), Gate(GH, 0), CGate(GX, 0, 1),
+                               Gate(GZ, 2), CGate(GX, 0, 1),
+                               Rotation(GRX, 180, 2), Rotation(GRX, 180, 2),
+                               Gate(GID, 1)}};
+        Circuit optimized = OptimizeCircuit(circuit, &stats);
+        CHECK_EQ(optimized.ops.size(), size_t(1));
+        CHECK_EQ(stats.cancelled, 5);
+        CHECK_EQ(stats.fused, 2);
+        CHECK(mat_eq(Run(optimized, "+0+"), Run(circuit, "+0+"), DEC12));
+    }
+    SUBCASE("Barriers and non unitaries stop fusion") {
+        Operation barrier;
+        barrier.kind = OpKind::BARRIER;
+        barrier.qubits = {0, 1};
+        Operation channel;
+        channel.kind = OpKind::CHANNEL;
+        channel.channel = DEPOLARIZING;
+        channel.param = 0.2;
+        channel.qubits = {1};
+        Circuit circuit{2, 0, {Gate(GH, 0), barrier, Gate(GH, 0),
+                               CGate(GX, 0, 1), barrier, CGate(GX, 0, 1),
+                               Gate(GX, 1), channel, Gate(GX, 1)}};
+        Circuit optimized = OptimizeCircuit(circuit, &stats);
+        CHECK_EQ(optimized.ops.size(), size_t(7));
+        CHECK_EQ(stats.fused + stats.cancelled, 0);
+        CHECK(mat_eq(Run(optimized, "01"), Run(circuit, "01"), DEC12));
+    }
+}
@@ -0,0 +1,86 @@
+#include <dmqs/dmqs.hpp>
+#include <future>
+#include <thread>
+#include "doctest/doctest.h"
+
+#define DEC12 1e-12
+using namespace dmqs;
+
+TEST_CASE("Serial threshold") {
+    ExecutionContext context;
+    context.serial_threshold = 100;
+    ScopedExecutionContext scope(context);
+    CHECK_EQ(CurrentExecutionContext().serial_threshold, 100);
+    CHECK_FALSE(RunInParallel(99));
+    CHECK(RunInParallel(100) == (LibraryThreads() > 1));
+}
+
+TEST_CASE("Scoped context is restored") {
+    int threads = LibraryThreads();
+    int blas_threads = BlasThreads();
+    int64_t threshold = CurrentExecutionContext().serial_threshold;
+    {
+        ScopedExecutionContext scope(ExecutionContext::Serial());
+        CHECK_EQ(LibraryThreads(), 1);
+        CHECK_EQ(BlasThreads(), 1);
+        CHECK_FALSE(RunInParallel(int64_t(1) << 40));
+
+        // Results do not depend on the context
+        cx_mat rho = BinaryStringToDensityMatrix("0+1-");
+        ApplyAmplitudeDampeningAndDephasingInPlace(rho, 1, 3, 2, 1);
+        CHECK(std::abs(Purity(rho) - trace(rho * rho).real()) < DEC12);
+    }
+    CHECK_EQ(LibraryThreads(), threads);
+    CHECK_EQ(BlasThreads(), blas_threads);
+    CHECK_EQ(CurrentExecutionContext().serial_threshold, threshold);
+}
+
+TEST_CASE("Overlapping serial scopes keep BLAS serial") {
+    int blas_threads = BlasThreads();
+    std::promise<void> entered;
+    std::promise<void> release;
+    std::thread worker([&entered, &release] {
+        ScopedExecutionContext scope(ExecutionContext::Serial());
+        entered.set_value();
+        release.get_future().wait();
+    });
+    entered.get_future().wait();
+    {
+        ScopedExecutionContext scope(ExecutionContext::Serial());
+    }
+    // The worker still runs under its serial scope
+    CHECK_EQ(BlasThreads(), 1);
+    {
+        ExecutionContext context;
+        context.serial_threshold = 5;
+        ScopedExecutionContext scope(context);
+    }
+    CHECK_EQ(BlasThreads(), 1);
+    release.set_value();
+    worker.join();
+    CHECK_EQ(BlasThreads(), blas_threads);
+}
+
+TEST_CASE("Context is per thread") {
+    ExecutionContext context;
+    context.serial_threshold = 7;
+    ScopedExecutionContext scope(context);
+    int64_t other = 0;
+    std::thread worker([&other] {
+        other = CurrentExecutionContext().serial_threshold;
+    });
+    worker.join();
+    CHECK_EQ(other, ExecutionContext().serial_threshold);
+    CHECK_EQ(CurrentExecutionContext().serial_threshold, 7);
+}
+
+TEST_CASE("Invalid contexts are rejected") {
+    ExecutionContext context;
+    context.threads = -1;
+    CHECK_THROWS_AS(SetExecutionContext(context), std::invalid_argument);
+#ifdef __linux__
+    context.threads = 0;
+    context.cpus = {-1};
+    CHECK_THROWS_AS(SetExecutionContext(context), std::invalid_argument);
+#endif
+}
@@ -0,0 +1,99 @@
+#include <dmqs/dmqs.hpp>
+#include <cmath>
+#include <vector>
+#include "doctest/doctest.h"
+
+#define DEC12 1e-12
+using namespace dmqs;
+
+static cx_mat Bell() {
+    cx_mat rho = BinaryStringToDensityMatrix("00");
+    ApplyGateInPlace(rho, GH, 0);
+    ApplyCGateInPlace(rho, GX, 0, 1);
+    return rho;
+}
+
+TEST_CASE("Purity matches tr(rho^2)") {
+    cx_mat rho = BinaryStringToDensityMatrix("0+1");
+    ApplyAmplitudeDampeningAndDephasingInPlace(rho, 0, 3, 4, 2);
+    ApplyAmplitudeDampeningAndDephasingInPlace(rho, 1, 5, 2, 1);
+    double expected = trace(rho * rho).real();
+    CHECK(std::abs(Purity(rho) - expected) < DEC12);
+    CHECK(std::abs(LinearEntropy(rho) - (1 - expected)) < DEC12);
+    CHECK(Purity(rho) < 1);
+
+    CHECK(std::abs(Purity(Bell()) - 1) < DEC12);
+    CHECK(IsPure(Bell(), DEC12));
+    CHECK_FALSE(IsPure(rho, DEC12));
+
+    cx_mat mixed = cx_mat(8, 8, arma::fill::eye) / 8.0;
+    CHECK(std::abs(Purity(mixed) - 1.0 / 8) < DEC12);
+}
+
+TEST_CASE("Fidelity with pure and mixed references") {
+    cx_mat rho = Bell();
+    ApplyAmplitudeDampeningAndDephasingInPlace(rho, 1, 3, 4, 1);
+    cx_vec psi(4, zeros);
+    psi(0) = psi(3) = 1 / std::sqrt(2.0);
+    cx_mat sigma = psi * psi.t();
+
+    double pure = Fidelity(rho, psi);
+    CHECK(std::abs(pure - cdot(psi, rho * psi).real()) < DEC12);
+    CHECK(std::abs(Fidelity(rho, sigma) - pure) < 1e-10);
+    CHECK(std::abs(Fidelity(sigma, rho) - pure) < 1e-10);
+    CHECK(std::abs(Fidelity(sigma, sigma) - 1) < 1e-10);
+
+    cx_mat zero = BinaryStringToDensityMatrix("00");
+    cx_mat one = BinaryStringToDensityMatrix("11");
+    CHECK(std::abs(Fidelity(zero, one)) < 1e-10);
+}
+
+TEST_CASE("Trace distance") {
+    cx_mat zero = BinaryStringToDensityMatrix("0");
+    cx_mat one = BinaryStringToDensityMatrix("1");
+    cx_mat plus = BinaryStringToDensityMatrix("+");
+    CHECK(std::abs(TraceDistance(zero, one) - 1) < DEC12);
+    CHECK(std::abs(TraceDistance(zero, zero)) < DEC12);
+    CHECK(std::abs(TraceDistance(zero, plus) - 1 / std::sqrt(2.0)) < DEC12);
+    CHECK(std::abs(TraceDistance(plus, zero) - TraceDistance(zero, plus)) <
+          DEC12);
+}
+
+TEST_CASE("Von Neumann entropy") {
+    CHECK(std::abs(VonNeumannEntropy(Bell())) < DEC12);
+    cx_mat reduced = PartialTrace(Bell(), {0});
+    CHECK(std::abs(VonNeumannEntropy(reduced) - 1) < DEC12);
+    cx_mat mixed = cx_mat(8, 8, arma::fill::eye) / 8.0;
+    CHECK(std::abs(VonNeumannEntropy(mixed) - 3) < DEC12);
+}
+
+TEST_CASE("Eigendecomposition is reused for an unchanged state") {
+    cx_mat rho = Bell();
+    ApplyAmplitudeDampeningAndDephasingInPlace(rho, 0, 2, 3, 1);
+    cx_vec psi(4, zeros);
+    psi(0) = 1;
+    cx_mat sigma = psi * psi.t();
+
+    int64_t before = EigendecompositionCount();
+    double entropy = VonNeumannEntropy(rho);
+    Fidelity(rho, sigma);
+    CHECK_EQ(VonNeumannEntropy(rho), entropy);
+    CHECK_EQ(EigendecompositionCount() - before, 1);
+
+    ApplyGateInPlace(rho, GX, 1);
+    VonNeumannEntropy(rho);
+    CHECK_EQ(EigendecompositionCount() - before, 2);
+    // Purity and pure fidelity never decompose
+    Purity(rho);
+    Fidelity(rho, psi);
+    CHECK_EQ(EigendecompositionCount() - before, 2);
+}
+
+TEST_CASE("Diagnostics reject mismatched sizes") {
+    cx_mat rho = BinaryStringToDensityMatrix("00");
+    cx_mat sigma = BinaryStringToDensityMatrix("0");
+    CHECK_THROWS_AS(Fidelity(rho, sigma), std::invalid_argument);
+    CHECK_THROWS_AS(TraceDistance(rho, sigma), std::invalid_argument);
+    CHECK_THROWS_AS(Fidelity(rho, cx_vec(2, zeros)), std::invalid_argument);
+    CHECK_THROWS_AS(Purity(cx_mat(2, 4, zeros)), std::invalid_argument);
+}
@@ -96,6 +96,53 @@ TEST_CASE("Rotation Gates") {
     CHECK(mat_eq(rz, rz, EXACT));
 }
 
+TEST_CASE("Apply rotation gates") {
+    cx_mat rho = BinaryStringToDensityMatrix("+01");
+    vector<double> angles = {0, 1, 45, 90, 180, 270, 360, 720};
+    SUBCASE("Rotation matches full gate") {
+        for (double theta : angles) {
+            for (int q = 0; q < 3; q++) {
+                cx_mat expected = ApplyGateToDensityMatrix(
+                    rho, GateToNQubitSystem(RX(theta), q, 3));
+                CHECK(mat_eq(ApplyRotation(rho, GRX, theta, q), expected,
+                             DEC14));
+                expected = ApplyGateToDensityMatrix(
+                    rho, GateToNQubitSystem(RY(theta), q, 3));
+                CHECK(mat_eq(ApplyRotation(rho, GRY, theta, q), expected,
+                             DEC14));
+                expected = ApplyGateToDensityMatrix(
+                    rho, GateToNQubitSystem(RZ(theta), q, 3));
+                CHECK(mat_eq(ApplyRotation(rho, GRZ, theta, q), expected,
+                             DEC14));
+            }
+        }
+    }
+    SUBCASE("Controlled rotation matches full gate") {
+        for (double theta : angles) {
+            cx_mat expected = ApplyGateToDensityMatrix(rho,
+                                                       CG(RY(theta), 0, 2));
+            CHECK(mat_eq(ApplyCRotation(rho, GRY, theta, 0, 2), expected,
+                         DEC14));
+        }
+    }
+    SUBCASE("RY(180) flips like X up to phase") {
+        cx_mat r0 = BinaryStringToDensityMatrix("0");
+        CHECK(mat_eq(ApplyRotation(r0, GRY, 180, 0),
+                     BinaryStringToDensityMatrix("1"), DEC14));
+    }
+    SUBCASE("Repeated angles reuse the cached gate") {
+        CHECK(mat_eq(RotationGate(GRX, 12.5), RX(12.5), EXACT));
+        CHECK(mat_eq(RotationGate(GRX, 12.5), RX(12.5), EXACT));
+        CHECK(mat_eq(RotationGate(GRZ, 12.5), RZ(12.5), EXACT));
+    }
+    SUBCASE("Errors") {
+        CHECK_THROWS_WITH(ApplyRotation(rho, GH, 90, 0),
+                          doctest::Contains("not a rotation gate"));
+        CHECK_THROWS_WITH(ApplyGate(rho, GRX, 0),
+                          doctest::Contains("needs an angle"));
+    }
+}
+
 TEST_CASE("Controlled Gates Test") {
     map<string, cx_mat> states = {};
     // Generate all binary strings of size 2 and 3.
@@ -558,6 +605,41 @@ TEST_CASE("Basis Projection Edge Cases") {
     }
 }
 
+TEST_CASE("Measure and collapse") {
+    SUBCASE("Matches PartialSample and BasisProjections") {
+        cx_mat rho = BinaryStringToDensityMatrix("+-1+");
+        rho = ApplyCGate(rho, GX, 0, 2);
+        vector<vector<int>> target_sets = {{0}, {2}, {0, 1}, {1, 3},
+                                           {0, 2, 3}};
+        for (const vector<int>& targets : target_sets) {
+            for (double r : {0.05, 0.3, 0.55, 0.8, 0.99}) {
+                cx_mat collapsed = rho;
+                int outcome = MeasureAndCollapse(collapsed, targets, r);
+                CHECK_EQ(outcome, PartialSample(rho, targets, r));
+                CHECK(mat_eq(collapsed, BasisProjections(rho, targets, outcome),
+                             DEC14));
+                CHECK(abs(trace(collapsed) - 1.0) < DEC14);
+            }
+        }
+    }
+    SUBCASE("Collapse matches projector") {
+        cx_mat rho = BinaryStringToDensityMatrix("++");
+        rho = ApplyRotation(rho, GRY, 30, 1);
+        cx_mat P = kron(B1(), B0());
+        cx_mat expected = (P * rho) * P.t();
+        expected /= trace(expected);
+        CollapseInPlace(rho, {0, 1}, 2);
+        CHECK(mat_eq(rho, expected, DEC14));
+    }
+    SUBCASE("Errors") {
+        cx_mat rho = BinaryStringToDensityMatrix("01");
+        CHECK_THROWS_WITH(CollapseInPlace(rho, {0}, 1),
+                          doctest::Contains("probability 0"));
+        CHECK_THROWS(CollapseInPlace(rho, {0}, 2));
+        CHECK_THROWS(MeasureAndCollapse(rho, {0}, 1.0));
+    }
+}
+
 TEST_CASE("Quantum Teleportation") {
     cx_mat rho = BinaryStringToDensityMatrix("100");
     rho = ApplyGate(rho, GH, 0);
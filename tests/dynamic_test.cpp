@@ -0,0 +1,115 @@
+#include <dmqs/dynamic.hpp>
+#include <dmqs/dmqs.hpp>
+#include "doctest/doctest.h"
+
+#define DEC12 1e-12
+using namespace dmqs;
+
+TEST_CASE("Release traces out or projects a qubit") {
+    cx_mat rho = BinaryStringToDensityMatrix("0+1");
+    ApplyCGateInPlace(rho, GX, 1, 2);
+    ApplyAmplitudeDampeningAndDephasingInPlace(rho, 0, 3, 2, 1);
+    for (int q = 0; q < 3; q++) {
+        vector<int> kept;
+        for (int k = 0; k < 3; k++) {
+            if (k != q) {
+                kept.push_back(k);
+            }
+        }
+        cx_mat released = ReleaseQubit(rho, q);
+        CHECK_EQ(released.n_rows, arma::uword(4));
+        CHECK(approx_equal(released, PartialTrace(rho, kept), "absdiff",
+                           DEC12));
+    }
+
+    // Qubit 1 and 2 are perfectly anticorrelated
+    cx_mat projected = ReleaseQubit(rho, 1, 1);
+    cx_mat expected = BasisProjection(rho, 1, 1);
+    expected /= trace(expected);
+    CHECK(approx_equal(projected, PartialTrace(expected, {0, 2}), "absdiff",
+                       DEC12));
+    CHECK(std::abs(projected(2, 2) + projected(0, 0) - 1.0) < DEC12);
+    CHECK_THROWS_AS(ReleaseQubit(BinaryStringToDensityMatrix("0"), 0, 1),
+                    std::invalid_argument);
+    CHECK_THROWS_AS(ReleaseQubit(rho, 3), std::invalid_argument);
+}
+
+TEST_CASE("Allocate tensors in |0>") {
+    cx_mat rho = BinaryStringToDensityMatrix("+1");
+    CHECK(approx_equal(AllocateQubit(rho, 0),
+                       BinaryStringToDensityMatrix("0+1"), "absdiff",
+                       DEC12));
+    CHECK(approx_equal(AllocateQubit(rho, 1),
+                       BinaryStringToDensityMatrix("+01"), "absdiff",
+                       DEC12));
+    CHECK(approx_equal(AllocateQubit(rho, 2),
+                       BinaryStringToDensityMatrix("+10"), "absdiff",
+                       DEC12));
+    CHECK(approx_equal(ReleaseQubit(AllocateQubit(rho, 1), 1), rho,
+                       "absdiff", DEC12));
+    cx_mat empty(1, 1, arma::fill::ones);
+    CHECK(approx_equal(AllocateQubit(empty, 0),
+                       BinaryStringToDensityMatrix("0"), "absdiff", DEC12));
+}
+
+TEST_CASE("Qubits are only tensored in when used") {
+    DynamicState state;
+    int a = state.AllocateQubit();
+    int b = state.AllocateQubit();
+    CHECK_EQ(state.AllocatedQubits(), 2);
+    CHECK_EQ(state.LiveQubits(), 0);
+
+    // A lazy control is |0>, the gate does nothing
+    state.ApplyCGate(GX, a, b);
+    CHECK_EQ(state.LiveQubits(), 0);
+
+    state.ApplyGate(GH, a);
+    state.ApplyCGate(GX, a, b);
+    CHECK_EQ(state.LiveQubits(), 2);
+    cx_mat bell = BinaryStringToDensityMatrix("00");
+    ApplyGateInPlace(bell, GH, 0);
+    ApplyCGateInPlace(bell, GX, 0, 1);
+    CHECK(approx_equal(state.DensityMatrix(), bell, "absdiff", DEC12));
+
+    RandomStream rng(5);
+    int outcome = state.Measure(a, rng);
+    state.ReleaseQubit(a, outcome);
+    CHECK_EQ(state.LiveQubits(), 1);
+    CHECK(state.LiveOrder() == vector<int>{b});
+    CHECK(approx_equal(state.DensityMatrix(),
+                       BinaryStringToDensityMatrix(outcome ? "1" : "0"),
+                       "absdiff", DEC12));
+    CHECK_THROWS_AS(state.ApplyGate(GX, a), std::invalid_argument);
+}
+
+TEST_CASE("Recycled ancillas keep the working set small") {
+    DynamicState state("0");
+    RandomStream rng(11);
+    int data = 0;
+    state.ApplyGate(GH, data);
+    for (int round = 0; round < 20; round++) {
+        int ancilla = state.AllocateQubit();
+        state.ApplyCGate(GX, data, ancilla);
+        state.Measure(ancilla, rng);
+        state.Reset(ancilla);
+        CHECK_FALSE(state.IsLive(ancilla));
+        state.ReleaseQubit(ancilla);
+    }
+    CHECK_EQ(state.PeakLiveQubits(), 2);
+    CHECK_EQ(state.LiveQubits(), 1);
+    CHECK(std::abs(trace(state.DensityMatrix()) - 1.0) < DEC12);
+}
+
+TEST_CASE("Swap relabels qubits") {
+    DynamicState state("01");
+    int lazy = state.AllocateQubit();
+    state.ApplySwap(1, lazy);
+    CHECK_FALSE(state.IsLive(1));
+    CHECK(state.IsLive(lazy));
+    RandomStream rng(0);
+    CHECK_EQ(state.Measure(lazy, rng), 1);
+    CHECK_EQ(state.Measure(1, rng), 0);
+    CHECK(approx_equal(state.DensityMatrix(),
+                       BinaryStringToDensityMatrix("01"), "absdiff",
+                       DEC12));
+}
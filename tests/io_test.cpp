@@ -0,0 +1,116 @@
+#include <dmqs/dmqs.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "doctest/doctest.h"
+
+#define DEC14 1e-14
+#define DEC6 1e-6
+using namespace dmqs;
+
+static cx_mat MixedState(int n) {
+    arma::arma_rng::set_seed(7);
+    cx_mat A = arma::randu<cx_mat>(1 << n, 1 << n);
+    cx_mat rho = A * A.t();
+    return rho / trace(rho);
+}
+
+static string TempPath(const string& name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+TEST_CASE("Round trip of every layout") {
+    cx_mat rho = MixedState(4);
+    string path = TempPath("dmqs_io_layouts.rho");
+    for (StateLayout layout :
+         {StateLayout::FULL, StateLayout::PACKED, StateLayout::TILED}) {
+        SaveState(path, rho, layout, StatePrecision::DOUBLE, 4);
+        StateFileInfo info = ReadStateInfo(path);
+        CHECK_EQ(info.version, kStateFileVersion);
+        CHECK_EQ(info.qubits, 4);
+        CHECK(info.layout == layout);
+        CHECK_EQ(info.payload_offset % kStatePayloadAlignment, uint64_t(0));
+        CHECK(approx_equal(LoadState(path), rho, "absdiff", DEC14));
+
+        MappedState mapped(path);
+        CHECK(std::abs(mapped.At(3, 9) - rho(3, 9)) < DEC14);
+        CHECK(std::abs(mapped.At(9, 3) - rho(9, 3)) < DEC14);
+        CHECK(std::abs(mapped.At(15, 15) - rho(15, 15)) < DEC14);
+    }
+    CHECK_EQ(ReadStateInfo(path).tile, uint32_t(4));
+    SaveState(path, rho, StateLayout::PACKED);
+    CHECK_EQ(ReadStateInfo(path).payload_bytes, uint64_t(16 * 17 / 2 * 16));
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Float precision halves the payload") {
+    cx_mat rho = MixedState(3);
+    string path = TempPath("dmqs_io_float.rho");
+    SaveState(path, rho, StateLayout::FULL, StatePrecision::FLOAT);
+    StateFileInfo info = ReadStateInfo(path);
+    CHECK(info.precision == StatePrecision::FLOAT);
+    CHECK_EQ(info.payload_bytes, uint64_t(64 * 8));
+    CHECK(approx_equal(LoadState(path), rho, "absdiff", DEC6));
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Mapped full state is viewed in place") {
+    cx_mat rho = BinaryStringToDensityMatrix("0+1");
+    string path = TempPath("dmqs_io_view.rho");
+    SaveState(path, rho);
+    {
+        MappedState mapped(path);
+        cx_mat& view = mapped.Matrix();
+        CHECK(approx_equal(view, rho, "absdiff", DEC14));
+        CHECK_EQ(reinterpret_cast<uintptr_t>(view.memptr()) %
+                     kStatePayloadAlignment,
+                 uintptr_t(0));
+
+        // The mapping is private, evolving the view leaves the file alone
+        ApplyGateInPlace(view, GX, 0);
+        MappedState moved = std::move(mapped);
+        CHECK_EQ(moved.Matrix().memptr(), view.memptr());
+        CHECK(std::abs(moved.At(5, 5) - 1.0 / 2) < DEC14);
+    }
+    CHECK(approx_equal(LoadState(path), rho, "absdiff", DEC14));
+
+    SaveState(path, rho, StateLayout::PACKED);
+    MappedState packed(path);
+    CHECK_THROWS_AS(packed.Matrix(), std::invalid_argument);
+    CHECK_THROWS_AS(packed.At(8, 0), std::invalid_argument);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Corrupt files are rejected") {
+    cx_mat rho = MixedState(2);
+    string path = TempPath("dmqs_io_corrupt.rho");
+    SaveState(path, rho);
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in |
+                                    std::ios::out);
+        file.seekp(kStatePayloadAlignment + 24);
+        file.put(0x7f);
+    }
+    CHECK_THROWS_AS(LoadState(path), std::invalid_argument);
+    CHECK_NOTHROW(LoadState(path, false));
+
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in |
+                                    std::ios::out);
+        file.seekp(8);
+        file.put(2);
+    }
+    CHECK_THROWS_AS(ReadStateInfo(path), std::invalid_argument);
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << "not a state file";
+    }
+    CHECK_THROWS_AS(LoadState(path), std::invalid_argument);
+    std::remove(path.c_str());
+
+    CHECK_THROWS_AS(SaveState(path, cx_mat(3, 3)), std::invalid_argument);
+    CHECK_THROWS_AS(SaveState(path, rho, StateLayout::TILED,
+                              StatePrecision::DOUBLE, 3),
+                    std::invalid_argument);
+}
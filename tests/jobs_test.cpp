@@ -0,0 +1,94 @@
+#include <dmqs/jobs.hpp>
+#include <dmqs/context.hpp>
+#include <dmqs/qasm.hpp>
+#include <dmqs/dmqs.hpp>
+#include <future>
+#include <map>
+#include <vector>
+#include "doctest/doctest.h"
+
+#define DEC12 1e-12
+using namespace dmqs;
+
+static const char* kBell = "OPENQASM 2.0; qreg q[2]; creg c[2];"
+                           "h q[0]; cx q[0], q[1];";
+static const char* kMeasured = "OPENQASM 2.0; qreg q[2]; creg c[2];"
+                               "h q[0]; cx q[0], q[1]; measure q -> c;";
+
+TEST_CASE("Futures deliver job results") {
+    JobPool pool(2, 7);
+    CHECK_EQ(pool.Workers(), 2);
+    Job job{"00", CompileQasm(kBell), 1000};
+    std::future<JobResult> future = pool.Submit(job);
+    JobResult result = future.get();
+    CHECK(result.clbits == vector<int>{0, 0});
+    CHECK(std::abs(result.probabilities(0) - 0.5) < DEC12);
+    CHECK(std::abs(result.probabilities(3) - 0.5) < DEC12);
+    CHECK_EQ(result.counts.size(), size_t(4));
+    CHECK_EQ(result.counts[0] + result.counts[3], 1000);
+    CHECK_EQ(result.counts[1] + result.counts[2], 0);
+}
+
+TEST_CASE("Destroyed pools restore the BLAS threads") {
+    int blas_threads = BlasThreads();
+    {
+        JobPool pool(2, 7);
+        pool.Submit(Job{"00", CompileQasm(kBell), 10}).get();
+    }
+    CHECK_EQ(BlasThreads(), blas_threads);
+}
+
+TEST_CASE("Results do not depend on the worker count") {
+    std::shared_ptr<const Circuit> circuit = CompileQasm(kMeasured);
+    auto run = [&circuit](int workers) {
+        JobPool pool(workers, 42);
+        vector<std::future<JobResult>> futures;
+        for (int i = 0; i < 64; i++) {
+            futures.push_back(pool.Submit(Job{"00", circuit, 16}));
+        }
+        vector<vector<int>> results;
+        for (std::future<JobResult>& future : futures) {
+            JobResult result = future.get();
+            results.push_back(result.clbits);
+            results.push_back(result.counts);
+        }
+        return results;
+    };
+    CHECK(run(1) == run(4));
+}
+
+TEST_CASE("Completion queue") {
+    JobPool pool(3);
+    std::shared_ptr<const Circuit> circuit = CompileQasm(kBell);
+    std::map<uint64_t, bool> pending;
+    for (int i = 0; i < 20; i++) {
+        pending[pool.Enqueue(Job{"00", circuit, 0})] = true;
+    }
+    uint64_t failed = pool.Enqueue(Job{"000", circuit, 0});
+    JobResult result;
+    int collected = 0;
+    while (pool.NextCompleted(result)) {
+        if (result.id == failed) {
+            CHECK_FALSE(result.error.empty());
+        } else {
+            CHECK(result.error.empty());
+            CHECK(pending.count(result.id) == 1);
+            pending.erase(result.id);
+        }
+        collected++;
+    }
+    CHECK_EQ(collected, 21);
+    CHECK(pending.empty());
+    CHECK_FALSE(pool.TryNextCompleted(result));
+    CHECK_EQ(pool.Completed(), 21);
+}
+
+TEST_CASE("Failures are rethrown by futures") {
+    JobPool pool(1);
+    CHECK_THROWS_AS(pool.Submit(Job{"00", nullptr, 0}),
+                    std::invalid_argument);
+    std::future<JobResult> future =
+        pool.Submit(Job{"0x", CompileQasm(kBell), 0});
+    CHECK_THROWS_AS(future.get(), std::invalid_argument);
+    pool.Wait();
+}
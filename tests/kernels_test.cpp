@@ -0,0 +1,307 @@
+#include <dmqs/dmqs.hpp>
+#include <dmqs/channels.hpp>
+#include <dmqs/qasm.hpp>
+#include <vector>
+#include <string>
+#include "doctest/doctest.h"
+
+#define EXACT 0.0
+#define DEC14 1e-14
+using namespace dmqs;
+
+// Reference implementation using full matrix products
+static cx_mat Conjugate(const cx_mat& rho, const cx_mat& U) {
+    return (U * rho) * U.t();
+}
+
+static cx_mat MixedState(int n) {
+    arma::arma_rng::set_seed(42);
+    cx_mat A = arma::randu<cx_mat>(1 << n, 1 << n);
+    cx_mat rho = A * A.t();
+    return rho / trace(rho);
+}
+
+TEST_CASE("Bit insertion") {
+    // 0b101 around the middle bit of 0b1x01
+    CHECK_EQ(InsertBit(5, 2, 0), uword(9));
+    CHECK_EQ(InsertBit(5, 2, 1), uword(11));
+    CHECK_EQ(InsertBit(3, 1, 1), uword(7));
+    CHECK_EQ(InsertBit(3, 8, 0), uword(3));
+}
+
+TEST_CASE("Diagonal gate detection") {
+    CHECK(IsDiagonal(Z()));
+    CHECK(IsDiagonal(RZ(33)));
+    CHECK(IsDiagonal(P(45)));
+    CHECK(IsDiagonal(B0()));
+    CHECK(IsDiagonal(CG(Z(), 0, 2)));
+    CHECK_FALSE(IsDiagonal(X()));
+    CHECK_FALSE(IsDiagonal(H()));
+    CHECK_FALSE(IsDiagonal(CX()));
+}
+
+TEST_CASE("Diagonal gate phase tables") {
+    int n = 3;
+    cx_mat rho = MixedState(n);
+    SUBCASE("Single qubit") {
+        for (int q = 0; q < n; q++) {
+            cx_mat expected = Conjugate(rho, GateToNQubitSystem(RZ(70), q, n));
+            cx_mat res = ApplyDiagonal(rho, GateDiagonal(RZ(70), q, n));
+            CHECK(mat_eq(res, expected, DEC14));
+        }
+    }
+    SUBCASE("Controlled phase") {
+        for (int c = 0; c < n; c++) {
+            for (int t = 0; t < n; t++) {
+                if (c == t) continue;
+                cx_mat U = CG(P(30), c, t);
+                if (min(c, t) > 0) U = kron(Id(min(c, t)), U);
+                if (n - max(c, t) - 1 > 0) U = kron(U, Id(n - max(c, t) - 1));
+                cx_mat res = ApplyDiagonal(rho, CGateDiagonal(P(30), c, t, n));
+                CHECK(mat_eq(res, Conjugate(rho, U), DEC14));
+            }
+        }
+    }
+    SUBCASE("Fused tables") {
+        cx_vec fused = GateDiagonal(Z(), 0, n) % GateDiagonal(RZ(20), 2, n) %
+                       CGateDiagonal(P(90), 1, 2, n);
+        cx_mat expected = ApplyDiagonal(rho, GateDiagonal(Z(), 0, n));
+        expected = ApplyDiagonal(expected, GateDiagonal(RZ(20), 2, n));
+        expected = ApplyDiagonal(expected, CGateDiagonal(P(90), 1, 2, n));
+        CHECK(mat_eq(ApplyDiagonal(rho, fused), expected, DEC14));
+    }
+    SUBCASE("u_gate fast path matches full product") {
+        cx_mat expected = Conjugate(rho, GateToNQubitSystem(Z(), 1, n));
+        CHECK(mat_eq(ApplyGate(rho, GZ, 1), expected, DEC14));
+        cx_mat CZ = kron(CG(Z(), 0, 1), Id());
+        CHECK(mat_eq(ApplyCGate(rho, GZ, 0, 1), Conjugate(rho, CZ), DEC14));
+    }
+    SUBCASE("Errors") {
+        CHECK_THROWS_WITH(GateDiagonal(X(), 0, n),
+                          doctest::Contains("diagonal 1 qubit gate"));
+        CHECK_THROWS_WITH(GateDiagonal(Z(), n, n),
+                          doctest::Contains("outside of a"));
+        CHECK_THROWS_WITH(CGateDiagonal(Z(), 1, 1, n),
+                          doctest::Contains("qubit must be different"));
+        CHECK_THROWS(ApplyDiagonal(rho, GateDiagonal(Z(), 0, n - 1)));
+    }
+}
+
+TEST_CASE("Permutation gate detection") {
+    vector<uword> perm;
+    CHECK(IsPermutation(X(), perm));
+    CHECK_EQ(perm, vector<uword>({1, 0}));
+    CHECK(IsPermutation(CX(), perm));
+    CHECK_EQ(perm, vector<uword>({0, 1, 3, 2}));
+    CHECK(IsPermutation(SWAP(0, 2), perm));
+    CHECK_FALSE(IsPermutation(Y(), perm));
+    CHECK_FALSE(IsPermutation(H(), perm));
+    CHECK_FALSE(IsPermutation(B0(), perm));
+}
+
+TEST_CASE("Permutation gates") {
+    int n = 3;
+    cx_mat rho = MixedState(n);
+    SUBCASE("X") {
+        for (int q = 0; q < n; q++) {
+            cx_mat expected = Conjugate(rho, GateToNQubitSystem(X(), q, n));
+            CHECK(mat_eq(ApplyPermutation(rho, XPermutation(q, n)),
+                         expected, EXACT));
+            CHECK(mat_eq(ApplyGate(rho, GX, q), expected, EXACT));
+        }
+    }
+    SUBCASE("CX") {
+        cx_mat expected = Conjugate(rho, kron(CX(), Id()));
+        CHECK(mat_eq(ApplyPermutation(rho, CXPermutation({0}, 1, n)),
+                     expected, EXACT));
+        CHECK(mat_eq(ApplyCGate(rho, GX, 0, 1), expected, EXACT));
+        expected = Conjugate(rho, CG(X(), 2, 0));
+        CHECK(mat_eq(ApplyCGate(rho, GX, 2, 0), expected, EXACT));
+    }
+    SUBCASE("SWAP") {
+        CHECK(mat_eq(ApplySwap(rho, 0, 2), Conjugate(rho, SWAP(0, 2)),
+                     EXACT));
+        cx_mat expected = Conjugate(rho, kron(SWAP(0, 1), Id()));
+        CHECK(mat_eq(ApplySwap(rho, 0, 1), expected, EXACT));
+        CHECK(mat_eq(ApplySwap(ApplySwap(rho, 1, 2), 2, 1), rho, EXACT));
+    }
+    SUBCASE("Toffoli") {
+        cx_mat U = Id(n);
+        U.swap_rows(6, 7);
+        CHECK(mat_eq(ApplyPermutation(rho, CXPermutation({0, 1}, 2, n)),
+                     Conjugate(rho, U), EXACT));
+    }
+    SUBCASE("Caller defined cycle") {
+        vector<uword> perm = {1, 2, 3, 0, 4, 5, 6, 7};
+        cx_mat U = cx_mat(8, 8, zeros);
+        for (uword i = 0; i < perm.size(); i++) U(perm[i], i) = 1;
+        CHECK(mat_eq(ApplyPermutation(rho, perm), Conjugate(rho, U), EXACT));
+        CHECK(mat_eq(ApplyGateToDensityMatrix(rho, U), Conjugate(rho, U),
+                     EXACT));
+    }
+    SUBCASE("Errors") {
+        CHECK_THROWS_WITH(SwapPermutation(1, 1, n),
+                          doctest::Contains("The qubits to swap"));
+        CHECK_THROWS_WITH(CXPermutation({2}, 2, n),
+                          doctest::Contains("qubit must be different"));
+        CHECK_THROWS(ApplyPermutation(rho, {0, 0, 1, 2, 3, 4, 5, 6}));
+        CHECK_THROWS(ApplyPermutation(rho, XPermutation(0, 2)));
+    }
+}
+
+TEST_CASE("2x2 block kernel") {
+    int n = 3;
+    cx_mat rho = MixedState(n);
+    vector<cx_mat> gates = {H(), Y(), RX(33), RY(-71), X() * H()};
+    SUBCASE("Single qubit") {
+        for (const cx_mat& U1 : gates) {
+            for (int q = 0; q < n; q++) {
+                cx_mat res = rho;
+                ApplyGate1InPlace(res, U1, q);
+                cx_mat expected = Conjugate(rho, GateToNQubitSystem(U1, q, n));
+                CHECK(mat_eq(res, expected, DEC14));
+            }
+        }
+    }
+    SUBCASE("Controlled") {
+        for (const cx_mat& U1 : gates) {
+            cx_mat res = rho;
+            ApplyCGate1InPlace(res, U1, 2, 0);
+            CHECK(mat_eq(res, Conjugate(rho, CG(U1, 2, 0)), DEC14));
+            res = rho;
+            ApplyCGate1InPlace(res, U1, 0, 1);
+            CHECK(mat_eq(res, Conjugate(rho, kron(CG(U1, 0, 1), Id())),
+                         DEC14));
+        }
+    }
+    SUBCASE("Errors") {
+        CHECK_THROWS_WITH(ApplyCGate1InPlace(rho, H(), 1, 1),
+                          doctest::Contains("qubit must be different"));
+        CHECK_THROWS(ApplyGate1InPlace(rho, CX(), 0));
+    }
+}
+
+// Density matrix with a trace of 1.01 and a small anti-Hermitian part
+static cx_mat DriftedState(int n) {
+    cx_mat rho = MixedState(n) * 1.01;
+    arma::arma_rng::set_seed(7);
+    cx_mat A = arma::randu<cx_mat>(1 << n, 1 << n) * 1e-6;
+    return rho + (A - A.t());
+}
+
+static cx_mat Repaired(const cx_mat& rho) {
+    cx_mat h = 0.5 * (rho + rho.t());
+    return h / trace(h).real();
+}
+
+TEST_CASE("Kernels repair drift in the same pass") {
+    int n = 3;
+    cx_mat rho = DriftedState(n);
+    cx_mat clean = Repaired(rho);
+    SetRepairPolicy({1, 0});
+    ResetRepairs();
+    SUBCASE("Gate") {
+        for (int q = 0; q < n; q++) {
+            cx_mat res = rho;
+            ApplyGate1InPlace(res, H(), q);
+            cx_mat U = GateToNQubitSystem(H(), q, n);
+            CHECK(mat_eq(res, Conjugate(clean, U), DEC14));
+        }
+        CHECK_EQ(Repairs().repairs, n);
+    }
+    SUBCASE("Controlled gate") {
+        cx_mat res = rho;
+        ApplyCGate1InPlace(res, Y(), 2, 0);
+        CHECK(mat_eq(res, Conjugate(clean, CG(Y(), 2, 0)), DEC14));
+    }
+    SUBCASE("Diagonal gate") {
+        cx_mat res = rho;
+        ApplyDiagonalInPlace(res, GateDiagonal(RZ(40), 1, n));
+        cx_mat U = GateToNQubitSystem(RZ(40), 1, n);
+        CHECK(mat_eq(res, Conjugate(clean, U), DEC14));
+    }
+    SUBCASE("Channel") {
+        vector<kraus_t> ops = depolarizing_ops(0.3);
+        cx_mat res = rho;
+        ApplySuperop1InPlace(res, kraus_to_superop(ops), 1);
+        CHECK(mat_eq(res, apply_channel(clean, ops, 1), DEC14));
+    }
+    CHECK(std::abs(trace(rho).real() - 1.01) < DEC14);
+    CHECK(Repairs().trace_correction > 0);
+    CHECK(Repairs().hermiticity_correction > 0);
+    SetRepairPolicy(RepairPolicy());
+}
+
+TEST_CASE("Projections are not repaired") {
+    cx_mat rho = MixedState(3);
+    cx_mat expected = BasisProjection(rho, 1, 1);
+    cx_mat circuit_expected = rho;
+    RandomStream rng(1);
+    RunCircuit(circuit_expected, "qreg q[3]; b0 q[2];", rng);
+    SetRepairPolicy({1, 0});
+    ResetRepairs();
+    CHECK(mat_eq(BasisProjection(rho, 1, 1), expected, DEC14));
+    cx_mat res = rho;
+    RunCircuit(res, "qreg q[3]; b0 q[2];", rng);
+    CHECK(mat_eq(res, circuit_expected, DEC14));
+    CHECK_EQ(Repairs().repairs, 0);
+    SetRepairPolicy(RepairPolicy());
+}
+
+TEST_CASE("Repair policy triggers") {
+    int n = 2;
+    cx_mat rho = MixedState(n);
+    SUBCASE("Disabled") {
+        ResetRepairs();
+        ApplyGate1InPlace(rho, H(), 0);
+        CHECK_EQ(Repairs().passes, 1);
+        CHECK_EQ(Repairs().repairs, 0);
+    }
+    SUBCASE("Interval") {
+        SetRepairPolicy({3, 0});
+        ResetRepairs();
+        for (int i = 0; i < 7; i++) {
+            ApplyGate1InPlace(rho, H(), 0);
+        }
+        CHECK_EQ(Repairs().passes, 7);
+        CHECK_EQ(Repairs().repairs, 2);
+    }
+    SUBCASE("Threshold") {
+        SetRepairPolicy({0, 1e-3});
+        ResetRepairs();
+        ApplyGate1InPlace(rho, H(), 0);
+        CHECK_EQ(Repairs().repairs, 0);
+        rho *= 1.01;
+        ApplyGate1InPlace(rho, H(), 0);
+        CHECK_EQ(Repairs().repairs, 1);
+        CHECK(std::abs(trace(rho).real() - 1) < DEC14);
+        CHECK(std::abs(Repairs().trace_correction - (1 - 1 / 1.01)) < DEC14);
+    }
+    CHECK_THROWS_AS(SetRepairPolicy({-1, 0}), std::invalid_argument);
+    SetRepairPolicy(RepairPolicy());
+}
+
+TEST_CASE("Real kernels match the complex kernels") {
+    int n = 3;
+    cx_mat mixed = MixedState(n);
+    mat rho = real(mixed + mixed.st());
+    rho /= trace(rho);
+    cx_mat complex_rho = cx_mat(rho, mat(size(rho), arma::fill::zeros));
+    vector<cx_mat> gates = {H(), RY(-71), X() * H()};
+    for (const cx_mat& U1 : gates) {
+        mat res = rho;
+        cx_mat expected = complex_rho;
+        ApplyGate1InPlace(res, mat(real(U1)), 2);
+        ApplyGate1InPlace(expected, U1, 2);
+        ApplyCGate1InPlace(res, mat(real(U1)), 2, 0);
+        ApplyCGate1InPlace(expected, U1, 2, 0);
+        CHECK(arma::approx_equal(res, mat(real(expected)), "absdiff",
+                                 DEC14));
+    }
+    superop1_t S = kraus_to_superop(depolarizing_ops(0.3));
+    mat res = rho;
+    ApplySuperop1InPlace(res, real_superop1_t(real(S)), 1);
+    cx_mat channel = apply_channel(complex_rho, depolarizing_ops(0.3), 1);
+    CHECK(arma::approx_equal(res, mat(real(channel)), "absdiff", DEC14));
+    CHECK_THROWS(ApplyCGate1InPlace(res, mat(real(H())), 1, 1));
+}
@@ -0,0 +1,106 @@
+#include <dmqs/dmqs.hpp>
+#include <dmqs/channels.hpp>
+#include <cmath>
+#include <vector>
+#include <string>
+#include "doctest/doctest.h"
+
+#define DEC12 1e-12
+#define DEC8 1e-8
+using namespace dmqs;
+
+static const cx_mat lower = {
+    {cx_double(0, 0), cx_double(1, 0)},
+    {cx_double(0, 0), cx_double(0, 0)},
+};
+
+TEST_CASE("Lindblad amplitude damping") {
+    double gamma = 0.3;
+    double t = 2.0;
+    cx_mat rho = BinaryStringToDensityMatrix("+");
+    Lindbladian lindblad(cx_mat(2, 2, zeros), {sqrt(gamma) * lower});
+    cx_mat expected = apply_channel(rho, amplitude_damping_ops2(gamma, t));
+    CHECK(mat_eq(lindblad.Evolve(rho, t), expected, DEC12));
+    cx_mat integrated = rho;
+    lindblad.IntegrateInPlace(integrated, t);
+    CHECK(mat_eq(integrated, expected, DEC8));
+}
+
+TEST_CASE("Lindblad Pauli twirled relaxation") {
+    // Pauli rates matching the channel of ApplyAmplitudeDampeningAndDephasing
+    double T1[] = {12.0, 30.0};
+    double T2[] = {9.0, 14.0};
+    vector<cx_mat> ops;
+    for (int q = 0; q < 2; q++) {
+        double pxy = 1 / (4 * T1[q]);
+        double pz = 1 / (2 * T2[q]) - pxy;
+        ops.push_back(GateToNQubitSystem(sqrt(pxy) * X(), q, 2));
+        ops.push_back(GateToNQubitSystem(sqrt(pxy) * Y(), q, 2));
+        ops.push_back(GateToNQubitSystem(sqrt(pz) * Z(), q, 2));
+    }
+    Lindbladian lindblad(cx_mat(4, 4, zeros), ops);
+    cx_mat rho = ApplyCGate(BinaryStringToDensityMatrix("+0"), GX, 0, 1);
+    CHECK(mat_eq(lindblad.Evolve(rho, 7.0),
+                 ApplyAmplitudeDampeningAndDephasing(rho, T1, T2, 7.0),
+                 DEC12));
+}
+
+TEST_CASE("Lindblad driven evolution") {
+    int n = 3;
+    cx_mat H = 0.5 * GateToNQubitSystem(X(), 0, n) +
+               0.2 * kron(Id(), kron(Z(), Z()));
+    vector<cx_mat> ops = {GateToNQubitSystem(sqrt(0.1) * lower, 1, n),
+                          GateToNQubitSystem(sqrt(0.05) * Z(), 2, n)};
+    Lindbladian lindblad(H, ops);
+    cx_mat rho = BinaryStringToDensityMatrix("01+");
+    SUBCASE("Exact and adaptive agree") {
+        cx_mat exact = lindblad.Evolve(rho, 4.0);
+        cx_mat integrated = rho;
+        lindblad.IntegrateInPlace(integrated, 4.0);
+        CHECK(mat_eq(exact, integrated, DEC8));
+        CHECK_EQ(trace(exact).real(), doctest::Approx(1.0));
+        CHECK(mat_eq(exact, exact.t(), DEC12));
+    }
+    SUBCASE("Propagators are cached per dt") {
+        cx_mat stepped = rho;
+        for (int i = 0; i < 8; i++) {
+            lindblad.EvolveInPlace(stepped, 0.5);
+        }
+        CHECK_EQ(lindblad.CachedPropagators(), 1u);
+        CHECK(mat_eq(stepped, lindblad.Evolve(rho, 4.0), DEC12));
+        CHECK_EQ(lindblad.CachedPropagators(), 2u);
+    }
+    SUBCASE("Derivative matches superoperator") {
+        cx_mat d = lindblad.Superoperator() * arma::vectorise(rho);
+        d.reshape(rho.n_rows, rho.n_cols);
+        CHECK(mat_eq(lindblad.Derivative(rho), d, DEC12));
+    }
+}
+
+TEST_CASE("Lindblad adaptive path") {
+    int n = Lindbladian::kExactQubitLimit + 1;
+    vector<double> T1(n, 20.0);
+    vector<double> T2(n, 15.0);
+    T1[0] = 5.0;
+    T2[0] = 5.0;
+    Lindbladian lindblad = AmplitudeDampingAndDephasingLindbladian(T1, T2);
+    cx_mat rho = BinaryStringToDensityMatrix(string(n, '1'));
+    lindblad.EvolveInPlace(rho, 3.0);
+    CHECK_EQ(lindblad.CachedPropagators(), 0u);
+    cx_mat q0 = PartialTrace(rho, {0});
+    cx_mat q1 = PartialTrace(rho, {1});
+    CHECK_EQ(q0(1, 1).real(), doctest::Approx(exp(-3.0 / 5.0)));
+    CHECK_EQ(q1(1, 1).real(), doctest::Approx(exp(-3.0 / 20.0)));
+    CHECK_EQ(trace(rho).real(), doctest::Approx(1.0));
+}
+
+TEST_CASE("Lindblad errors") {
+    CHECK_THROWS(Lindbladian(cx_mat(3, 3, zeros), {}));
+    CHECK_THROWS(Lindbladian(cx_mat(2, 2, zeros), {cx_mat(4, 4, zeros)}));
+    CHECK_THROWS(AmplitudeDampingAndDephasingLindbladian({1.0}, {3.0}));
+    Lindbladian lindblad(cx_mat(2, 2, zeros), {lower});
+    cx_mat rho = BinaryStringToDensityMatrix("00");
+    CHECK_THROWS(lindblad.EvolveInPlace(rho, 1.0));
+    rho = BinaryStringToDensityMatrix("1");
+    CHECK_THROWS(lindblad.EvolveInPlace(rho, -1.0));
+}
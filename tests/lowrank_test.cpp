@@ -0,0 +1,82 @@
+#include <dmqs/dmqs.hpp>
+#include <dmqs/lowrank.hpp>
+#include <vector>
+#include <string>
+#include "doctest/doctest.h"
+
+#define DEC12 1e-12
+#define DEC14 1e-14
+using namespace dmqs;
+
+TEST_CASE("Low rank gates match dense") {
+    LowRankState state("0+1");
+    cx_mat rho = BinaryStringToDensityMatrix("0+1");
+    CHECK_EQ(state.Rank(), 1u);
+    CHECK(mat_eq(state.DensityMatrix(), rho, DEC14));
+    state.ApplyGate(GH, 0);
+    rho = ApplyGate(rho, GH, 0);
+    state.ApplyCGate(GX, 0, 2);
+    rho = ApplyCGate(rho, GX, 0, 2);
+    state.ApplyRotation(GRX, 25, 1);
+    rho = ApplyRotation(rho, GRX, 25, 1);
+    state.ApplyCRotation(GRY, 60, 2, 1);
+    rho = ApplyCRotation(rho, GRY, 60, 2, 1);
+    state.ApplySwap(0, 1);
+    rho = ApplySwap(rho, 0, 1);
+    state.ApplyGate(P(30), 2);
+    ApplyGateInPlace(rho, P(30), 2);
+    CHECK_EQ(state.Rank(), 1u);
+    CHECK(mat_eq(state.DensityMatrix(), rho, DEC14));
+}
+
+TEST_CASE("Low rank channels") {
+    cx_mat rho = ApplyCGate(BinaryStringToDensityMatrix("+00"), GX, 0, 1);
+    LowRankState state(rho);
+    CHECK_EQ(state.Rank(), 1u);
+    SUBCASE("Exact rank growth") {
+        vector<kraus_t> ad = amplitude_damping_ops(0.2);
+        vector<kraus_t> dp = depolarizing_ops(0.1);
+        state.ApplyChannel(ad, 0);
+        rho = apply_channel(rho, ad, 0);
+        CHECK_EQ(state.Rank(), 2u);
+        state.ApplyChannel(dp, 2);
+        rho = apply_channel(rho, dp, 2);
+        state.ApplyCGate(GX, 1, 2);
+        rho = ApplyCGate(rho, GX, 1, 2);
+        CHECK_LE(state.Rank(), 8u);
+        CHECK(mat_eq(state.DensityMatrix(), rho, DEC12));
+        CHECK_EQ(state.TruncationError(), doctest::Approx(0.0));
+    }
+    SUBCASE("Rank cap") {
+        LowRankState capped(rho, 1e-12, 1);
+        capped.ApplyChannel(amplitude_damping_ops(0.01), 0);
+        CHECK_EQ(capped.Rank(), 1u);
+        CHECK_GT(capped.TruncationError(), 0.0);
+        CHECK_EQ(trace(capped.DensityMatrix()).real(), doctest::Approx(1.0));
+    }
+}
+
+TEST_CASE("Low rank partial trace and sampling") {
+    cx_mat rho = ApplyCGate(BinaryStringToDensityMatrix("+0-"), GX, 0, 1);
+    rho = apply_channel(rho, amplitude_damping_ops(0.3), 1);
+    LowRankState state(rho);
+    for (vector<int> targets : vector<vector<int>>{{0}, {1}, {2}, {0, 2},
+                                                   {1, 2}, {0, 1, 2}}) {
+        CHECK(mat_eq(state.PartialTrace(targets), PartialTrace(rho, targets),
+                     DEC12));
+    }
+    CHECK(approx_equal(state.Probabilities(), Probabilities(rho), "absdiff",
+                       DEC12));
+    for (double r : {0.05, 0.3, 0.55, 0.8, 0.99}) {
+        CHECK_EQ(state.Sample(r), Sample(rho, r));
+        LowRankState collapsed = state;
+        cx_mat dense = rho;
+        INFO("random ", r);
+        CHECK_EQ(collapsed.MeasureAndCollapse({1}, r),
+                 MeasureAndCollapse(dense, {1}, r));
+        CHECK(mat_eq(collapsed.DensityMatrix(), dense, DEC12));
+    }
+    CHECK_THROWS(state.PartialTrace({3}));
+    CHECK_THROWS(state.PartialTrace({1, 1}));
+    CHECK_THROWS(LowRankState("01", 1e-12, 0));
+}
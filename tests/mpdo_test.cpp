@@ -0,0 +1,110 @@
+#include <dmqs/dmqs.hpp>
+#include <dmqs/mpdo.hpp>
+#include <vector>
+#include <string>
+#include "doctest/doctest.h"
+
+#define DEC12 1e-12
+#define DEC14 1e-14
+using namespace dmqs;
+
+TEST_CASE("MPDO product states") {
+    for (string bin : {"0", "1", "+", "-", "01+", "-10+"}) {
+        INFO(bin);
+        MPDO mpdo(bin);
+        CHECK(mat_eq(mpdo.DensityMatrix(), BinaryStringToDensityMatrix(bin),
+                     DEC14));
+        CHECK_EQ(mpdo.Trace(), doctest::Approx(1.0));
+        CHECK_EQ(mpdo.MaxBondDimension(), 1u);
+    }
+    CHECK_THROWS(MPDO("0x1"));
+    CHECK_THROWS(MPDO("01", 0));
+}
+
+TEST_CASE("MPDO matches dense") {
+    MPDO mpdo("0+10");
+    cx_mat rho = BinaryStringToDensityMatrix("0+10");
+    mpdo.ApplyGate(GH, 0);
+    rho = ApplyGate(rho, GH, 0);
+    mpdo.ApplyCGate(GX, 0, 1);
+    rho = ApplyCGate(rho, GX, 0, 1);
+    mpdo.ApplyChannel(amplitude_damping_ops(0.2), 1);
+    rho = apply_channel(rho, amplitude_damping_ops(0.2), 1);
+    SUBCASE("Nearest neighbour") {
+        mpdo.ApplyCGate(GX, 2, 1);
+        rho = ApplyCGate(rho, GX, 2, 1);
+        mpdo.ApplyCRotation(GRY, 35, 2, 3);
+        rho = ApplyCRotation(rho, GRY, 35, 2, 3);
+        mpdo.ApplyRotation(GRZ, 80, 3);
+        rho = ApplyRotation(rho, GRZ, 80, 3);
+        CHECK(mat_eq(mpdo.DensityMatrix(), rho, DEC12));
+    }
+    SUBCASE("Routed through SWAPs") {
+        mpdo.ApplyCGate(GX, 0, 3);
+        rho = ApplyCGate(rho, GX, 0, 3);
+        mpdo.ApplyCGate(GZ, 3, 1);
+        rho = ApplyCGate(rho, GZ, 3, 1);
+        mpdo.ApplySwap(0, 2);
+        rho = ApplySwap(rho, 0, 2);
+        mpdo.ApplyChannel(depolarizing_ops(0.1), 3);
+        rho = apply_channel(rho, depolarizing_ops(0.1), 3);
+        CHECK(mat_eq(mpdo.DensityMatrix(), rho, DEC12));
+    }
+    SUBCASE("Partial trace and sampling") {
+        for (vector<int> targets : vector<vector<int>>{{0}, {3}, {0, 2},
+                                                       {1, 3}, {0, 1, 3}}) {
+            CHECK(mat_eq(mpdo.PartialTrace(targets),
+                         PartialTrace(rho, targets), DEC12));
+        }
+        for (double r : {0.05, 0.3, 0.55, 0.8, 0.99}) {
+            INFO("random ", r);
+            vector<int> bits = mpdo.Sample(r);
+            CHECK_EQ(bits[0] * 8 + bits[1] * 4 + bits[2] * 2 + bits[3],
+                     Sample(rho, r));
+            CHECK_EQ(mpdo.PartialSample({1, 2}, r),
+                     PartialSample(rho, {1, 2}, r));
+            MPDO collapsed = mpdo;
+            cx_mat dense = rho;
+            CHECK_EQ(collapsed.MeasureAndCollapse({0, 2}, r),
+                     MeasureAndCollapse(dense, {0, 2}, r));
+            CHECK(mat_eq(collapsed.DensityMatrix(), dense, DEC12));
+        }
+    }
+}
+
+TEST_CASE("MPDO long chains") {
+    SUBCASE("GHZ chain keeps a small bond") {
+        int n = 40;
+        MPDO ghz(string(n, '0'));
+        ghz.ApplyGate(GH, 0);
+        for (int q = 1; q < n; q++) {
+            ghz.ApplyCGate(GX, q - 1, q);
+        }
+        ghz.ApplyChannel(phase_damping_ops(0.1), n / 2);
+        CHECK_LE(ghz.MaxBondDimension(), 4u);
+        CHECK_EQ(ghz.Trace(), doctest::Approx(1.0));
+        vector<int> low = ghz.Sample(0.2);
+        vector<int> high = ghz.Sample(0.7);
+        CHECK_EQ(low, vector<int>(n, 0));
+        CHECK_EQ(high, vector<int>(n, 1));
+        MPDO empty("00");
+        empty.ApplyChannel({kraus_t(arma::fill::zeros)}, 1);
+        CHECK_THROWS_AS(empty.Sample(0.5), std::invalid_argument);
+        cx_mat ends = ghz.PartialTrace({0, n - 1});
+        CHECK_EQ(ends(0, 0).real(), doctest::Approx(0.5));
+        CHECK_EQ(ends(3, 3).real(), doctest::Approx(0.5));
+    }
+    SUBCASE("Bond dimension cap") {
+        MPDO capped("000000", 2);
+        for (int layer = 0; layer < 3; layer++) {
+            for (int q = 0; q < 6; q++) {
+                capped.ApplyRotation(GRY, 40 + 10 * q, q);
+            }
+            for (int q = layer % 2; q < 5; q += 2) {
+                capped.ApplyCGate(GX, q, q + 1);
+            }
+        }
+        CHECK_LE(capped.MaxBondDimension(), 2u);
+        CHECK_GT(capped.TruncationError(), 0.0);
+    }
+}
@@ -0,0 +1,101 @@
+#include <dmqs/dmqs.hpp>
+#include <dmqs/channels.hpp>
+#include <vector>
+#include <string>
+#include "doctest/doctest.h"
+
+#define EXACT 0.0
+#define DEC14 1e-14
+using namespace dmqs;
+
+TEST_CASE("Single qubit channel kernel") {
+    cx_mat rho = BinaryStringToDensityMatrix("+1-");
+    rho = ApplyCGate(rho, GX, 0, 2);
+    for (u_channel c : {AMPLITUDE_DAMPING, PHASE_DAMPING, BIT_FLIP,
+                        PHASE_FLIP, DEPOLARIZING, BIT_PHASE_FLIP}) {
+        vector<kraus_t> ops = u_channel_to_ops_f(c)(0.3);
+        for (int q = 0; q < 3; q++) {
+            cx_mat expected = cx_mat(8, 8, zeros);
+            for (const kraus_t& K : ops) {
+                cx_mat KN = GateToNQubitSystem(K, q, 3);
+                expected += (KN * rho) * KN.t();
+            }
+            INFO("channel ", c, " qubit ", q);
+            CHECK(mat_eq(apply_channel(rho, ops, q), expected, DEC14));
+        }
+    }
+}
+
+TEST_CASE("Idle noise composes") {
+    cx_mat rho = BinaryStringToDensityMatrix("1+");
+    rho = ApplyCGate(rho, GX, 1, 0);
+    double T1[] = {12.0, 30.0};
+    double T2[] = {9.0, 14.0};
+    cx_mat stepped = rho;
+    for (int i = 0; i < 10; i++) {
+        stepped = ApplyAmplitudeDampeningAndDephasing(stepped, T1, T2, 0.7);
+    }
+    cx_mat once = ApplyAmplitudeDampeningAndDephasing(rho, T1, T2, 7.0);
+    CHECK(mat_eq(stepped, once, 1e-12));
+}
+
+TEST_CASE("Lazy idle noise scheduler") {
+    vector<double> T1 = {12.0, 30.0, 20.0};
+    vector<double> T2 = {9.0, 14.0, 25.0};
+    cx_mat rho = BinaryStringToDensityMatrix("1+0");
+    cx_mat eager = rho;
+    cx_mat lazy = rho;
+    IdleNoise noise(T1, T2);
+    for (int step = 0; step < 20; step++) {
+        eager = ApplyAmplitudeDampeningAndDephasing(eager, T1.data(),
+                                                    T2.data(), 0.5);
+        noise.Idle(0.5);
+        if (step % 5 == 4) {
+            // Only qubits 1 and 2 are touched by the gate
+            noise.Flush(lazy, {1, 2});
+            eager = ApplyCGate(eager, GX, 1, 2);
+            lazy = ApplyCGate(lazy, GX, 1, 2);
+        }
+    }
+    CHECK_EQ(noise.Pending(0), doctest::Approx(10.0));
+    CHECK_EQ(noise.Pending(1), 0.0);
+    noise.FlushAll(lazy);
+    CHECK(mat_eq(lazy, eager, 1e-12));
+    // 4 flushes of 2 qubits and a final flush of the only pending qubit
+    CHECK_EQ(noise.ChannelApplications(), 9);
+    CHECK_THROWS(IdleNoise({1.0}, {1.0, 2.0}));
+    CHECK_THROWS_AS(noise.Flush(rho, {3}), std::invalid_argument);
+    CHECK_THROWS_AS(noise.Pending(-1), std::invalid_argument);
+    CHECK_THROWS_AS(noise.Idle(3, 1.0), std::invalid_argument);
+}
+
+TEST_CASE("Noisy state flushes on every operation") {
+    vector<double> T1 = {12.0, 30.0, 20.0};
+    vector<double> T2 = {9.0, 14.0, 25.0};
+    cx_mat eager = BinaryStringToDensityMatrix("1+0");
+    NoisyState state(eager, T1, T2);
+    for (int step = 0; step < 12; step++) {
+        eager = ApplyAmplitudeDampeningAndDephasing(eager, T1.data(),
+                                                    T2.data(), 0.5);
+        state.Idle(0.5);
+        if (step % 3 == 2) {
+            state.ApplyCGate(GX, 1, 2);
+            state.ApplyRotation(GRY, 20.0 * step, 1);
+            ApplyCGateInPlace(eager, GX, 1, 2);
+            ApplyRotationInPlace(eager, GRY, 20.0 * step, 1);
+        }
+    }
+    // Qubit 0 was never touched, its reduced state still needs the noise
+    CHECK(state.Noise().Pending(0) > 0);
+    CHECK(mat_eq(state.PartialTrace({0}), PartialTrace(eager, {0}), 1e-12));
+    CHECK_EQ(state.Noise().Pending(0), 0.0);
+    state.Idle(1.0);
+    eager = ApplyAmplitudeDampeningAndDephasing(eager, T1.data(), T2.data(),
+                                                1.0);
+    cx_mat collapsed = eager;
+    CHECK_EQ(state.MeasureAndCollapse({1}, 0.3),
+             MeasureAndCollapse(collapsed, {1}, 0.3));
+    CHECK(mat_eq(state.DensityMatrix(), collapsed, 1e-12));
+    CHECK_THROWS_AS(state.ApplyGate(GX, 3), std::invalid_argument);
+    CHECK_THROWS(NoisyState(eager, {1.0}, {1.0}));
+}
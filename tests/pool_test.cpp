@@ -0,0 +1,80 @@
+#include <dmqs/pool.hpp>
+#include <dmqs/dmqs.hpp>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "doctest/doctest.h"
+
+#define DEC14 1e-14
+using namespace dmqs;
+
+TEST_CASE("Handles address their own state") {
+    StatePool pool;
+    int a = pool.Create("00");
+    int b = pool.Create("1+");
+    CHECK(a != 0);
+    CHECK(a != b);
+    CHECK_EQ(pool.Size(), size_t(2));
+    pool.Get(a).ApplyGate(GX, 0);
+    CHECK(approx_equal(pool.Get(a).DensityMatrix(),
+                       BinaryStringToDensityMatrix("10"), "absdiff", DEC14));
+    CHECK(approx_equal(pool.Get(b).DensityMatrix(),
+                       BinaryStringToDensityMatrix("1+"), "absdiff", DEC14));
+}
+
+TEST_CASE("Clone copies the state") {
+    StatePool pool;
+    int a = pool.Create("0");
+    int b = pool.Clone(a);
+    pool.Get(b).ApplyGate(GX, 0);
+    CHECK(approx_equal(pool.Get(a).DensityMatrix(),
+                       BinaryStringToDensityMatrix("0"), "absdiff", DEC14));
+    CHECK(approx_equal(pool.Get(b).DensityMatrix(),
+                       BinaryStringToDensityMatrix("1"), "absdiff", DEC14));
+    int c = pool.Create(State(BinaryStringToDensityMatrix("+")));
+    CHECK_FALSE(pool.Get(c).IsStateVector());
+}
+
+TEST_CASE("Destroyed handles are rejected") {
+    StatePool pool;
+    int a = pool.Create("0");
+    pool.Destroy(a);
+    CHECK_FALSE(pool.Contains(a));
+    CHECK_THROWS_AS(pool.Get(a), std::invalid_argument);
+    CHECK_THROWS_AS(pool.Destroy(a), std::invalid_argument);
+
+    // The slot is reused under a new generation
+    int b = pool.Create("1");
+    CHECK(b != a);
+    CHECK(pool.Contains(b));
+    CHECK_FALSE(pool.Contains(a));
+    CHECK_FALSE(pool.Contains(0));
+    CHECK_FALSE(pool.Contains(-1));
+
+    pool.Clear();
+    CHECK_EQ(pool.Size(), size_t(0));
+    CHECK_FALSE(pool.Contains(b));
+}
+
+TEST_CASE("Concurrent creation") {
+    StatePool pool;
+    std::vector<std::thread> threads;
+    std::vector<std::vector<int>> handles(4);
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&pool, &handles, t] {
+            for (int i = 0; i < 50; i++) {
+                handles[t].push_back(pool.Create("0+"));
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    CHECK_EQ(pool.Size(), size_t(200));
+    std::vector<int> all;
+    for (const std::vector<int>& h : handles) {
+        all.insert(all.end(), h.begin(), h.end());
+    }
+    std::sort(all.begin(), all.end());
+    CHECK(std::adjacent_find(all.begin(), all.end()) == all.end());
+}
@@ -0,0 +1,132 @@
+#include <dmqs/dmqs.hpp>
+#include <dmqs/qasm.hpp>
+#include <string>
+#include <vector>
+#include "doctest/doctest.h"
+
+#define DEC12 1e-12
+using namespace dmqs;
+
+TEST_CASE("Parse OpenQASM 2") {
+    Circuit circuit = ParseQasm(R"(
+        OPENQASM 2.0;
+        include "qelib1.inc";
+        // Two registers are laid out one after the other
+        qreg a[1];
+        qreg q[2];
+        creg c[3];
+        h q;
+        rx(pi/2) a[0];
+        cx q[0], q[1];
+        crz(-pi / 4 * 2) a[0], q[1];
+        #pragma dmqs depolarizing(0.01) q[1];
+        #pragma othertool ignored 1 2 3;
+        barrier a, q;
+        reset a[0];
+        measure q[1] -> c[1];
+    )");
+    CHECK_EQ(circuit.qubits, 3);
+    CHECK_EQ(circuit.clbits, 3);
+    REQUIRE_EQ(circuit.ops.size(), size_t(9));
+    CHECK_EQ(circuit.ops[0].qubits, vector<int>{1});
+    CHECK_EQ(circuit.ops[1].qubits, vector<int>{2});
+    CHECK_EQ(circuit.ops[2].kind, OpKind::ROTATION);
+    CHECK(std::abs(circuit.ops[2].param - 90) < DEC12);
+    CHECK_EQ(circuit.ops[3].qubits, vector<int>{1, 2});
+    CHECK_EQ(circuit.ops[4].kind, OpKind::CROTATION);
+    CHECK(std::abs(circuit.ops[4].param + 90) < DEC12);
+    CHECK_EQ(circuit.ops[5].kind, OpKind::CHANNEL);
+    CHECK_EQ(circuit.ops[5].channel, DEPOLARIZING);
+    CHECK_EQ(circuit.ops[6].qubits, vector<int>{0, 1, 2});
+    CHECK_EQ(circuit.ops[7].kind, OpKind::RESET);
+    CHECK_EQ(circuit.ops[8].kind, OpKind::MEASURE);
+    CHECK_EQ(circuit.ops[8].clbit, 1);
+}
+
+TEST_CASE("Run OpenQASM 2") {
+    ClearQasmCache();
+    string bell = "qreg q[2]; h q[0]; cx q[0], q[1];";
+    cx_mat expected = BinaryStringToDensityMatrix("00");
+    ApplyGateInPlace(expected, GH, 0);
+    ApplyCGateInPlace(expected, GX, 0, 1);
+    RandomStream rng(3);
+    cx_mat rho = BinaryStringToDensityMatrix("00");
+    CHECK(RunCircuit(rho, bell, rng).empty());
+    CHECK(mat_eq(rho, expected, DEC12));
+
+    SUBCASE("Cached by content") {
+        cx_mat again = BinaryStringToDensityMatrix("00");
+        RunCircuit(again, bell, rng);
+        CHECK_EQ(QasmCacheMisses(), 1);
+        CHECK_EQ(QasmCacheHits(), 1);
+        CHECK_EQ(CompileQasm(bell), CompileQasm(string(bell)));
+        CompileQasm(bell + " ");
+        CHECK_EQ(QasmCacheMisses(), 2);
+    }
+    SUBCASE("Gate set matches the library") {
+        string source = "qreg q[2]; s q[0]; t q[1]; sdg q[1]; y q[0];"
+                        "ry(0.3) q[1]; cy q[1], q[0]; swap q[0], q[1];"
+                        "tdg q[0]; p(0.7) q[1]; cz q[0], q[1];";
+        cx_mat ref = BinaryStringToDensityMatrix("+1");
+        ApplyGateInPlace(ref, P(90), 0);
+        ApplyGateInPlace(ref, P(45), 1);
+        ApplyGateInPlace(ref, P(-90), 1);
+        ApplyGateInPlace(ref, GY, 0);
+        ApplyRotationInPlace(ref, GRY, 0.3 * 180 / M_PI, 1);
+        ApplyCGateInPlace(ref, GY, 1, 0);
+        ApplySwapInPlace(ref, 0, 1);
+        ApplyGateInPlace(ref, P(-45), 0);
+        ApplyGateInPlace(ref, P(0.7 * 180 / M_PI), 1);
+        ApplyCGateInPlace(ref, GZ, 0, 1);
+        cx_mat res = BinaryStringToDensityMatrix("+1");
+        RunCircuit(res, source, rng);
+        CHECK(mat_eq(res, ref, DEC12));
+    }
+    SUBCASE("Noise pragmas") {
+        string source = "qreg q[2]; x q;"
+                        "#pragma dmqs amplitude_damping(0.3) q[1];";
+        cx_mat ref = BinaryStringToDensityMatrix("11");
+        apply_channel_in_place(ref, amplitude_damping_ops(0.3), 1);
+        cx_mat res = BinaryStringToDensityMatrix("00");
+        RunCircuit(res, source, rng);
+        CHECK(mat_eq(res, ref, DEC12));
+    }
+    SUBCASE("Foreign pragmas end with their line") {
+        string source = "qreg q[2];\n#pragma othertool 1 2\nx q[0];\n"
+                        "#pragma othertool 3; x q[1];";
+        cx_mat res = BinaryStringToDensityMatrix("00");
+        RunCircuit(res, source, rng);
+        CHECK(mat_eq(res, BinaryStringToDensityMatrix("11"), DEC12));
+    }
+    SUBCASE("Measure and reset") {
+        string source = "qreg q[2]; creg c[2]; x q[1]; h q[0];"
+                        "measure q -> c; reset q[1];";
+        for (int i = 0; i < 10; i++) {
+            cx_mat res = BinaryStringToDensityMatrix("00");
+            vector<int> bits = RunCircuit(res, source, rng);
+            CHECK_EQ(bits[1], 1);
+            cx_mat ref = BinaryStringToDensityMatrix(bits[0] ? "10" : "00");
+            CHECK(mat_eq(res, ref, DEC12));
+        }
+    }
+}
+
+TEST_CASE("OpenQASM 2 errors") {
+    auto fails = [](const string& source, const string& message) {
+        CHECK_THROWS_WITH_AS(ParseQasm(source), doctest::Contains(message),
+                             std::invalid_argument);
+    };
+    fails("OPENQASM 3.0;", "Only OpenQASM 2");
+    fails("qreg q[2];\nfoo q[0];", "line 2: Unsupported statement foo");
+    fails("qreg q[2]; x r[0];", "Unknown quantum register r");
+    fails("qreg q[2]; x q[2];", "outside of q[2]");
+    fails("qreg q[2]; cx q, q[1];", "indexed qubit arguments");
+    fails("qreg q[2]; cx q[1], q[1];", "two different qubits");
+    fails("qreg q[2]; x q[0]", "Expected ';'");
+    fails("qreg q[1]; rx(foo) q[0];", "Unknown identifier foo");
+    fails("qreg q[1]; #pragma dmqs noise(0.1) q[0];", "Unknown channel");
+    fails("qreg q[1]; #pragma dmqs bit_flip(2) q[0];", "in [0, 1]");
+    fails("include \"other.inc\";", "Unsupported include");
+    fails("qreg q[2]; creg q[2];", "already declared");
+    fails("qreg q[1]; creg c[2]; measure q -> c;", "sizes do not match");
+}
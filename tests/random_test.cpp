@@ -0,0 +1,104 @@
+#include <dmqs/dmqs.hpp>
+#include <dmqs/state.hpp>
+#include <random>
+#include <vector>
+#include "doctest/doctest.h"
+
+using namespace dmqs;
+
+TEST_CASE("Philox4x32-10 known answers") {
+    // Known answer vectors of the Random123 reference implementation
+    typedef RandomStream::block_t block_t;
+    CHECK_EQ(RandomStream::Philox4x32({0, 0, 0, 0}, {0, 0}),
+             block_t{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+    CHECK_EQ(RandomStream::Philox4x32(
+                 {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                 {0xffffffff, 0xffffffff}),
+             block_t{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
+    CHECK_EQ(RandomStream::Philox4x32(
+                 {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                 {0xa4093822, 0x299f31d0}),
+             block_t{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+}
+
+TEST_CASE("Random streams") {
+    RandomStream a(7);
+    RandomStream b(7);
+    SUBCASE("Same seed and stream repeat") {
+        for (int i = 0; i < 100; i++) {
+            CHECK_EQ(a(), b());
+        }
+    }
+    SUBCASE("Streams differ") {
+        RandomStream c(7, 1);
+        RandomStream d(8);
+        int equal = 0;
+        for (int i = 0; i < 100; i++) {
+            uint64_t x = a();
+            equal += (x == c()) + (x == d());
+        }
+        CHECK_EQ(equal, 0);
+    }
+    SUBCASE("Indexed values match the sequence") {
+        for (uint64_t i = 0; i < 10; i++) {
+            CHECK_EQ(a.Uniform(), b.Uniform(i, 0));
+            CHECK_EQ(a.Uniform(), b.Uniform(i, 1));
+        }
+        CHECK_EQ(a.Position(), uint64_t(10));
+        a.Seek(3);
+        CHECK_EQ(a.Uniform(), b.Uniform(3, 0));
+        CHECK_EQ(a.Position(), uint64_t(3));
+    }
+    SUBCASE("Uniform values") {
+        double sum = 0;
+        int n = 100000;
+        for (int i = 0; i < n; i++) {
+            double u = a.Uniform();
+            CHECK(u >= 0.0);
+            CHECK(u < 1.0);
+            sum += u;
+        }
+        CHECK(std::abs(sum / n - 0.5) < 0.01);
+    }
+    SUBCASE("Standard distributions") {
+        std::uniform_int_distribution<int> die(1, 6);
+        std::vector<int> counts(7, 0);
+        for (int i = 0; i < 60000; i++) {
+            counts[die(a)]++;
+        }
+        for (int f = 1; f <= 6; f++) {
+            CHECK(std::abs(counts[f] - 10000) < 500);
+        }
+    }
+}
+
+TEST_CASE("Sampling draws from random streams") {
+    cx_mat rho = BinaryStringToDensityMatrix("+-1");
+    SUBCASE("Shots only depend on seed and stream") {
+        RandomStream rng(3, 2);
+        CHECK_EQ(SampleShots(rho, 100, rng), SampleShots(rho, 100, rng));
+        CHECK_EQ(SampleShots(rho, 100, 3), SampleShots(rho, 100,
+                                                       RandomStream(3)));
+        CHECK_NE(SampleShots(rho, 100, rng), SampleShots(rho, 100, 3));
+    }
+    SUBCASE("Measurements advance the stream") {
+        RandomStream rng(11);
+        RandomStream replay(11);
+        for (int i = 0; i < 10; i++) {
+            CHECK_EQ(Sample(rho, rng), Sample(rho, replay.Uniform()));
+        }
+        cx_mat a = rho;
+        cx_mat b = rho;
+        CHECK_EQ(MeasureAndCollapse(a, {0, 1}, rng),
+                 MeasureAndCollapse(b, {0, 1}, replay.Uniform()));
+        CHECK(mat_eq(a, b, 0.0));
+    }
+    SUBCASE("State") {
+        State s("+-1");
+        RandomStream rng(5);
+        RandomStream replay(5);
+        int outcome = s.MeasureAndCollapse({0, 1}, rng);
+        CHECK_EQ(outcome, MeasureAndCollapse(rho, {0, 1}, replay));
+        CHECK_EQ(s.PartialSample({0, 1}, rng), outcome);
+    }
+}
@@ -0,0 +1,75 @@
+#include <dmqs/real.hpp>
+#include <dmqs/dmqs.hpp>
+#include "doctest/doctest.h"
+
+#define DEC12 1e-12
+using namespace dmqs;
+
+TEST_CASE("Real circuits stay real") {
+    cx_mat expected = BinaryStringToDensityMatrix("0+1");
+    RealState state("0+1");
+    CHECK(state.IsReal());
+    for (int i = 0; i < 20; i++) {
+        state.ApplyGate(GH, i % 3);
+        state.ApplyRotation(GRY, 15.0 * i, (i + 1) % 3);
+        state.ApplyCGate(GX, i % 3, (i + 2) % 3);
+        state.ApplyGate(GY, (i + 1) % 3);
+        ApplyGateInPlace(expected, GH, i % 3);
+        ApplyRotationInPlace(expected, GRY, 15.0 * i, (i + 1) % 3);
+        ApplyCGateInPlace(expected, GX, i % 3, (i + 2) % 3);
+        ApplyGateInPlace(expected, GY, (i + 1) % 3);
+    }
+    state.ApplyCGate(GZ, 0, 2);
+    state.ApplySwap(0, 1);
+    state.ApplyChannel(amplitude_damping_ops(0.2), 0);
+    state.ApplyChannel(phase_damping_ops(0.4), 1);
+    state.ApplyChannel(depolarizing_ops(0.1), 2);
+    ApplyCGateInPlace(expected, GZ, 0, 2);
+    ApplySwapInPlace(expected, 0, 1);
+    apply_channel_in_place(expected, amplitude_damping_ops(0.2), 0);
+    apply_channel_in_place(expected, phase_damping_ops(0.4), 1);
+    apply_channel_in_place(expected, depolarizing_ops(0.1), 2);
+    CHECK(state.IsReal());
+    CHECK_EQ(state.RealOperations(), 85);
+    CHECK(approx_equal(state.DensityMatrix(), expected, "absdiff", DEC12));
+    CHECK(approx_equal(state.Probabilities(), Probabilities(expected),
+                       "absdiff", DEC12));
+}
+
+TEST_CASE("Complex gates promote the state") {
+    cx_mat expected = BinaryStringToDensityMatrix("+0");
+    RealState state("+0");
+    state.ApplyCGate(GX, 0, 1);
+    state.ApplyRotation(GRZ, 30, 0);
+    state.ApplyGate(GH, 1);
+    ApplyCGateInPlace(expected, GX, 0, 1);
+    ApplyRotationInPlace(expected, GRZ, 30, 0);
+    ApplyGateInPlace(expected, GH, 1);
+    CHECK_FALSE(state.IsReal());
+    CHECK_EQ(state.RealOperations(), 1);
+    CHECK_THROWS_AS(state.RealMatrix(), std::invalid_argument);
+    CHECK(approx_equal(state.DensityMatrix(), expected, "absdiff", DEC12));
+
+    RealState controlled("+0");
+    controlled.ApplyCGate(GY, 0, 1);
+    CHECK_FALSE(controlled.IsReal());
+    CHECK_FALSE(RealState(expected).IsReal());
+    CHECK(RealState(BinaryStringToDensityMatrix("-1")).IsReal());
+}
+
+TEST_CASE("Measurement keeps the state real") {
+    cx_mat rho = BinaryStringToDensityMatrix("+0+");
+    ApplyCGateInPlace(rho, GX, 0, 1);
+    for (double r : {0.1, 0.6, 0.9}) {
+        RealState state(rho);
+        cx_mat expected = rho;
+        CHECK_EQ(state.MeasureAndCollapse({1, 2}, r),
+                 MeasureAndCollapse(expected, {1, 2}, r));
+        CHECK(state.IsReal());
+        CHECK(approx_equal(state.DensityMatrix(), expected, "absdiff",
+                           DEC12));
+    }
+    RealState state("0");
+    CHECK_THROWS_AS(state.MeasureAndCollapse({1}, 0.5),
+                    std::invalid_argument);
+}
@@ -0,0 +1,75 @@
+#include <dmqs/dmqs.hpp>
+#include <vector>
+#include <string>
+#include "doctest/doctest.h"
+
+#define EXACT 0.0
+#define DEC14 1e-14
+using namespace dmqs;
+
+TEST_CASE("Marginal probabilities") {
+    cx_mat rho = BinaryStringToDensityMatrix("+-10");
+    SUBCASE("Matches partial trace") {
+        vector<vector<int>> target_sets = {{0}, {3}, {0, 1}, {1, 2},
+                                           {0, 3}, {2, 0}, {1, 2, 3}};
+        for (const vector<int>& targets : target_sets) {
+            vec expected = abs(PartialTrace(rho, targets).diag());
+            INFO("targets: ", targets.size());
+            CHECK(approx_equal(MarginalProbabilities(rho, targets), expected,
+                               "absdiff", DEC14));
+        }
+    }
+    SUBCASE("Errors") {
+        CHECK_THROWS(MarginalProbabilities(rho, {}));
+        CHECK_THROWS(MarginalProbabilities(rho, {4}));
+        CHECK_THROWS(MarginalProbabilities(rho, {1, 1}));
+    }
+}
+
+TEST_CASE("Alias table") {
+    vec p = {0.1, 0.0, 0.6, 0.3};
+    AliasTable table = BuildAliasTable(p);
+    // Every column keeps its own mass plus the mass it aliases to.
+    vec mass = vec(p.n_elem, arma::fill::zeros);
+    for (uword i = 0; i < p.n_elem; i++) {
+        mass(i) += table.prob(i) / p.n_elem;
+        mass(table.alias(i)) += (1 - table.prob(i)) / p.n_elem;
+    }
+    CHECK(approx_equal(mass, p, "absdiff", DEC14));
+    for (double u = 0; u < 1; u += 0.01) {
+        CHECK_NE(SampleAlias(table, u, u), 1);
+    }
+    CHECK_THROWS(BuildAliasTable(vec({0.0, 0.0})));
+    CHECK_THROWS(BuildAliasTable(vec({-0.5, 1.5})));
+}
+
+TEST_CASE("Multi-shot sampling") {
+    cx_mat bell = BinaryStringToDensityMatrix("00");
+    bell = ApplyGate(bell, GH, 0);
+    bell = ApplyCGate(bell, GX, 0, 1);
+    int shots = 100000;
+    SUBCASE("Bell state histogram") {
+        vector<int> counts = Histogram(SampleShots(bell, shots, 7), 4);
+        CHECK_EQ(counts[1], 0);
+        CHECK_EQ(counts[2], 0);
+        CHECK_EQ(counts[0] + counts[3], shots);
+        CHECK(abs(counts[0] - shots / 2) < shots / 100);
+    }
+    SUBCASE("Same seed gives same shots") {
+        CHECK_EQ(SampleShots(bell, 100, 3), SampleShots(bell, 100, 3));
+    }
+    SUBCASE("Partial shots") {
+        cx_mat rho = BinaryStringToDensityMatrix("+-10");
+        vector<int> counts = Histogram(
+            PartialSampleShots(rho, {1, 2}, shots, 11), 4);
+        // Qubit 2 is always 1, qubit 1 is uniform.
+        CHECK_EQ(counts[0], 0);
+        CHECK_EQ(counts[2], 0);
+        CHECK_EQ(counts[1] + counts[3], shots);
+        CHECK(abs(counts[1] - shots / 2) < shots / 100);
+    }
+    SUBCASE("Errors") {
+        CHECK_THROWS(SampleShots(bell, -1, 0));
+        CHECK_THROWS(Histogram({0, 4}, 4));
+    }
+}
@@ -0,0 +1,122 @@
+#include <dmqs/dmqs.hpp>
+#include <dmqs/sparse.hpp>
+#include <vector>
+#include <string>
+#include "doctest/doctest.h"
+
+#define EXACT 0.0
+#define DEC14 1e-14
+using namespace dmqs;
+
+TEST_CASE("Sparse basis states") {
+    for (string bin : {"0", "1", "+", "-", "01+", "-10", "+-01"}) {
+        SparseDensityMatrix sparse(bin, 1.0);
+        INFO(bin);
+        CHECK(mat_eq(sparse.Dense(), BinaryStringToDensityMatrix(bin),
+                     DEC14));
+    }
+    SparseDensityMatrix basis("0110");
+    CHECK_EQ(basis.NonZeros(), 1u);
+    CHECK_EQ(basis.At(6, 6), cx_double(1, 0));
+    CHECK_EQ(basis.At(6, 5), cx_double(0, 0));
+    CHECK_FALSE(basis.IsDense());
+    CHECK_THROWS(SparseDensityMatrix("01x"));
+    CHECK_THROWS(SparseDensityMatrix(""));
+}
+
+TEST_CASE("Sparse gates match dense") {
+    cx_mat dense = BinaryStringToDensityMatrix("0+1");
+    SparseDensityMatrix sparse(dense, 1.0);
+    dense = ApplyCGate(dense, GX, 1, 0);
+    sparse.ApplyCGate(GX, 1, 0);
+    CHECK(mat_eq(sparse.Dense(), dense, EXACT));
+    dense = ApplyGate(dense, GH, 2);
+    sparse.ApplyGate(GH, 2);
+    CHECK(mat_eq(sparse.Dense(), dense, DEC14));
+    dense = ApplyRotation(dense, GRY, 33, 0);
+    sparse.ApplyGate(RY(33), 0);
+    CHECK(mat_eq(sparse.Dense(), dense, DEC14));
+    dense = ApplyCGate(dense, GZ, 0, 2);
+    sparse.ApplyCGate(GZ, 0, 2);
+    CHECK(mat_eq(sparse.Dense(), dense, DEC14));
+    CHECK(approx_equal(sparse.Probabilities(), Probabilities(dense),
+                       "absdiff", DEC14));
+    CHECK_THROWS(sparse.ApplyGate(GX, 3));
+    CHECK_THROWS(sparse.ApplyCGate(GX, 1, 1));
+}
+
+TEST_CASE("Sparse channels match dense") {
+    cx_mat dense = ApplyCGate(BinaryStringToDensityMatrix("+0"), GX, 0, 1);
+    for (u_channel c : {AMPLITUDE_DAMPING, PHASE_DAMPING, BIT_FLIP,
+                        DEPOLARIZING}) {
+        vector<kraus_t> ops = u_channel_to_ops_f(c)(0.2);
+        SparseDensityMatrix sparse(dense, 1.0);
+        sparse.ApplyChannel(ops, 1);
+        INFO("channel ", c);
+        CHECK(mat_eq(sparse.Dense(), apply_channel(dense, ops, 1), DEC14));
+    }
+}
+
+TEST_CASE("Sparse GHZ state") {
+    // 4^24 entries would never fit in memory as a dense matrix
+    int n = 24;
+    SparseDensityMatrix ghz(string(n, '0'));
+    ghz.ApplyGate(GH, 0);
+    for (int q = 1; q < n; q++) {
+        ghz.ApplyCGate(GX, q - 1, q);
+    }
+    CHECK_FALSE(ghz.IsDense());
+    CHECK_EQ(ghz.NonZeros(), 4u);
+    uword ones = (uword(1) << n) - 1;
+    CHECK_EQ(ghz.At(0, 0).real(), doctest::Approx(0.5));
+    CHECK_EQ(ghz.At(ones, ones).real(), doctest::Approx(0.5));
+    CHECK_EQ(ghz.At(0, ones).real(), doctest::Approx(0.5));
+    // Undoing the preparation cancels the off diagonal entries exactly
+    for (int q = n - 1; q > 0; q--) {
+        ghz.ApplyCGate(GX, q - 1, q);
+    }
+    ghz.ApplyGate(GH, 0);
+    CHECK_EQ(ghz.NonZeros(), 1u);
+}
+
+TEST_CASE("Sparse promotion and pruning") {
+    SUBCASE("Promotes once the fill exceeds the threshold") {
+        SparseDensityMatrix sparse("000", 0.25);
+        cx_mat dense = BinaryStringToDensityMatrix("000");
+        sparse.ApplyGate(GH, 0);
+        dense = ApplyGate(dense, GH, 0);
+        CHECK_FALSE(sparse.IsDense());
+        sparse.ApplyGate(GH, 1);
+        dense = ApplyGate(dense, GH, 1);
+        CHECK_FALSE(sparse.IsDense());
+        sparse.ApplyGate(GH, 2);
+        dense = ApplyGate(dense, GH, 2);
+        CHECK(sparse.IsDense());
+        CHECK_EQ(sparse.Fill(), 1.0);
+        sparse.ApplyCGate(GX, 0, 2);
+        dense = ApplyCGate(dense, GX, 0, 2);
+        CHECK(mat_eq(sparse.Dense(), dense, DEC14));
+    }
+    SUBCASE("Promotion respects the qubit cap") {
+        SparseDensityMatrix capped("+++", 0.25, 0, 2);
+        SparseDensityMatrix allowed("+++", 0.25, 0, 3);
+        CHECK_FALSE(capped.IsDense());
+        CHECK(capped.DensePromotionSkipped());
+        CHECK_EQ(capped.Fill(), 1.0);
+        CHECK_THROWS_AS(capped.Dense(), std::invalid_argument);
+        CHECK(allowed.IsDense());
+        CHECK_FALSE(allowed.DensePromotionSkipped());
+        capped.ApplyCGate(GX, 0, 2);
+        allowed.ApplyCGate(GX, 0, 2);
+        CHECK_FALSE(capped.IsDense());
+        CHECK(approx_equal(capped.Probabilities(), allowed.Probabilities(),
+                           "absdiff", DEC14));
+    }
+    SUBCASE("Cutoff drops small entries") {
+        SparseDensityMatrix sparse("0", 1.0, 1e-3);
+        sparse.ApplyGate(RX(1), 0);
+        // sin^2(0.5 deg) ~ 7.6e-5 is below the cutoff
+        CHECK_EQ(sparse.NonZeros(), 3u);
+        CHECK_EQ(sparse.At(1, 1), cx_double(0, 0));
+    }
+}
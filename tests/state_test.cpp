@@ -0,0 +1,103 @@
+#include <dmqs/dmqs.hpp>
+#include <dmqs/state.hpp>
+#include <vector>
+#include <string>
+#include "doctest/doctest.h"
+
+#define EXACT 0.0
+#define DEC14 1e-14
+using namespace dmqs;
+
+TEST_CASE("State vector matches density matrix") {
+    for (string bin : {"0", "1", "+", "-", "01+", "-10"}) {
+        INFO(bin);
+        CHECK(mat_eq(State(bin).DensityMatrix(),
+                     BinaryStringToDensityMatrix(bin), DEC14));
+    }
+    State state("0+1");
+    cx_mat rho = BinaryStringToDensityMatrix("0+1");
+    state.ApplyGate(GH, 0);
+    rho = ApplyGate(rho, GH, 0);
+    state.ApplyCGate(GX, 1, 2);
+    rho = ApplyCGate(rho, GX, 1, 2);
+    state.ApplyRotation(GRY, 40, 2);
+    rho = ApplyRotation(rho, GRY, 40, 2);
+    state.ApplyCRotation(GRZ, -75, 0, 1);
+    rho = ApplyCRotation(rho, GRZ, -75, 0, 1);
+    state.ApplySwap(0, 2);
+    rho = ApplySwap(rho, 0, 2);
+    state.ApplyCGate(GZ, 2, 0);
+    rho = ApplyCGate(rho, GZ, 2, 0);
+    state.ApplyGate(P(30), 1);
+    ApplyGateInPlace(rho, P(30), 1);
+    CHECK(state.IsStateVector());
+    CHECK_EQ(state.VectorOperations(), 7);
+    CHECK_EQ(state.Promotions(), 0);
+    CHECK(mat_eq(state.DensityMatrix(), rho, DEC14));
+    CHECK(approx_equal(state.Probabilities(), Probabilities(rho), "absdiff",
+                       DEC14));
+    CHECK(IsPure(state.DensityMatrix(), DEC14));
+}
+
+TEST_CASE("State promotion") {
+    State state("+0");
+    state.ApplyCGate(GX, 0, 1);
+    SUBCASE("Unitary channels keep the state vector") {
+        state.ApplyChannel({X()}, 1);
+        CHECK(state.IsStateVector());
+        cx_mat rho = ApplyGate(ApplyCGate(BinaryStringToDensityMatrix("+0"),
+                                          GX, 0, 1), GX, 1);
+        CHECK(mat_eq(state.DensityMatrix(), rho, DEC14));
+    }
+    SUBCASE("First non unitary channel promotes") {
+        cx_mat rho = state.DensityMatrix();
+        vector<kraus_t> ops = amplitude_damping_ops(0.3);
+        state.ApplyChannel(ops, 0);
+        CHECK_FALSE(state.IsStateVector());
+        CHECK_EQ(state.Promotions(), 1);
+        rho = apply_channel(rho, ops, 0);
+        CHECK(mat_eq(state.DensityMatrix(), rho, DEC14));
+        state.ApplyAmplitudeDampeningAndDephasing(1, 10.0, 8.0, 2.0);
+        state.ApplyGate(GH, 1);
+        double T1[] = {1e300, 10.0};
+        double T2[] = {1e300, 8.0};
+        rho = ApplyGate(ApplyAmplitudeDampeningAndDephasing(rho, T1, T2, 2.0),
+                        GH, 1);
+        CHECK(mat_eq(state.DensityMatrix(), rho, DEC14));
+        CHECK_EQ(state.Promotions(), 1);
+        CHECK_EQ(state.VectorOperations(), 1);
+        CHECK_THROWS(state.StateVector());
+    }
+    SUBCASE("Invalid qubits do not promote") {
+        state.ApplyAmplitudeDampeningAndDephasing(0, 10.0, 8.0, 0.0);
+        CHECK_THROWS_AS(state.ApplyChannel(amplitude_damping_ops(0.3), 2),
+                        std::invalid_argument);
+        CHECK_THROWS_AS(
+            state.ApplyAmplitudeDampeningAndDephasing(-1, 10.0, 8.0, 2.0),
+            std::invalid_argument);
+        CHECK(state.IsStateVector());
+        CHECK_EQ(state.Promotions(), 0);
+    }
+}
+
+TEST_CASE("State measurement") {
+    for (double r : {0.1, 0.4, 0.6, 0.9}) {
+        State state("+-0");
+        state.ApplyCGate(GX, 0, 2);
+        cx_mat rho = state.DensityMatrix();
+        int expected = MeasureAndCollapse(rho, {0, 1}, r);
+        INFO("random ", r);
+        CHECK_EQ(state.MeasureAndCollapse({0, 1}, r), expected);
+        CHECK(state.IsStateVector());
+        CHECK(mat_eq(state.DensityMatrix(), rho, DEC14));
+        CHECK_EQ(norm(state.StateVector()), doctest::Approx(1.0));
+    }
+    State state("10");
+    state.Collapse({0}, 1);
+    CHECK(mat_eq(state.DensityMatrix(), BinaryStringToDensityMatrix("10"),
+                 EXACT));
+    CHECK_THROWS(state.Collapse({1}, 1));
+    CHECK_THROWS(state.MeasureAndCollapse({0}, 1.0));
+    CHECK_THROWS(State("0a"));
+    CHECK_THROWS(State(cx_vec(3, arma::fill::zeros)));
+}
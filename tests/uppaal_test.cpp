@@ -1,4 +1,5 @@
 #include <uppaal/uppaal.h>
+#include <cstdio>
 #include "doctest/doctest.h"
 #define EXACT 0.0
 #define DEC14 1e-14
@@ -466,3 +467,178 @@ TEST_CASE("Quantum Teleportation") {
     INFO("Final qubit:\n", qtele);
     CHECK(cmp(qpsi, qtele, 8, DEC14));
 }
+
+TEST_CASE("Apply Rotation") {
+    double rho[8] = {0};
+    double cb0[8] = {0};
+    double cb1[8] = {0};
+    InitBinState(rho, 1, "0");
+    InitBinState(cb0, 1, "0");
+    InitBinState(cb1, 1, "1");
+    ApplyRotation(rho, 1, GRX, 180, 0);
+    CHECK(cmp(rho, cb1, 8, DEC14));
+    ApplyRotation(rho, 1, GRY, 180, 0);
+    CHECK(cmp(rho, cb0, 8, DEC14));
+    double rho2[32] = {0};
+    double c11[32] = {0};
+    InitBinState(rho2, 2, "10");
+    InitBinState(c11, 2, "11");
+    ApplyCRotation(rho2, 2, GRY, 180, 0, 1);
+    CHECK(cmp(rho2, c11, 32, DEC14));
+}
+
+TEST_CASE("Measure Shots") {
+    double rho[32] = {0};
+    InitBinState(rho, 2, "+1");
+    int counts[4] = {0};
+    MeasureAllShots(rho, 2, counts, 4, 1000, 5);
+    CHECK_EQ(counts[0], 0);
+    CHECK_EQ(counts[2], 0);
+    CHECK_EQ(counts[1] + counts[3], 1000);
+    int targets[1] = {1};
+    int partial[2] = {0};
+    PartialMeasureShots(rho, 2, targets, 1, partial, 2, 1000, 5);
+    CHECK_EQ(partial[1], 1000);
+    CHECK_THROWS(MeasureAllShots(rho, 2, counts, 2, 1000, 5));
+}
+
+TEST_CASE("Measure And Collapse") {
+    int qc = 3;
+    double rho[128] = {0};
+    double expected[128] = {0};
+    InitBinState(rho, qc, "+01");
+    InitBinState(expected, qc, "101");
+    int targets[1] = {0};
+    CHECK_EQ(MeasureAndCollapse(rho, qc, targets, 1, 0.75), 1);
+    CHECK(cmp(rho, expected, 128, DEC14));
+    int all[3] = {0, 1, 2};
+    CHECK_EQ(MeasureAndCollapse(rho, qc, all, 3, 0.1), 5);
+    CHECK(cmp(rho, expected, 128, DEC14));
+}
+
+TEST_CASE("Flush Idle Noise") {
+    double eager[32] = {0};
+    double lazy[32] = {0};
+    InitBinState(eager, 2, "1+");
+    InitBinState(lazy, 2, "1+");
+    double T1[] = {10.0, 20.0};
+    double T2[] = {5.0, 15.0};
+    double pending[2] = {0};
+    for (int i = 0; i < 4; i++) {
+        AmplitudeDampeningAndDephasing(eager, 2, T1, T2, 0.25);
+        pending[0] += 0.25;
+        pending[1] += 0.25;
+    }
+    int targets[2] = {0, 1};
+    FlushIdleNoise(lazy, 2, T1, T2, pending, targets, 2);
+    CHECK(cmp(lazy, eager, 32, 1e-12));
+    CHECK_EQ(pending[0], 0.0);
+    CHECK_EQ(pending[1], 0.0);
+}
+
+TEST_CASE("Diagnostics") {
+    double bell[32] = {0};
+    double zero[32] = {0};
+    InitBinState(bell, 2, "00");
+    InitBinState(zero, 2, "00");
+    ApplyGate(bell, 2, 4, 0);
+    ApplyCGate(bell, 2, 1, 0, 1);
+    CHECK(std::abs(Purity(bell, 2) - 1) < 1e-12);
+    CHECK(std::abs(LinearEntropy(bell, 2)) < 1e-12);
+    CHECK(std::abs(VonNeumannEntropy(bell, 2)) < 1e-12);
+    CHECK(std::abs(Fidelity(bell, 2, zero, 2) - 0.5) < 1e-10);
+    CHECK(std::abs(TraceDistance(bell, 2, zero, 2) -
+                   std::sqrt(0.5)) < 1e-12);
+    double psi[8] = {1, 0, 0, 0, 0, 0, 0, 0};
+    CHECK(std::abs(PureFidelity(bell, 2, psi, 2) - 0.5) < 1e-12);
+}
+
+TEST_CASE("Run Circuit") {
+    double rho[32] = {0};
+    double expected[32] = {0};
+    InitBinState(rho, 2, "00");
+    InitBinState(expected, 2, "11");
+    const char* source = "OPENQASM 2.0; qreg q[2]; creg c[2];"
+                         "x q[0]; cx q[0], q[1]; measure q -> c;";
+    CHECK_EQ(RunCircuit(rho, 2, source, 1), 3);
+    CHECK(cmp(rho, expected, 32, DEC14));
+    CHECK_THROWS(RunCircuit(rho, 1, source, 1));
+    CHECK_THROWS(RunCircuit(rho, 2, "qreg q[2]; creg c[32];", 1));
+}
+
+TEST_CASE("Save and Load State") {
+    double rho[32] = {0};
+    double restored[32] = {0};
+    double small[8] = {0};
+    InitBinState(rho, 2, "+1");
+    ApplyChannel(rho, 2, 0, 0.3);
+    const char* path = "dmqs_uppaal_state.rho";
+    SaveState(rho, 2, path);
+    LoadState(restored, 2, path);
+    CHECK(cmp(rho, restored, 32, DEC14));
+    CHECK_THROWS(LoadState(small, 1, path));
+    std::remove(path);
+}
+
+TEST_CASE("State Handles") {
+    double rho[32] = {0};
+    double expected[32] = {0};
+    int state = CreateState(2, "");
+    CHECK(state != 0);
+    CHECK_EQ(StateQubits(state), 2);
+    StateApplyGate(state, 4, 0);
+    StateApplyCGate(state, 1, 0, 1);
+    int copy = CloneState(state);
+
+    InitBinState(expected, 2, "00");
+    ApplyGate(expected, 2, 4, 0);
+    ApplyCGate(expected, 2, 1, 0, 1);
+    StateReadDensityMatrix(state, rho, 2);
+    CHECK(cmp(rho, expected, 32, DEC14));
+
+    int targets[2] = {0, 1};
+    int outcome = StateMeasureAndCollapse(state, targets, 2, 0.75);
+    CHECK_EQ(outcome, 3);
+    CHECK_EQ(StateMeasureAll(state, 0.1), 3);
+    CHECK_EQ(StateMeasureAll(copy, 0.1), 0);
+
+    StateApplyChannel(copy, 0, 1.0, 0);
+    StateApplyChannel(copy, 0, 1.0, 1);
+    CHECK_EQ(StateMeasureAll(copy, 0.99), 0);
+
+    DestroyState(state);
+    DestroyState(copy);
+    CHECK_THROWS(StateQubits(state));
+    CHECK_THROWS(CreateState(3, "01"));
+}
+
+TEST_CASE("Loaded States Collapse Partners") {
+    double rho[32] = {0};
+    InitBinState(rho, 2, "+0");
+    ApplyCGate(rho, 2, 1, 0, 1);
+    const char* path = "dmqs_uppaal_bell.rho";
+    SaveState(rho, 2, path);
+    int state = StateLoad(path);
+    std::remove(path);
+    int partner[1] = {1};
+    int measured[1] = {0};
+    CHECK_EQ(StatePartialMeasure(state, partner, 1, 0.75), 1);
+    CHECK_EQ(StateMeasureAndCollapse(state, measured, 1, 0.25), 0);
+    CHECK_EQ(StatePartialMeasure(state, partner, 1, 0.75), 0);
+    DestroyState(state);
+}
+
+TEST_CASE("Execution Context") {
+    double rho[32] = {0};
+    double expected[32] = {0};
+    int cpus[1] = {0};
+    SetExecutionContext(1, 1, 0, cpus, 0);
+    CHECK_EQ(dmqs::CurrentExecutionContext().threads, 1);
+    InitBinState(rho, 2, "+0");
+    InitBinState(expected, 2, "+0");
+    ApplyChannel(rho, 2, 1, 0.0);
+    CHECK(cmp(rho, expected, 32, DEC14));
+    SetExecutionContext(0, 0, 1 << 14, cpus, 0);
+    CHECK_EQ(dmqs::CurrentExecutionContext().threads, 0);
+    CHECK_THROWS(SetExecutionContext(-1, 0, 0, cpus, 0));
+}
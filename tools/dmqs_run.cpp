@@ -0,0 +1,336 @@
+// dmqs_run: runs an OpenQASM 2 circuit file on an initial state and reports
+// per-phase timing, throughput and the final probabilities.
+//
+//   dmqs_run <circuit.qasm> <state> [options]
+//
+// <state> uses the BinaryStringToDensityMatrix syntax (0, 1, + and -).
+#include <dmqs/dmqs.hpp>
+#include <dmqs/qasm.hpp>
+#include <dmqs/state.hpp>
+#include <dmqs/lowrank.hpp>
+#include <dmqs/mpdo.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using dmqs::Circuit, dmqs::Operation, dmqs::OpKind, dmqs::RandomStream;
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    string circuit_file;
+    string state;
+    string backend = "dense";
+    int64_t repetitions = 1;
+    int64_t shots = 0;
+    int threads = 0;
+    uint64_t seed = 0;
+    bool optimize = true;
+    int top = 16;
+};
+
+static void Usage(const char* program) {
+    std::cerr
+        << "Usage: " << program << " <circuit.qasm> <state> [options]\n"
+        << "  <state>              Initial state, e.g. 0+1 (0, 1, + or -)\n"
+        << "  -r, --repetitions N  Run the circuit N times (default 1)\n"
+        << "  -s, --shots N        Sample the final state N times\n"
+        << "  -t, --threads N      OpenMP and OpenBLAS threads\n"
+        << "  -b, --backend NAME   dense, state, lowrank or mpdo\n"
+        << "      --seed N         Seed of the measurement streams\n"
+        << "      --no-optimize    Run the circuit as parsed\n"
+        << "      --top N          Print the N most likely outcomes\n";
+}
+
+static Options ParseOptions(int argc, char** argv) {
+    Options options;
+    vector<string> positional;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        auto value = [&]() -> string {
+            if (i + 1 >= argc) {
+                throw invalid_argument("Missing value for " + arg);
+            }
+            return argv[++i];
+        };
+        if (arg == "-r" || arg == "--repetitions") {
+            options.repetitions = std::stoll(value());
+        } else if (arg == "-s" || arg == "--shots") {
+            options.shots = std::stoll(value());
+        } else if (arg == "-t" || arg == "--threads") {
+            options.threads = std::stoi(value());
+        } else if (arg == "-b" || arg == "--backend") {
+            options.backend = value();
+        } else if (arg == "--seed") {
+            options.seed = std::stoull(value());
+        } else if (arg == "--top") {
+            options.top = std::stoi(value());
+        } else if (arg == "--no-optimize") {
+            options.optimize = false;
+        } else if (arg == "-h" || arg == "--help") {
+            Usage(argv[0]);
+            std::exit(0);
+        } else if (!arg.empty() && arg[0] == '-') {
+            throw invalid_argument("Unknown option " + arg);
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() != 2) {
+        throw invalid_argument("Expected a circuit file and a state");
+    }
+    if (options.repetitions < 1 || options.shots < 0 ||
+        options.threads < 0 || options.top < 0) {
+        throw invalid_argument("Counts must not be negative");
+    }
+    options.circuit_file = positional[0];
+    options.state = positional[1];
+    return options;
+}
+
+static double Seconds(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/// @brief Runs a circuit on one of the class backends, which share the
+///        State interface.
+template <typename Backend>
+static void RunOn(Backend& state, const Circuit& circuit, RandomStream& rng) {
+    for (const Operation& op : circuit.ops) {
+        const vector<int>& q = op.qubits;
+        switch (op.kind) {
+            case OpKind::GATE:
+                if (op.gate != GID) {
+                    state.ApplyGate(dmqs::OperationMatrix(op), q[0]);
+                }
+                break;
+            case OpKind::UNITARY:
+                state.ApplyGate(op.matrix, q[0]);
+                break;
+            case OpKind::CGATE:
+                state.ApplyCGate(op.gate, q[0], q[1]);
+                break;
+            case OpKind::ROTATION:
+                state.ApplyRotation(op.gate, op.param, q[0]);
+                break;
+            case OpKind::CROTATION:
+                state.ApplyCRotation(op.gate, op.param, q[0], q[1]);
+                break;
+            case OpKind::SWAP:
+                state.ApplySwap(q[0], q[1]);
+                break;
+            case OpKind::CHANNEL:
+                state.ApplyChannel(u_channel_to_ops_f(op.channel)(op.param),
+                                   q[0]);
+                break;
+            case OpKind::MEASURE:
+                state.MeasureAndCollapse(q, rng);
+                break;
+            case OpKind::RESET:
+                state.ApplyChannel(reset_ops(), q[0]);
+                break;
+            case OpKind::BARRIER:
+                break;
+        }
+    }
+}
+
+static vec FinalProbabilities(const cx_mat& rho) {
+    return dmqs::Probabilities(rho);
+}
+
+static vec FinalProbabilities(const dmqs::State& state) {
+    return state.Probabilities();
+}
+
+static vec FinalProbabilities(const dmqs::LowRankState& state) {
+    return state.Probabilities();
+}
+
+static vec FinalProbabilities(const dmqs::MPDO& state) {
+    return dmqs::Probabilities(state.DensityMatrix());
+}
+
+struct Timings {
+    double init = 0;
+    double run = 0;
+};
+
+/// @brief Runs every repetition from a fresh initial state, repetition r
+///        drawing from stream r so runs are reproducible.
+template <typename Backend, typename Make, typename Run>
+static vec Repeat(const Options& options, const Circuit& circuit,
+                  Make make, Run run, Timings& timings) {
+    std::unique_ptr<Backend> state;
+    for (int64_t r = 0; r < options.repetitions; r++) {
+        Clock::time_point start = Clock::now();
+        state = make();
+        timings.init += Seconds(start);
+        RandomStream rng(options.seed, r);
+        start = Clock::now();
+        run(*state, circuit, rng);
+        timings.run += Seconds(start);
+    }
+    return FinalProbabilities(*state);
+}
+
+static vec Execute(const Options& options, const Circuit& circuit,
+                   Timings& timings) {
+    const string& bin = options.state;
+    if (options.backend == "dense") {
+        return Repeat<cx_mat>(
+            options, circuit,
+            [&] {
+                return std::make_unique<cx_mat>(
+                    dmqs::BinaryStringToDensityMatrix(bin));
+            },
+            [](cx_mat& rho, const Circuit& c, RandomStream& rng) {
+                dmqs::RunCircuit(rho, c, rng);
+            },
+            timings);
+    }
+    if (options.backend == "state") {
+        return Repeat<dmqs::State>(
+            options, circuit,
+            [&] { return std::make_unique<dmqs::State>(bin); },
+            RunOn<dmqs::State>, timings);
+    }
+    if (options.backend == "lowrank") {
+        return Repeat<dmqs::LowRankState>(
+            options, circuit,
+            [&] { return std::make_unique<dmqs::LowRankState>(bin); },
+            RunOn<dmqs::LowRankState>, timings);
+    }
+    if (options.backend == "mpdo") {
+        return Repeat<dmqs::MPDO>(
+            options, circuit,
+            [&] { return std::make_unique<dmqs::MPDO>(bin); },
+            RunOn<dmqs::MPDO>, timings);
+    }
+    throw invalid_argument("Unknown backend " + options.backend);
+}
+
+static string Basis(uword index, int n) {
+    string bits(n, '0');
+    for (int q = 0; q < n; q++) {
+        if ((index >> (n - 1 - q)) & 1) {
+            bits[q] = '1';
+        }
+    }
+    return bits;
+}
+
+static void PrintTiming(const string& phase, double seconds) {
+    std::printf("  %-10s %12.6f s\n", phase.c_str(), seconds);
+}
+
+static int Main(int argc, char** argv) {
+    Options options = ParseOptions(argc, argv);
+    dmqs::ExecutionContext context;
+    context.threads = options.threads;
+    context.blas_threads = options.threads;
+    dmqs::SetExecutionContext(context);
+
+    Clock::time_point start = Clock::now();
+    std::ifstream file(options.circuit_file);
+    if (!file) {
+        throw invalid_argument("Cannot open " + options.circuit_file);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    double load = Seconds(start);
+
+    start = Clock::now();
+    dmqs::OptimizationStats stats;
+    Circuit parsed = dmqs::ParseQasm(buffer.str());
+    Circuit circuit = options.optimize
+                          ? dmqs::OptimizeCircuit(parsed, &stats)
+                          : parsed;
+    double compile = Seconds(start);
+    if (static_cast<int>(options.state.size()) != circuit.qubits) {
+        throw invalid_argument(
+            "State " + options.state + " does not have the " +
+            to_string(circuit.qubits) + " qubits of the circuit");
+    }
+
+    Timings timings;
+    vec probabilities = Execute(options, circuit, timings);
+
+    start = Clock::now();
+    vector<int64_t> counts;
+    if (options.shots > 0) {
+        dmqs::AliasTable table = dmqs::BuildAliasTable(probabilities);
+        RandomStream rng(options.seed, options.repetitions);
+        counts.assign(probabilities.n_elem, 0);
+        for (int64_t s = 0; s < options.shots; s++) {
+            counts[dmqs::SampleAlias(table, rng.Uniform(s, 0),
+                                     rng.Uniform(s, 1))]++;
+        }
+    }
+    double sample = Seconds(start);
+
+    std::printf("circuit    %s: %d qubits, %zu operations (%zu parsed, "
+                "%lld fused, %lld cancelled)\n",
+                options.circuit_file.c_str(), circuit.qubits,
+                circuit.ops.size(), parsed.ops.size(),
+                static_cast<long long>(stats.fused),
+                static_cast<long long>(stats.cancelled));
+    std::printf("backend    %s, %lld repetitions, %lld shots, %d threads\n",
+                options.backend.c_str(),
+                static_cast<long long>(options.repetitions),
+                static_cast<long long>(options.shots),
+                dmqs::LibraryThreads());
+    std::printf("timing\n");
+    PrintTiming("load", load);
+    PrintTiming("compile", compile);
+    PrintTiming("init", timings.init);
+    PrintTiming("run", timings.run);
+    PrintTiming("sample", sample);
+    double operations = static_cast<double>(circuit.ops.size()) *
+                        options.repetitions;
+    std::printf("throughput\n");
+    std::printf("  %12.2f repetitions/s\n",
+                options.repetitions / timings.run);
+    std::printf("  %12.2f operations/s\n", operations / timings.run);
+    if (options.shots > 0) {
+        std::printf("  %12.2f shots/s\n", options.shots / sample);
+    }
+
+    vector<uword> order(probabilities.n_elem);
+    for (uword i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    size_t top = std::min<size_t>(options.top, order.size());
+    std::partial_sort(order.begin(), order.begin() + top, order.end(),
+                      [&probabilities](uword a, uword b) {
+                          return probabilities(a) > probabilities(b);
+                      });
+    std::printf("probabilities (last repetition)\n");
+    for (size_t k = 0; k < top && probabilities(order[k]) > 0; k++) {
+        uword i = order[k];
+        std::printf("  |%s>  %.12f", Basis(i, circuit.qubits).c_str(),
+                    probabilities(i));
+        if (!counts.empty()) {
+            std::printf("  %lld", static_cast<long long>(counts[i]));
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    try {
+        return Main(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "dmqs_run: " << e.what() << "\n";
+        Usage(argv[0]);
+        return 1;
+    }
+}